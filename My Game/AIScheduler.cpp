@@ -0,0 +1,74 @@
+/// \file AIScheduler.cpp
+/// \brief Code for the enemy decision scheduler CAIScheduler.
+
+#include <algorithm>
+
+#include "AIScheduler.h"
+#include "Object.h"
+
+/// Put an enemy at the back of the queue.
+/// \param p Pointer to the enemy.
+
+void CAIScheduler::Add(CObject* p){
+  m_dQueue.push_back(p);
+} //Add
+
+/// Take the enemies whose turn it is this tick off the front of the
+/// queue, as many as the budget allows. Enemies that have died since
+/// they were queued are skipped. Any that are to have another turn
+/// must be put back with Add(), and they go after everyone else.
+/// \param turns [out] Enemies whose turn it is, in order.
+
+void CAIScheduler::Turns(vector<CObject*>& turns){
+  turns.clear();
+
+  while(turns.size() < m_nBudget && !m_dQueue.empty()){
+    CObject* p = m_dQueue.front();
+    m_dQueue.pop_front();
+
+    if(!p->IsDead())
+      turns.push_back(p);
+  } //while
+} //Turns
+
+/// Remove enemies that have died.
+
+void CAIScheduler::DropDead(){
+  m_dQueue.erase(remove_if(m_dQueue.begin(), m_dQueue.end(),
+    [](CObject* p){return p->IsDead();}), m_dQueue.end());
+} //DropDead
+
+/// Remove all enemies.
+
+void CAIScheduler::Clear(){
+  m_dQueue.clear();
+} //Clear
+
+/// Set the most turns to give out in one tick.
+/// \param n Number of turns, at least 1.
+
+void CAIScheduler::SetBudget(UINT n){
+  m_nBudget = max(n, 1U);
+} //SetBudget
+
+/// Reader function for the most turns given out in one tick.
+/// \return Number of turns.
+
+UINT CAIScheduler::GetBudget() const{
+  return m_nBudget;
+} //GetBudget
+
+/// Reader function for the number of enemies waiting.
+/// \return Number of enemies in the queue.
+
+UINT CAIScheduler::GetSize() const{
+  return (UINT)m_dQueue.size();
+} //GetSize
+
+/// Reader function for an enemy in the queue.
+/// \param i Place in the queue, 0 for the next one.
+/// \return Pointer to the enemy.
+
+CObject* CAIScheduler::Get(UINT i) const{
+  return m_dQueue[i];
+} //Get
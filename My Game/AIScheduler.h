@@ -0,0 +1,49 @@
+/// \file AIScheduler.h
+/// \brief Interface for the enemy decision scheduler CAIScheduler.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+class CObject;
+
+/// \brief Takes turns for enemies that are waiting to decide something.
+///
+/// An enemy whose gun has cooled down has to decide each tick whether
+/// a player is close enough to shoot at. Rather than every one of them
+/// deciding every tick, they queue up here and take turns, and no more
+/// than a fixed budget of them get a turn each tick. An enemy that does
+/// not act on its turn goes to the back of the queue. While there are
+/// no more of them than the budget, each gets a turn every tick, just as
+/// if they all decided for themselves. When there are more, they are
+/// spread round-robin over the next few ticks, so the cost of a tick
+/// stays the same however many enemies there are.
+///
+/// The object manager must call DropDead() before it deletes dead
+/// objects, and Clear() when it deletes all of them.
+
+class CAIScheduler{
+  public:
+    static const UINT DEFAULT_BUDGET = 32; ///< Default number of turns per tick.
+
+  private:
+    deque<CObject*> m_dQueue; ///< Enemies waiting for a turn, next first.
+    UINT m_nBudget = DEFAULT_BUDGET; ///< Most turns per tick.
+
+  public:
+    void Add(CObject* p); ///< Queue an enemy for a turn.
+    void Turns(vector<CObject*>& turns); ///< Take this tick's turns.
+    void DropDead(); ///< Remove dead enemies.
+    void Clear(); ///< Remove all enemies.
+
+    void SetBudget(UINT n); ///< Set the number of turns per tick.
+    UINT GetBudget() const; ///< Get the number of turns per tick.
+
+    UINT GetSize() const; ///< Number of enemies waiting.
+    CObject* Get(UINT i) const; ///< Enemy waiting in some place.
+}; //CAIScheduler
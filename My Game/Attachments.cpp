@@ -0,0 +1,190 @@
+/// \file Attachments.cpp
+/// \brief Code for the parent and child attachments CAttachments.
+
+#include <algorithm>
+
+#include "Attachments.h"
+#include "Object.h"
+
+/// Find the link that attaches a child to its parent.
+/// \param child Pointer to an object.
+/// \return Link number, or -1 if the object is not attached to anything.
+
+int CAttachments::Find(const CObject* child) const{
+  for(size_t i=0; i<m_vLinks.size(); i++)
+    if(m_vLinks[i].m_pChild == child)
+      return (int)i;
+
+  return -1;
+} //Find
+
+/// Work out the depth of each link by following parents up to an
+/// object that is not a child, then sort the links by depth. The sort
+/// is stable, so links of the same depth stay in the order they were made.
+
+void CAttachments::Order(){
+  for(auto& k: m_vLinks){
+    k.m_nDepth = 0;
+
+    for(int j=Find(k.m_pParent); j>=0; j=Find(m_vLinks[j].m_pParent))
+      k.m_nDepth++;
+  } //for
+
+  stable_sort(m_vLinks.begin(), m_vLinks.end(),
+    [](const Link& a, const Link& b){return a.m_nDepth < b.m_nDepth;});
+} //Order
+
+/// Attach a child to a parent, detaching it from any parent it already
+/// has. A child cannot be attached to itself or to one of its own
+/// children, since then the positions could never be resolved.
+/// \param child Pointer to the child.
+/// \param parent Pointer to the parent.
+/// \param offset Child's position relative to the parent.
+/// \return true if the child was attached.
+
+bool CAttachments::Attach(CObject* child, CObject* parent, const Vector2& offset){
+  if(child == nullptr || parent == nullptr)return false;
+
+  for(const CObject* p=parent; p; ){ //look for the child above the parent
+    if(p == child)return false;
+    const int j = Find(p);
+    p = j >= 0? m_vLinks[j].m_pParent: nullptr;
+  } //for
+
+  Detach(child);
+  m_vLinks.push_back({child, parent, offset, 0});
+  Order();
+
+  return true;
+} //Attach
+
+/// Detach a child from its parent, leaving it where it is. Its own
+/// children stay attached to it.
+/// \param child Pointer to the child.
+
+void CAttachments::Detach(CObject* child){
+  const int i = Find(child);
+  if(i < 0)return;
+
+  m_vLinks.erase(m_vLinks.begin() + i);
+  Order();
+} //Detach
+
+/// Reader function for the parent of a child.
+/// \param child Pointer to an object.
+/// \return Pointer to its parent, or nullptr if it is not attached.
+
+CObject* CAttachments::GetParent(const CObject* child) const{
+  const int i = Find(child);
+  return i >= 0? m_vLinks[i].m_pParent: nullptr;
+} //GetParent
+
+/// Put every child at its parent's position plus its offset. Parents
+/// come before their children, so a parent has already been put in
+/// place by the time its children are.
+
+void CAttachments::Resolve(){
+  for(auto const& k: m_vLinks){
+    k.m_pChild->m_vPos = k.m_pParent->m_vPos + k.m_vOffset;
+    k.m_pChild->UpdatePos();
+  } //for
+} //Resolve
+
+/// Remove the links of dead children and of children whose parent has
+/// died. A child whose parent died is left where it is.
+
+void CAttachments::DropDead(){
+  const size_t n = m_vLinks.size();
+
+  m_vLinks.erase(remove_if(m_vLinks.begin(), m_vLinks.end(),
+    [](const Link& k){return k.m_pChild->IsDead() || k.m_pParent->IsDead();}),
+    m_vLinks.end());
+
+  if(m_vLinks.size() < n)
+    Order();
+} //DropDead
+
+/// Remove all links.
+
+void CAttachments::Clear(){
+  m_vLinks.clear();
+} //Clear
+
+/// Reader function for the number of links.
+/// \return Number of links.
+
+UINT CAttachments::GetSize() const{
+  return (UINT)m_vLinks.size();
+} //GetSize
+
+/// Reader function for the child of a link.
+/// \param i Link number.
+/// \return Pointer to the child.
+
+CObject* CAttachments::GetChild(UINT i) const{
+  return m_vLinks[i].m_pChild;
+} //GetChild
+
+/// Reader function for the parent of a link.
+/// \param i Link number.
+/// \return Pointer to the parent.
+
+CObject* CAttachments::GetParent(UINT i) const{
+  return m_vLinks[i].m_pParent;
+} //GetParent
+
+/// Hash the links. Their objects are left to the object manager,
+/// since they are pointers.
+/// \param hash The hash.
+
+void CAttachments::Hash(CStateHash& hash) const{
+  hash.Add(GetSize());
+
+  for(auto const& k: m_vLinks){
+    hash.Add(k.m_vOffset);
+    hash.Add(k.m_nDepth);
+  } //for
+} //Hash
+
+/// Save the links. Their objects are left to the object manager,
+/// since they are pointers.
+/// \param s The snapshot.
+
+void CAttachments::Save(CSnapshot& s) const{
+  s.Write(GetSize());
+
+  for(auto const& k: m_vLinks){
+    s.Write(k.m_vOffset);
+    s.Write(k.m_nDepth);
+  } //for
+} //Save
+
+/// Load the links. Their objects are all nullptr until the
+/// object manager sets them.
+/// \param s The snapshot.
+/// \return false if the snapshot is too short for the number of links.
+
+bool CAttachments::Load(CSnapshot& s){
+  UINT n = 0;
+  s.Read(n);
+  if(n > s.GetRemaining()/(sizeof(Vector2) + sizeof(UINT)))return false; //more links than there is data for
+
+  m_vLinks.assign(n, {nullptr, nullptr, Vector2::Zero, 0});
+
+  for(auto& k: m_vLinks){
+    s.Read(k.m_vOffset);
+    s.Read(k.m_nDepth);
+  } //for
+
+  return true;
+} //Load
+
+/// Set the objects of a link, for reconnecting links after a load.
+/// \param i Link number.
+/// \param child Pointer to the child.
+/// \param parent Pointer to the parent.
+
+void CAttachments::SetObjects(UINT i, CObject* child, CObject* parent){
+  m_vLinks[i].m_pChild = child;
+  m_vLinks[i].m_pParent = parent;
+} //SetObjects
@@ -0,0 +1,63 @@
+/// \file Attachments.h
+/// \brief Interface for the parent and child attachments CAttachments.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "StateHash.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+class CObject;
+
+/// \brief Objects attached to other objects.
+///
+/// A child object, such as a boss's force field, an orbiting option or
+/// one part of a multi-part boss, is attached to a parent at an offset
+/// from it. Children do not have to follow their parents around
+/// themselves. Instead, after everything has moved, Resolve() puts each
+/// child at its parent's position plus its offset in one pass. A child
+/// can be the parent of another child, so the links are kept in order
+/// of depth, parents before their children, and one pass down the array
+/// is enough however deep the attachments go.
+///
+/// Only a few objects are ever attached, so the links are kept here
+/// rather than in every object. The object manager must call DropDead()
+/// before it deletes dead objects, and Clear() when it deletes all of them.
+
+class CAttachments{
+  private:
+    /// \brief A child attached to a parent.
+
+    struct Link{
+      CObject* m_pChild; ///< Child.
+      CObject* m_pParent; ///< Parent.
+      Vector2 m_vOffset; ///< Child's position relative to its parent.
+      UINT m_nDepth; ///< Number of links above this one, 0 if the parent is not a child.
+    }; //Link
+
+    vector<Link> m_vLinks; ///< Links, parents before their children.
+
+    int Find(const CObject* child) const; ///< Find a child's link.
+    void Order(); ///< Put parents before their children.
+
+  public:
+    bool Attach(CObject* child, CObject* parent, const Vector2& offset); ///< Attach a child to a parent.
+    void Detach(CObject* child); ///< Detach a child from its parent.
+    CObject* GetParent(const CObject* child) const; ///< Parent of a child.
+    void Resolve(); ///< Move every child to its parent.
+    void DropDead(); ///< Remove links to dead objects.
+    void Clear(); ///< Remove all links.
+
+    UINT GetSize() const; ///< Number of links.
+    CObject* GetChild(UINT i) const; ///< Child of a link.
+    CObject* GetParent(UINT i) const; ///< Parent of a link.
+
+    void Hash(CStateHash& hash) const; ///< Hash link state.
+    void Save(CSnapshot& s) const; ///< Save link state, not including objects.
+    bool Load(CSnapshot& s); ///< Load link state, not including objects.
+    void SetObjects(UINT i, CObject* child, CObject* parent); ///< Set the objects of a link.
+}; //CAttachments
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Object.h"
 
 class BlackJack : public CObject 
@@ -9,4 +11,7 @@ private:
 		virtual void move(); //Blackjack is moving
 		virtual CObject* FireGun(); //BlackJack is shooting
 		void Respawn(bool b); //BlackJack repositions
+		virtual void Hash(CStateHash& hash); //hash simulation state
+		virtual void Save(CSnapshot& s); //save simulation state
+		virtual bool Load(CSnapshot& s); //load simulation state
 };
@@ -0,0 +1,108 @@
+/// \file BulletArray.cpp
+/// \brief Code for the packed bullet arrays CBulletArray.
+
+#include "BulletArray.h"
+
+/// Add a bullet to the end of the arrays.
+/// \param pos Position.
+/// \param v Velocity.
+/// \param w Sprite width.
+/// \param h Sprite height.
+/// \param edge What happens to it at the edge of the world.
+
+void CBulletArray::Add(const Vector2& pos, const Vector2& v, float w, float h, eEdgeRule edge){
+  m_vX.push_back(pos.x); m_vY.push_back(pos.y);
+  m_vVX.push_back(v.x); m_vVY.push_back(v.y);
+  m_vW.push_back(w); m_vH.push_back(h);
+  m_vEdge.push_back(edge);
+  m_vOut.push_back(0);
+} //Add
+
+/// Remove bullets, keeping the rest in order, in a single pass.
+/// \param gone Indices of the bullets to remove, in increasing order.
+
+void CBulletArray::Remove(const vector<UINT>& gone){
+  if(gone.empty())return;
+
+  const UINT n = (UINT)m_vX.size();
+  UINT k = gone[0]; //next free slot
+  size_t g = 0; //next index in gone
+
+  for(UINT i=gone[0]; i<n; i++){
+    if(g < gone.size() && gone[g] == i){g++; continue;}
+
+    m_vX[k] = m_vX[i]; m_vY[k] = m_vY[i];
+    m_vVX[k] = m_vVX[i]; m_vVY[k] = m_vVY[i];
+    m_vW[k] = m_vW[i]; m_vH[k] = m_vH[i];
+    m_vEdge[k] = m_vEdge[i];
+    m_vOut[k] = m_vOut[i];
+    k++;
+  } //for
+
+  m_vX.resize(k); m_vY.resize(k);
+  m_vVX.resize(k); m_vVY.resize(k);
+  m_vW.resize(k); m_vH.resize(k);
+  m_vEdge.resize(k);
+  m_vOut.resize(k);
+} //Remove
+
+/// Remove all bullets. The arrays keep their capacity.
+
+void CBulletArray::Clear(){
+  m_vX.clear(); m_vY.clear();
+  m_vVX.clear(); m_vVY.clear();
+  m_vW.clear(); m_vH.clear();
+  m_vEdge.clear();
+  m_vOut.clear();
+} //Clear
+
+/// Move a range of bullets for one tick and test them against the
+/// edge of the world, using the same tests as CObjectManager does for
+/// other objects. Ranges that do not overlap can be moved in parallel.
+/// \param begin Index of the first bullet.
+/// \param end Index one past the last bullet.
+/// \param dt Length of the tick in seconds.
+/// \param world Size of the world.
+
+void CBulletArray::Move(UINT begin, UINT end, float dt, const Vector2& world){
+  float* const x = m_vX.data(); float* const y = m_vY.data();
+  const float* const vx = m_vVX.data(); const float* const vy = m_vVY.data();
+  const float* const w = m_vW.data(); const float* const h = m_vH.data();
+  const UINT* const edge = m_vEdge.data();
+  UINT* const out = m_vOut.data();
+
+  for(UINT i=begin; i<end; i++){ //move
+    x[i] += vx[i]*dt;
+    y[i] += vy[i]*dt;
+  } //for
+
+  for(UINT i=begin; i<end; i++){ //test against the edge
+    const bool top = y[i] >= world.y;
+    const bool any = x[i] + w[i] < 0 || x[i] - w[i] > world.x || y[i] + h[i] < 0;
+    out[i] = (edge[i] == TOP_EDGE && top) || (edge[i] == ANY_EDGE && any);
+  } //for
+} //Move
+
+/// Reader function for the position of a bullet.
+/// \param i Bullet number.
+/// \return Position.
+
+Vector2 CBulletArray::GetPos(UINT i) const{
+  return Vector2(m_vX[i], m_vY[i]);
+} //GetPos
+
+/// Reader function for whether a bullet reached the edge of the world
+/// the last time that it was moved.
+/// \param i Bullet number.
+/// \return true if it should be killed.
+
+bool CBulletArray::IsOut(UINT i) const{
+  return m_vOut[i] != 0;
+} //IsOut
+
+/// Reader function for the number of bullets.
+/// \return Number of bullets.
+
+UINT CBulletArray::GetSize() const{
+  return (UINT)m_vX.size();
+} //GetSize
@@ -0,0 +1,51 @@
+/// \file BulletArray.h
+/// \brief Interface for the packed bullet arrays CBulletArray.
+
+#pragma once
+
+#include <vector>
+
+#include "GameDefines.h"
+
+using namespace std;
+
+/// \brief Bullets packed for moving.
+///
+/// Bullets far outnumber everything else, and all they do is fly in a
+/// straight line until they leave the world. CBulletArray keeps the
+/// position and velocity of every bullet in the bullet archetype in
+/// separate arrays of floats, in the same order as the archetype, so
+/// that moving them and testing them against the edge of the world runs
+/// straight through memory without touching the objects. The object
+/// manager then copies the new positions into the objects, where
+/// everything else reads them.
+///
+/// A bullet's velocity never changes once it has been fired, and nothing
+/// but the bullet system moves it, so its position and velocity are
+/// copied in when it joins the archetype and the arrays are the only
+/// place that they are read from after that. Bullets must not be
+/// attached to other objects. The object manager
+/// must Remove() bullets when it takes them out of the archetype, and
+/// Clear() when it empties it.
+
+class CBulletArray{
+  private:
+    vector<float> m_vX; ///< Position x.
+    vector<float> m_vY; ///< Position y.
+    vector<float> m_vVX; ///< Velocity x.
+    vector<float> m_vVY; ///< Velocity y.
+    vector<float> m_vW; ///< Sprite width, for the edge test.
+    vector<float> m_vH; ///< Sprite height, for the edge test.
+    vector<UINT> m_vEdge; ///< Edge rule.
+    vector<UINT> m_vOut; ///< Whether each bullet has reached the edge, set by Move().
+
+  public:
+    void Add(const Vector2& pos, const Vector2& v, float w, float h, eEdgeRule edge); ///< Add a bullet.
+    void Remove(const vector<UINT>& gone); ///< Remove bullets.
+    void Clear(); ///< Remove all bullets.
+
+    void Move(UINT begin, UINT end, float dt, const Vector2& world); ///< Move a range of bullets.
+    Vector2 GetPos(UINT i) const; ///< Position of a bullet.
+    bool IsOut(UINT i) const; ///< Whether a bullet has reached the edge.
+    UINT GetSize() const; ///< Number of bullets.
+}; //CBulletArray
@@ -0,0 +1,221 @@
+/// \file Chain.cpp
+/// \brief Code for the absorption and chain scorer CChain.
+
+#include <algorithm>
+
+#include "Chain.h"
+
+static const int ABSORB_POINTS = 10; ///< Points for each shot absorbed.
+static const int GRAZE_POINTS = 5; ///< Points for each shot grazed.
+static const int LINK_POINTS = 100; ///< Points for the first link in a chain.
+static const int MAX_DOUBLINGS = 8; ///< Link points stop doubling after this many links.
+static const int LINK_LENGTH = 3; ///< Kills of one color in a link.
+
+/// Add an event to the log.
+/// \param t Event type.
+/// \param player Player number.
+/// \param value Count, color, or chain length.
+
+void CChain::Log(eChainEvent t, UINT player, UINT value){
+  m_vEvents.push_back({(BYTE)t, (BYTE)player, (UINT16)min(value, 0xFFFFU)});
+} //Log
+
+/// Report shots absorbed by a player. This only counts them,
+/// they are scored in Tick().
+/// \param player Player number, 0 or 1.
+/// \param count Number of shots absorbed.
+
+void CChain::Absorb(UINT player, UINT count){
+  m_nAbsorbed[player] += count;
+} //Absorb
+
+/// Report shots grazed by a player. This only counts them,
+/// they are scored in Tick().
+/// \param player Player number, 0 or 1.
+/// \param count Number of shots grazed.
+
+void CChain::Graze(UINT player, UINT count){
+  m_nGrazed[player] += count;
+} //Graze
+
+/// Report a colored enemy killed. Kills are kept in order
+/// and scored in Tick(), since the order decides the links.
+/// \param player Number of the player who killed it, 0 or 1.
+/// \param color Enemy color, 'r' or 'b'.
+
+void CChain::Kill(UINT player, char color){
+  m_vKills.push_back({player, color});
+} //Kill
+
+/// Score everything reported this tick. Absorbed and grazed shots score
+/// a fixed amount each and charge energy, so they are scored by count. Kills
+/// are run through in order, building links of three of the same color
+/// in the chain of the player who made each kill. A link that is
+/// interrupted by the other color breaks that player's chain.
+/// \return Points scored this tick.
+
+int CChain::Tick(){
+  int points = 0;
+
+  for(UINT i=0; i<2; i++){ //absorption and grazing
+    const UINT n = m_nAbsorbed[i];
+    const UINT g = m_nGrazed[i];
+    if(n == 0 && g == 0)continue;
+
+    const bool full = m_nEnergy[i] == MAX_ENERGY;
+    points += ABSORB_POINTS*(int)n + GRAZE_POINTS*(int)g;
+    m_nEnergy[i] = min((int)MAX_ENERGY, m_nEnergy[i] + (int)(n + g));
+    m_nAbsorbed[i] = m_nGrazed[i] = 0;
+
+    if(n > 0)Log(CHAIN_ABSORB, i, n);
+    if(g > 0)Log(CHAIN_GRAZE, i, g);
+
+    if(!full && m_nEnergy[i] == MAX_ENERGY)
+      Log(CHAIN_CHARGED, i, MAX_ENERGY);
+  } //for
+
+  for(auto const& k: m_vKills){ //chains
+    const UINT i = k.first; //player
+    const char c = k.second; //color
+    Log(CHAIN_KILL, i, (UINT)c);
+
+    if(m_nLink[i] > 0 && c != m_cColor[i]){ //link interrupted
+      if(m_nChain[i] > 0)
+        Log(CHAIN_BREAK, i, m_nChain[i]);
+
+      m_nChain[i] = 0;
+      m_nLink[i] = 0;
+    } //if
+
+    m_cColor[i] = c;
+
+    if(++m_nLink[i] == LINK_LENGTH){ //link completed
+      m_nLink[i] = 0;
+      m_nChain[i]++;
+      points += LINK_POINTS << min(m_nChain[i] - 1, MAX_DOUBLINGS);
+      Log(CHAIN_LINK, i, m_nChain[i]);
+    } //if
+  } //for
+
+  m_vKills.clear();
+  return points;
+} //Tick
+
+/// Start again with no chains and no energy. The event log is kept.
+
+void CChain::Reset(){
+  m_cColor[0] = m_cColor[1] = 0;
+  m_nLink[0] = m_nLink[1] = 0;
+  m_nChain[0] = m_nChain[1] = 0;
+  m_nEnergy[0] = m_nEnergy[1] = 0;
+  m_nAbsorbed[0] = m_nAbsorbed[1] = 0;
+  m_nGrazed[0] = m_nGrazed[1] = 0;
+  m_vKills.clear();
+} //Reset
+
+/// Reader function for a player's chain length.
+/// \param player Player number, 0 or 1.
+/// \return Number of links in the player's current chain.
+
+int CChain::GetChain(UINT player) const{
+  return m_nChain[player];
+} //GetChain
+
+/// Reader function for a player's energy.
+/// \param player Player number, 0 or 1.
+/// \return Absorbed energy, up to MAX_ENERGY.
+
+int CChain::GetEnergy(UINT player) const{
+  return m_nEnergy[player];
+} //GetEnergy
+
+/// Use up some of a player's energy, if they have enough.
+/// \param player Player number, 0 or 1.
+/// \param energy Amount of energy needed.
+/// \return true if the player had enough and it was used up.
+
+bool CChain::Spend(UINT player, int energy){
+  if(m_nEnergy[player] < energy)return false;
+  m_nEnergy[player] -= energy;
+  return true;
+} //Spend
+
+/// Reader function for the event log.
+/// \return Events since the log was last cleared, oldest first.
+
+const vector<ChainEvent>& CChain::GetEvents() const{
+  return m_vEvents;
+} //GetEvents
+
+/// Empty the event log. The game does this once it has looked
+/// at a frame's events.
+
+void CChain::ClearEvents(){
+  m_vEvents.clear();
+} //ClearEvents
+
+/// Discard the events logged after the first few, for when the
+/// ticks that logged them are rolled back and simulated again.
+/// \param n Number of events to keep.
+
+void CChain::TruncateEvents(size_t n){
+  if(n < m_vEvents.size())
+    m_vEvents.resize(n);
+} //TruncateEvents
+
+/// Hash the chain state. The event log is not simulation state.
+/// \param hash The hash.
+
+void CChain::Hash(CStateHash& hash) const{
+  for(UINT i=0; i<2; i++){
+    hash.Add(m_cColor[i]);
+    hash.Add(m_nLink[i]);
+    hash.Add(m_nChain[i]);
+  } //for
+
+  hash.Add(m_nEnergy[0]);
+  hash.Add(m_nEnergy[1]);
+} //Hash
+
+/// Save the chain state.
+/// \param s The snapshot.
+
+void CChain::Save(CSnapshot& s) const{
+  for(UINT i=0; i<2; i++){
+    s.Write(m_cColor[i]);
+    s.Write(m_nLink[i]);
+    s.Write(m_nChain[i]);
+  } //for
+
+  s.Write(m_nEnergy[0]);
+  s.Write(m_nEnergy[1]);
+} //Save
+
+/// Load the chain state. Anything reported but not yet scored
+/// belongs to a tick that is being thrown away. The chain length is
+/// used as a shift when scoring, so a negative one is rejected along
+/// with links, energies, and colors that play could not have made.
+/// \param s The snapshot.
+/// \return false if the state was not valid.
+
+bool CChain::Load(CSnapshot& s){
+  for(UINT i=0; i<2; i++){
+    s.Read(m_cColor[i]);
+    s.Read(m_nLink[i]);
+    s.Read(m_nChain[i]);
+
+    if(m_cColor[i] != 0 && m_cColor[i] != 'r' && m_cColor[i] != 'b')return false;
+    if(m_nLink[i] < 0 || m_nLink[i] >= LINK_LENGTH || m_nChain[i] < 0)return false;
+  } //for
+
+  s.Read(m_nEnergy[0]);
+  s.Read(m_nEnergy[1]);
+
+  for(UINT i=0; i<2; i++)
+    if(m_nEnergy[i] < 0 || m_nEnergy[i] > MAX_ENERGY)return false;
+
+  m_nAbsorbed[0] = m_nAbsorbed[1] = 0;
+  m_nGrazed[0] = m_nGrazed[1] = 0;
+  m_vKills.clear();
+  return true;
+} //Load
@@ -0,0 +1,87 @@
+/// \file Chain.h
+/// \brief Interface for the absorption and chain scorer CChain.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "StateHash.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+/// \brief Chain event type.
+
+enum eChainEvent{
+  CHAIN_ABSORB, ///< A player absorbed shots, value is how many.
+  CHAIN_KILL, ///< A colored enemy was killed, value is its color.
+  CHAIN_LINK, ///< A chain link was completed, value is the chain length.
+  CHAIN_BREAK, ///< The chain was broken, value is the chain length lost.
+  CHAIN_CHARGED, ///< A player's energy reached the maximum.
+  CHAIN_GRAZE ///< A player grazed shots, value is how many.
+}; //eChainEvent
+
+/// \brief One entry in the chain event log, four bytes long.
+
+struct ChainEvent{
+  BYTE m_nType; ///< Event type, an eChainEvent.
+  BYTE m_nPlayer; ///< Player number, 0 or 1.
+  UINT16 m_nValue; ///< Count, color or chain length, depending on the type.
+}; //ChainEvent
+
+/// \brief The absorption and chain scorer.
+///
+/// Shots of a ship's own color are absorbed. Each one scores
+/// a few points and charges that player's energy for a counter-attack.
+/// Killing three enemies of the same color in a row completes
+/// a chain link. Each link in an unbroken chain is worth twice
+/// the one before, up to a cap, and a kill of the other color
+/// part way through a link breaks the chain. Each player builds their
+/// own chain from their own kills. Shots that pass close
+/// to a ship without hitting it are grazed, which scores and charges
+/// energy too.
+///
+/// The collision code only reports how many shots each player absorbed
+/// or grazed and who killed which colors in which order. Scoring happens once per
+/// tick in Tick(), so absorbing hundreds of shots in one tick costs
+/// a multiply rather than hundreds of score updates and sounds. Everything
+/// that happens goes into a small event log, which is kept until the
+/// game has looked at it.
+
+class CChain{
+  public:
+    static const int MAX_ENERGY = 120; ///< Most energy a player can hold.
+
+  private:
+    char m_cColor[2] = {0, 0}; ///< Color of each player's link being built, 'r', 'b', or 0 for none.
+    int m_nLink[2] = {0, 0}; ///< Kills of that color so far in each player's link.
+    int m_nChain[2] = {0, 0}; ///< Links completed in a row by each player.
+    int m_nEnergy[2] = {0, 0}; ///< Absorbed energy for each player.
+
+    UINT m_nAbsorbed[2] = {0, 0}; ///< Shots absorbed by each player this tick.
+    UINT m_nGrazed[2] = {0, 0}; ///< Shots grazed by each player this tick.
+    vector<pair<UINT, char>> m_vKills; ///< Player and enemy color of each kill this tick, in order.
+    vector<ChainEvent> m_vEvents; ///< Events since the log was last cleared.
+
+    void Log(eChainEvent t, UINT player, UINT value); ///< Add an event to the log.
+
+  public:
+    void Absorb(UINT player, UINT count); ///< Report absorbed shots.
+    void Graze(UINT player, UINT count); ///< Report grazed shots.
+    void Kill(UINT player, char color); ///< Report a colored enemy killed.
+    int Tick(); ///< Score this tick.
+    void Reset(); ///< Start again with no chain and no energy.
+
+    int GetChain(UINT player) const; ///< Number of links in a player's current chain.
+    int GetEnergy(UINT player) const; ///< Player's absorbed energy.
+    bool Spend(UINT player, int energy); ///< Use up some energy.
+
+    const vector<ChainEvent>& GetEvents() const; ///< Event log.
+    void ClearEvents(); ///< Empty the event log.
+    void TruncateEvents(size_t n); ///< Discard all but the oldest events.
+
+    void Hash(CStateHash& hash) const; ///< Hash chain state.
+    void Save(CSnapshot& s) const; ///< Save chain state.
+    bool Load(CSnapshot& s); ///< Load chain state.
+}; //CChain
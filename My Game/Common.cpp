@@ -9,6 +9,12 @@
 CRenderer* CCommon::m_pRenderer = nullptr;
 CObjectManager* CCommon::m_pObjectManager = nullptr;
 CParticleEngine2D* CCommon::m_pParticleEngine = nullptr;
+CGameRandom* CCommon::m_pGameRandom = nullptr;
+CSimTimer* CCommon::m_pSimTimer = nullptr;
+CJobSystem* CCommon::m_pJobSystem = nullptr;
+CExtraStore* CCommon::m_pExtraStore = nullptr;
+CEventQueue* CCommon::m_pEventQueue = nullptr;
 
 Vector2 CCommon::m_vWorldSize = Vector2::Zero;
 CObject* CCommon::m_pPlayer = nullptr;
+CObject* CCommon::m_pPlayer2 = nullptr;
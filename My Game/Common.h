@@ -11,6 +11,11 @@ class CObjectManager;
 class CRenderer;
 class CParticleEngine2D;
 class CObject;
+class CGameRandom;
+class CSimTimer;
+class CJobSystem;
+class CExtraStore;
+class CEventQueue;
 
 /// \brief The common variables class.
 ///
@@ -28,7 +33,13 @@ class CCommon{
     static CRenderer* m_pRenderer; ///< Pointer to the renderer.
     static CObjectManager* m_pObjectManager; ///< Pointer to the object manager.
     static CParticleEngine2D* m_pParticleEngine; ///< Pointer to particle engine.    
+    static CGameRandom* m_pGameRandom; ///< Pointer to simulation random number generator.
+    static CSimTimer* m_pSimTimer; ///< Pointer to simulation clock.
+    static CJobSystem* m_pJobSystem; ///< Pointer to job system.
+    static CExtraStore* m_pExtraStore; ///< Pointer to the pools of optional object state.
+    static CEventQueue* m_pEventQueue; ///< Pointer to the queue of sounds and vibration from the simulation.
 
     static Vector2 m_vWorldSize; ///< World height and width.
     static CObject* m_pPlayer; ///< Pointer to player character.
+    static CObject* m_pPlayer2; ///< Pointer to second player character in co-op, or nullptr.
 }; //CCommon
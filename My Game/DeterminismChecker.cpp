@@ -0,0 +1,150 @@
+/// \file DeterminismChecker.cpp
+/// \brief Code for the determinism checker CDeterminismChecker.
+
+#include <algorithm>
+
+#include "DeterminismChecker.h"
+#include "ObjectManager.h"
+#include "DebugPrintf.h"
+
+/// Open the reference file. If it already exists then this run is
+/// checked against it, otherwise this run becomes the reference.
+/// \param filename Name of the reference file.
+
+CDeterminismChecker::CDeterminismChecker(const char* filename){
+  m_fsReference.open(filename, ios::binary);
+  m_bVerifying = m_fsReference.is_open();
+
+  if(!m_bVerifying)
+    m_fsRecord.open(filename, ios::binary);
+} //constructor
+
+/// Close the reference file.
+
+CDeterminismChecker::~CDeterminismChecker(){
+  if(m_fsRecord.is_open())
+    m_fsRecord.close();
+
+  if(m_fsReference.is_open())
+    m_fsReference.close();
+} //destructor
+
+/// Hash the state after a simulation tick and either record it
+/// or check it. Checking stops at the first difference, since
+/// everything after it will differ too.
+
+void CDeterminismChecker::Tick(){
+  if(m_bDiverged)return;
+
+  const UINT tick = m_pObjectManager->GetTick();
+  const UINT64 hash = m_pObjectManager->HashState();
+
+  if(m_bVerifying)
+    Verify(tick, hash);
+  else Record(tick, hash);
+} //Tick
+
+/// Write a tick to the reference file. Per-object hashes are stored
+/// as well so that a later run can tell which object went wrong.
+/// \param tick Tick number.
+/// \param hash State hash.
+
+void CDeterminismChecker::Record(UINT tick, UINT64 hash){
+  m_pObjectManager->GetObjectHashes(m_vHashes, m_vTypes);
+  const UINT n = (UINT)m_vHashes.size();
+
+  m_fsRecord.write((const char*)&tick, sizeof(tick));
+  m_fsRecord.write((const char*)&hash, sizeof(hash));
+  m_fsRecord.write((const char*)&n, sizeof(n));
+
+  if(n > 0){
+    m_fsRecord.write((const char*)m_vHashes.data(), n*sizeof(UINT64));
+    m_fsRecord.write((const char*)m_vTypes.data(), n*sizeof(int));
+  } //if
+} //Record
+
+/// Read the next tick from the reference file and compare.
+/// Running past the end of the reference is not a difference.
+/// \param tick Tick number.
+/// \param hash State hash.
+
+void CDeterminismChecker::Verify(UINT tick, UINT64 hash){
+  UINT reftick = 0, n = 0;
+  UINT64 refhash = 0;
+
+  m_fsReference.read((char*)&reftick, sizeof(reftick));
+  m_fsReference.read((char*)&refhash, sizeof(refhash));
+  m_fsReference.read((char*)&n, sizeof(n));
+  if(!m_fsReference)return; //end of reference
+
+  m_vRefHashes.resize(n);
+  m_vRefTypes.resize(n);
+
+  if(n > 0){
+    m_fsReference.read((char*)m_vRefHashes.data(), n*sizeof(UINT64));
+    m_fsReference.read((char*)m_vRefTypes.data(), n*sizeof(int));
+  } //if
+
+  if(reftick != tick || refhash != hash)
+    Report(tick);
+} //Verify
+
+/// Find the first object whose hash differs from the reference.
+/// If every object matches then the difference is in the object
+/// manager's own counters or the random number generator, and
+/// the object index is reported as -1.
+/// \param tick Tick number.
+
+void CDeterminismChecker::Report(UINT tick){
+  m_bDiverged = true;
+  m_nDivergedTick = tick;
+
+  m_pObjectManager->GetObjectHashes(m_vHashes, m_vTypes);
+
+  const size_t n = max(m_vHashes.size(), m_vRefHashes.size());
+
+  for(size_t i=0; i<n && m_nDivergedObject < 0; i++){
+    if(i >= m_vHashes.size() || i >= m_vRefHashes.size() || m_vHashes[i] != m_vRefHashes[i]){
+      m_nDivergedObject = (int)i;
+      m_nDivergedType = i < m_vTypes.size()? m_vTypes[i]: m_vRefTypes[i];
+    } //if
+  } //for
+
+  DEBUGPRINTF("Determinism check failed at tick %u, object %d, sprite type %d\n",
+    m_nDivergedTick, m_nDivergedObject, m_nDivergedType);
+} //Report
+
+/// Reader function for the mode.
+/// \return true if checking against a reference, false if recording one.
+
+bool CDeterminismChecker::IsVerifying(){
+  return m_bVerifying;
+} //IsVerifying
+
+/// Reader function for the divergence flag.
+/// \return true if a difference has been found.
+
+bool CDeterminismChecker::Diverged(){
+  return m_bDiverged;
+} //Diverged
+
+/// Reader function for the tick of the first difference.
+/// \return Tick number.
+
+UINT CDeterminismChecker::GetDivergedTick(){
+  return m_nDivergedTick;
+} //GetDivergedTick
+
+/// Reader function for the object of the first difference.
+/// \return Index into the object list, or -1 if no object differs.
+
+int CDeterminismChecker::GetDivergedObject(){
+  return m_nDivergedObject;
+} //GetDivergedObject
+
+/// Reader function for the sprite type of the first difference.
+/// \return Sprite type, or -1 if no object differs.
+
+int CDeterminismChecker::GetDivergedType(){
+  return m_nDivergedType;
+} //GetDivergedType
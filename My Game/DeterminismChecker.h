@@ -0,0 +1,55 @@
+/// \file DeterminismChecker.h
+/// \brief Interface for the determinism checker CDeterminismChecker.
+
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "Common.h"
+#include "Defines.h"
+
+//#define USE_DETERMINISM_CHECKER ///< Define this to hash the simulation state after every tick.
+
+using namespace std;
+
+/// \brief The determinism checker.
+///
+/// The determinism checker hashes the simulation state after every tick.
+/// The first run writes the hashes to a file. Later runs compare against
+/// that file and report the first tick and object at which they differ.
+/// Two runs can only match if they are given the same inputs, run with a
+/// fixed time step, and start from the same random seed.
+
+class CDeterminismChecker: public CCommon{
+  private:
+    ofstream m_fsRecord; ///< Reference file being written.
+    ifstream m_fsReference; ///< Reference file being checked against.
+    bool m_bVerifying = false; ///< True if checking, false if recording.
+
+    bool m_bDiverged = false; ///< Whether a difference has been found.
+    UINT m_nDivergedTick = 0; ///< Tick of the first difference.
+    int m_nDivergedObject = -1; ///< Index in the object list of the first difference.
+    int m_nDivergedType = -1; ///< Sprite type of the object that differs.
+
+    vector<UINT64> m_vHashes; ///< Per-object hashes for this tick.
+    vector<int> m_vTypes; ///< Per-object sprite types for this tick.
+    vector<UINT64> m_vRefHashes; ///< Per-object hashes from the reference.
+    vector<int> m_vRefTypes; ///< Per-object sprite types from the reference.
+
+    void Record(UINT tick, UINT64 hash); ///< Write a tick to the reference file.
+    void Verify(UINT tick, UINT64 hash); ///< Check a tick against the reference file.
+    void Report(UINT tick); ///< Find and report the object that differs.
+
+  public:
+    CDeterminismChecker(const char* filename); ///< Constructor.
+    ~CDeterminismChecker(); ///< Destructor.
+
+    void Tick(); ///< Check the state after one simulation tick.
+
+    bool IsVerifying(); ///< Whether checking against a reference.
+    bool Diverged(); ///< Whether a difference has been found.
+    UINT GetDivergedTick(); ///< Get tick of first difference.
+    int GetDivergedObject(); ///< Get object index of first difference.
+    int GetDivergedType(); ///< Get sprite type of first difference.
+}; //CDeterminismChecker
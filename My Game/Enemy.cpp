@@ -1,4 +1,5 @@
 #include "Enemy.h"
+#include "ObjectManager.h"
 #include "Sndlist.h"
 #include "Helpers.h"
 #include "Abort.h"
@@ -10,7 +11,6 @@ CEnemyObject::CEnemyObject(const Vector2& pos, char color, int path )//: CObject
 	m_fHealth = 3;
 	path_key = path;
 	SetSpeed(50.0f);
-	orig_speed = m_fSpeed;
 
 	if (color == 'r') //Checks for which color enemy is desired and will assign the appropraite sprite
 	{
@@ -41,11 +41,7 @@ CEnemyObject::CEnemyObject(const Vector2& pos, char color, int path )//: CObject
 		m_nSpriteIndex = BLUE_LINE;
 	}
 
-	m_pRenderer->GetSize(m_nSpriteIndex, m_vRadius.x, m_vRadius.y);
-	m_vRadius *= 0.5f;
-	m_Sphere.Radius = max(m_vRadius.x, m_vRadius.y);
-	m_Sphere.Center = (Vector3)pos;
-	m_fGunTimer = m_pStepTimer->GetTotalSeconds();
+	FitSphere();
 }
 
 void CEnemyObject::move() //Enemy is moving, selecting tis path
@@ -86,20 +82,12 @@ void CEnemyObject::move() //Enemy is moving, selecting tis path
 		break;
 	}
 
-	// Object animation. From Ned's Turkey Farm
-	const size_t nFrameCount = m_pRenderer->GetNumFrames(m_nSpriteIndex); // nFrameCount = number of sprite's frames
-	const float dt = 1000.0f * m_fFrameInterval / (1500.0f + fabsf(m_vVel.x));    // calculates animation speed
-
-	// calculates current frame
-	if (nFrameCount > 1 && m_pStepTimer->GetTotalSeconds() > m_fFrameTimer + dt) {
-		m_fFrameTimer = m_pStepTimer->GetTotalSeconds();
-		m_nCurrentFrame = (m_nCurrentFrame + 1) % nFrameCount;
-	}
+	Animate();
 }
 
 CObject* CEnemyObject::FireGun() //Enemy is firing its gun
 {
-	m_pAudio->play(ENEMYGUN_SOUND);
+	m_pEventQueue->play(ENEMYGUN_SOUND);
 	const Vector2 pos = GetPos() - 0.5f * m_pRenderer->GetWidth(m_nSpriteIndex) * GetViewVector();
 	CObject* enemy_bullet;
 	if (m_nSpriteIndex == BLUE_LIGHT_ENEMY)
@@ -111,7 +99,7 @@ CObject* CEnemyObject::FireGun() //Enemy is firing its gun
 	else //(m_nSpriteIndex == BLUE_HEAVY_ENEMY)
 		enemy_bullet = new CObject(BLUE_BULLET, pos);
 
-	const Vector2 aim = m_pPlayer->GetPos() - GetPos();
+	const Vector2 aim = m_pObjectManager->NearestPlayer(GetPos())->GetPos() - GetPos();
 
 	enemy_bullet->SetVelocity((Vector2(0.0f, -700.0f) + aim) * .25f);
 	//enemy_bullet->SetVelocity((Vector2(0.0f, -1000.0f)) * .25f);
@@ -121,10 +109,9 @@ CObject* CEnemyObject::FireGun() //Enemy is firing its gun
 
 void CEnemyObject::Path_1() // Moved down and stops at y coordinate 512
 {
-	m_vOldPos = m_vPos;
 	if (m_vPos.y <= 512.0f)
 		m_fSpeed = 0.0f;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	m_vPos -= displacement * front;
@@ -133,8 +120,7 @@ void CEnemyObject::Path_1() // Moved down and stops at y coordinate 512
 
 void CEnemyObject::Path_2() //Flight path 2, descend on the right side, and then shift left
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -152,8 +138,7 @@ void CEnemyObject::Path_2() //Flight path 2, descend on the right side, and then
 // descends to top of screen, then moves diagonal down and left
 void CEnemyObject::Path_3()
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -175,8 +160,7 @@ void CEnemyObject::Path_3()
 // descends to top of screen, then moves diagonal down and right
 void CEnemyObject::Path_4()
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -197,8 +181,7 @@ void CEnemyObject::Path_4()
 
 void CEnemyObject::Path_5() //Flight path 5, descend and then shift right
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -217,8 +200,7 @@ void CEnemyObject::Path_5() //Flight path 5, descend and then shift right
 }
 void CEnemyObject::Path_6() //Flight path 6, descend and then shift left
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -237,8 +219,7 @@ void CEnemyObject::Path_6() //Flight path 6, descend and then shift left
 }
 void CEnemyObject::Path_7() //Flight path 7. zig zag horizontal right
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const float displacement = m_fSpeed * time;
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
@@ -278,8 +259,7 @@ void CEnemyObject::Path_7() //Flight path 7. zig zag horizontal right
 // Constantly move up and down. Meant for RED_LINE and BLUE_LINE
 void CEnemyObject::Path_8()
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const float displacement = m_fSpeed * time;
 
 	if (switchMovement == false)
@@ -300,62 +280,51 @@ void CEnemyObject::Path_8()
 	{
 		switchMovement = true;
 	}
-
-	// if enemy is RED_LINE and player is BLUE_SHIP, and the player's y position is within the enemies y position
-	if (m_nSpriteIndex == RED_LINE && m_pPlayer->m_nSpriteIndex == BLUE_SHIP)
-	{
-		if (m_pPlayer->m_vPos.y > m_vPos.y - 15 && m_pPlayer->m_vPos.y < m_vPos.y + 15)
-		{
-			hit();	// hit player
-		}
-	}
-
-	// if enemy is BLUE_LINE and player is RED_SHIP, and the player's y position is within the enemies y position
-	if (m_nSpriteIndex == BLUE_LINE && m_pPlayer->m_nSpriteIndex == RED_SHIP)
-	{
-		if (m_pPlayer->m_vPos.y > m_vPos.y - 15 && m_pPlayer->m_vPos.y < m_vPos.y + 15)
-		{
-			hit();	// hit player
-		}
-	}
 }
 
 // Quickly move down. Meant for RED_LINE and BLUE_LINE
 void CEnemyObject::Path_9()
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const float displacement = m_fSpeed * time;
 
 	m_vPos.y -= displacement * 6;	// move down quickly
-
-	// if enemy is RED_LINE and player is BLUE_SHIP, and the player's y position is within the enemies y position
-	if (m_nSpriteIndex == RED_LINE && m_pPlayer->m_nSpriteIndex == BLUE_SHIP)
-	{
-		if (m_pPlayer->m_vPos.y > m_vPos.y - 15 && m_pPlayer->m_vPos.y < m_vPos.y + 15)
-		{
-			hit();	// hit player
-		}
-	}
-
-	// if enemy is BLUE_LINE and player is RED_SHIP, and the player's y position is within the enemies y position
-	if (m_nSpriteIndex == BLUE_LINE && m_pPlayer->m_nSpriteIndex == RED_SHIP)
-	{
-		if (m_pPlayer->m_vPos.y > m_vPos.y - 15 && m_pPlayer->m_vPos.y < m_vPos.y + 15)
-		{
-			hit();	// hit player
-		}
-	}
 }
 
 // Moves down
 void CEnemyObject::Path_10()
 {
-	m_vOldPos = m_vPos;
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const float displacement = m_fSpeed * time;
 
 	m_vPos.y -= displacement;	// move down
 
 	m_Sphere.Center = (Vector3)m_vPos;	// update hitbox
-}
\ No newline at end of file
+}
+
+// hash simulation state, including which path the enemy is following
+void CEnemyObject::Hash(CStateHash& hash)
+{
+	CObject::Hash(hash);
+	hash.Add(path_key);
+	hash.Add(switchMovement);
+}
+
+// save simulation state, including which path the enemy is following
+void CEnemyObject::Save(CSnapshot& s)
+{
+	CObject::Save(s);
+	s.Write(path_key);
+	s.Write(switchMovement);
+}
+
+// load simulation state, including which path the enemy is following
+bool CEnemyObject::Load(CSnapshot& s)
+{
+	if (!CObject::Load(s))
+		return false;
+
+	s.Read(path_key);
+	s.Read(switchMovement);
+	return true;
+}
@@ -21,4 +21,7 @@ public:
 	void Path_8();	// Constantly move up and down. Meant for RED_LINE and BLUE_LINE
 	void Path_9();	// Quickly move down. Meant for RED_LINE and BLUE_LINE
 	void Path_10(); // Moves down
+	virtual void Hash(CStateHash& hash); // hash simulation state
+	virtual void Save(CSnapshot& s); // save simulation state
+	virtual bool Load(CSnapshot& s); // load simulation state
 };
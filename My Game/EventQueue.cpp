@@ -0,0 +1,66 @@
+/// \file EventQueue.cpp
+/// \brief Code for the sound and vibration queue CEventQueue.
+
+#include "EventQueue.h"
+
+/// Ask for a sound to be played once.
+/// \param s The sound.
+
+void CEventQueue::play(eSoundType s){
+  m_vEvents.push_back({PLAY_EVENT, s, 0, 0});
+} //play
+
+/// Ask for a sound to be played over and over.
+/// \param s The sound.
+
+void CEventQueue::loop(eSoundType s){
+  m_vEvents.push_back({LOOP_EVENT, s, 0, 0});
+} //loop
+
+/// Ask for a sound to be stopped.
+/// \param s The sound.
+
+void CEventQueue::stop(eSoundType s){
+  m_vEvents.push_back({STOP_EVENT, s, 0, 0});
+} //stop
+
+/// Ask for the controller to vibrate.
+/// \param left Left motor speed.
+/// \param right Right motor speed.
+
+void CEventQueue::Vibrate(int left, int right){
+  m_vEvents.push_back({VIBRATE_EVENT, GUN_SOUND, left, right});
+} //Vibrate
+
+/// Hand over the events asked for since they were last taken,
+/// replacing whatever was in the vector, and start afresh. The
+/// vectors are swapped, so neither side allocates once both have grown.
+/// \param events [out] The events, in the order they were asked for.
+
+void CEventQueue::Take(vector<GameEvent>& events){
+  events.swap(m_vEvents);
+  m_vEvents.clear();
+} //Take
+
+/// Discard the events, for when the simulation is run with nobody
+/// watching, such as while seeking in a replay.
+
+void CEventQueue::Clear(){
+  m_vEvents.clear();
+} //Clear
+
+/// Reader function for the number of events.
+/// \return Number of events asked for since they were last taken.
+
+size_t CEventQueue::GetSize() const{
+  return m_vEvents.size();
+} //GetSize
+
+/// Discard the events asked for after the first few, for when the
+/// ticks that asked for them are rolled back and simulated again.
+/// \param n Number of events to keep.
+
+void CEventQueue::Truncate(size_t n){
+  if(n < m_vEvents.size())
+    m_vEvents.resize(n);
+} //Truncate
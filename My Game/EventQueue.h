@@ -0,0 +1,54 @@
+/// \file EventQueue.h
+/// \brief Interface for the sound and vibration queue CEventQueue.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "SndList.h"
+
+using namespace std;
+
+/// \brief What a queued event does.
+
+enum eEventType{
+  PLAY_EVENT, ///< Play a sound once.
+  LOOP_EVENT, ///< Play a sound over and over.
+  STOP_EVENT, ///< Stop a sound.
+  VIBRATE_EVENT ///< Vibrate the controller.
+}; //eEventType
+
+/// \brief A sound or vibration for the main thread to act on.
+
+struct GameEvent{
+  eEventType m_nType; ///< What to do.
+  eSoundType m_nSound; ///< Sound, for sound events.
+  int m_nLeft; ///< Left motor speed, for vibration.
+  int m_nRight; ///< Right motor speed, for vibration.
+}; //GameEvent
+
+/// \brief Sounds and vibration asked for by the simulation.
+///
+/// The simulation runs on a worker thread, but neither the audio player
+/// nor the controller is thread safe, so the simulation must not use
+/// them. It asks for sounds and vibration here instead, with the same
+/// calls that the audio player has. The events are handed to the main
+/// thread in the render snapshot, which acts on them when it first
+/// draws that snapshot, so what is heard stays in step with what is seen.
+
+class CEventQueue{
+  private:
+    vector<GameEvent> m_vEvents; ///< Events since they were last taken.
+
+  public:
+    void play(eSoundType s); ///< Play a sound once.
+    void loop(eSoundType s); ///< Play a sound over and over.
+    void stop(eSoundType s); ///< Stop a sound.
+    void Vibrate(int left, int right); ///< Vibrate the controller.
+
+    void Take(vector<GameEvent>& events); ///< Hand over the events.
+    void Clear(); ///< Discard the events.
+    size_t GetSize() const; ///< Number of events not yet taken.
+    void Truncate(size_t n); ///< Discard all but the oldest events.
+}; //CEventQueue
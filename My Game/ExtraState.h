@@ -0,0 +1,59 @@
+/// \file ExtraState.h
+/// \brief Interface for the optional object states and their pools.
+
+#pragma once
+
+#include "StatePool.h"
+#include "GameDefines.h"
+
+class CObject;
+
+/// \brief Kinds of optional state that an object can have attached.
+/// An object has at most one, chosen by what kind of object it is.
+
+enum eExtraType{
+  NO_EXTRA, SHIP_EXTRA, BOSS_EXTRA, CARD_EXTRA, EXPLOSION_EXTRA
+}; //eExtraType
+
+/// \brief State that only player ships need.
+
+struct ShipState{
+  float m_fHitTime = 0.0f; ///< Time the ship was last hit.
+}; //ShipState
+
+/// \brief State that only bosses need.
+
+struct BossState{
+  CObject* m_pForceField = nullptr; ///< Force field, if one is up.
+  CObject* m_pBlackHole = nullptr; ///< Black hole, if one is open.
+
+  bool m_bCardsReady = false; ///< Cards can be dealt.
+  bool m_bForceFieldReady = false; ///< Force field can be put up.
+  bool m_bBlackHoleReady = false; ///< A black hole can be opened.
+  bool m_bCharging = false; ///< Charging at the player.
+  bool m_bForceFieldOn = false; ///< Force field is up.
+  bool m_bBlackHoleOn = false; ///< A black hole is open.
+  bool m_bStrafeForward = false; ///< Moving back up after a charge.
+}; //BossState
+
+/// \brief State that only cards need.
+
+struct CardState{
+  eSpriteType m_nReveal = CARD; ///< Queen or jack, shown when the card is hit.
+}; //CardState
+
+/// \brief State that only explosions need.
+
+struct ExplosionState{
+  float m_fBirthTime = 0.0f; ///< Time the explosion started.
+}; //ExplosionState
+
+/// \brief The pools that the optional object states come from.
+
+class CExtraStore{
+  public:
+    CStatePool<ShipState> m_cShips; ///< Player ship states.
+    CStatePool<BossState> m_cBosses; ///< Boss states.
+    CStatePool<CardState> m_cCards; ///< Card states.
+    CStatePool<ExplosionState> m_cExplosions; ///< Explosion states.
+}; //CExtraStore
@@ -7,13 +7,36 @@
 #include "Renderer.h"
 #include "ComponentIncludes.h"
 #include "ParticleEngine.h"
+#include "GameRandom.h"
+#include "SimTimer.h"
+#include "JobSystem.h"
+
+#include <chrono>
+
+/// Real time, for placing frames in between simulation ticks. The step
+/// timer cannot be used for this because in fixed step mode its clock
+/// only moves a whole tick at a time.
+/// \return Seconds since an arbitrary fixed point.
+
+static double RealTime(){
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+} //RealTime
+
+static const float SNAP_DISTANCE = 128.0f; ///< An object that moved further than this in one tick was teleported, so it is not interpolated.
 
 /// Delete the renderer and the object manager.
 
 CGame::~CGame(){
+  delete m_pDeterminismChecker;
+  delete m_pReplayVerifier;
+  delete m_pGameRandom;
+  delete m_pSimTimer;
+  delete m_pJobSystem;
   delete m_pParticleEngine;
   delete m_pRenderer;
   delete m_pObjectManager;
+  delete m_pExtraStore; //after the objects, which give their state back to it
+  delete m_pEventQueue;
 } //destructor
 
 /// Initialize the renderer and the object manager, load 
@@ -24,10 +47,30 @@ void CGame::Initialize(){
   m_pRenderer->Initialize(NUM_SPRITES); 
   m_pRenderer->LoadImages(); //load images from xml file list
 
+  m_pExtraStore = new CExtraStore; //pools of optional object state
+  m_pEventQueue = new CEventQueue; //sounds and vibration from the simulation
   m_pObjectManager = new CObjectManager; //set up the object manager 
   m_pAudio->Load(); //load the sounds for this game
 
   m_pParticleEngine = new CParticleEngine2D((CSpriteRenderer*)m_pRenderer);
+  m_pGameRandom = new CGameRandom; //same seed every run, like rand() without srand()
+  m_pSimTimer = new CSimTimer; //simulation clock
+  m_pJobSystem = new CJobSystem; //one worker thread per spare core
+
+  m_pStepTimer->SetFixedTimeStep(true); //the renderer interpolates between ticks
+  m_pStepTimer->SetTargetElapsedSeconds(SIM_TICK_SECONDS);
+
+  #ifdef USE_DETERMINISM_CHECKER
+    m_pDeterminismChecker = new CDeterminismChecker("determinism.bin");
+  #endif //USE_DETERMINISM_CHECKER
+
+  #ifdef USE_REPLAY_VERIFIER
+    m_pReplayVerifier = new CReplayVerifier("spool", "verifier.key");
+  #endif //USE_REPLAY_VERIFIER
+
+  #ifdef USE_MEMORY_REPORT
+    m_pObjectManager->ReportMemory();
+  #endif //USE_MEMORY_REPORT
 
   BeginGame();
 } //Initialize
@@ -60,14 +103,23 @@ void CGame::CreateObjects(){
       m_pObjectManager->create(STAR_BACKGROUND, m_vWorldSize / 2);
   }
 
-  // create player's ship
-  m_pPlayer = m_pObjectManager->create(BLUE_SHIP, Vector2(512.0f, 78.0f));
+  // create player's ship, and a second one in co-op
+  if (m_bCoop)
+  {
+      m_pPlayer = m_pObjectManager->create(BLUE_SHIP, Vector2(412.0f, 78.0f));
+      m_pPlayer2 = m_pObjectManager->create(RED_SHIP, Vector2(612.0f, 78.0f));
+  }
+  else
+  {
+      m_pPlayer = m_pObjectManager->create(BLUE_SHIP, Vector2(512.0f, 78.0f));
+      m_pPlayer2 = nullptr;
+  }
 
   // game over
   if (m_nCurLevel == -1)
   {
       m_pObjectManager->create(GAME_OVER_SCREEN, Vector2(m_vWinCenter));
-      m_pAudio->stop(BH_SOUND);
+      m_pEventQueue->stop(BH_SOUND); //queued, so that it comes after any black hole sound the simulation queued
   }
  
   // intro screen
@@ -163,19 +215,31 @@ void CGame::NextLevel(){
     old_score = m_pObjectManager->GetScore();
     m_pObjectManager->updateLevel(m_nCurLevel);
     BeginGame();
+    m_pObjectManager->Snapshot(m_cCheckpoint); // checkpoint so a restart doesn't rebuild the level
 }
 
+// Restart the level the player died in. The level is restored from the
+// checkpoint taken when it began, and only rebuilt if there is none.
 void CGame::GameOverFunc()
 {
+    gameOverCalled = false;   // set gameOverCalled to false
+    GameOver = true;
+    m_nCurLevel = m_nPrevLevel;
+    m_cReplay.EndRecording(); // a replay covers one attempt at one level
+    m_cReplay.EndPlayback();
+
+    if (m_pObjectManager->Restore(m_cCheckpoint))
+    {
+        m_pParticleEngine->clear(); //clear old particles
+        return;
+    }
+
     m_pObjectManager->SetScore(old_score);
     m_pObjectManager->setPlayerHealth(3);
     m_pObjectManager->setLevelCleared(false); // set level cleared to false
     m_pObjectManager->setEnemyCount(0);   // set enemyCount to 0
     m_pObjectManager->setBossCount(0);    // set bossCount to 0
-    gameOverCalled = false;   // set gameOverCalled to false
     m_pObjectManager->setBossPresent(false);  // set boss_present to false
-    GameOver = true;
-    m_nCurLevel = m_nPrevLevel;
     m_pObjectManager->updateLevel(m_nCurLevel);
     BeginGame();
 }
@@ -186,11 +250,38 @@ void CGame::GameOverFunc()
 /// program.
 
 void CGame::BeginGame(){  
+  m_cReplay.EndRecording(); //a replay covers one attempt at one level
+  m_cReplay.EndPlayback();
+  m_cNetSession.Close(); //so does a co-op session
   m_pParticleEngine->clear(); //clear old particles
   m_pObjectManager->clear(); //clear old objects
   CreateObjects(); //create new objects 
+  m_bCoop = false; //later levels are single player
 } //BeginGame
 
+/// Build the current level from scratch, as if a new game had started
+/// on it: the random number generator is seeded, the simulation clock
+/// and tick counter are zeroed, and the score, health and bombs are
+/// those of a new game. Nothing from earlier levels carries over, so
+/// the replay verifier can build exactly the same start from the level
+/// and seed in a replay.
+/// \param seed Random number seed.
+
+void CGame::StartLevel(UINT64 seed){
+  m_pGameRandom->seed(seed);
+  m_pSimTimer->SetTotalSeconds(0.0);
+  m_pObjectManager->ResetTick(); //BeginGame clears, which resets the timers to it
+
+  m_pObjectManager->ResetScore();
+  m_pObjectManager->setPlayerHealth(3);
+  m_pObjectManager->setLevelCleared(false);
+  m_pObjectManager->setEnemyCount(0);
+  m_pObjectManager->setBossCount(0);
+  m_pObjectManager->setBossPresent(false);
+  m_pObjectManager->updateLevel(m_nCurLevel);
+  BeginGame();
+} //StartLevel
+
 /// Poll the keyboard state and respond to the
 /// key presses that happened since the last frame.
 
@@ -225,88 +316,32 @@ void CGame::KeyboardHandler(){
   // if current level is not intro screen or gameover screen, and player is not dead, and level is not completed
   if (m_nCurLevel >= 1 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == false && m_pObjectManager->getPlayerHealth() > 0)
   {
-      const Vector2 pos = m_pPlayer->m_vPos; //position of center of sprite
-      float w, h; //sprite width and height
-      m_pRenderer->GetSize(m_pPlayer->m_nSpriteIndex, w, h);
-
-      // Controls vertical movement
+      // W or up arrow, S or down arrow, D or right arrow, A or left arrow move the ship
       if (m_pKeyboard->Down(VK_UP) || m_pKeyboard->Down(0x57))
-          m_pPlayer->SetSpeed(250.0f);
-      else if (m_pKeyboard->Down(VK_DOWN) || m_pKeyboard->Down(0x53))
-          m_pPlayer->SetSpeed(-250.0f);
-      else
-          m_pPlayer->SetSpeed(0.0f);
+          m_nInput |= INPUT_UP;
+      if (m_pKeyboard->Down(VK_DOWN) || m_pKeyboard->Down(0x53))
+          m_nInput |= INPUT_DOWN;
+      if (m_pKeyboard->Down(VK_RIGHT) || m_pKeyboard->Down(0x44))
+          m_nInput |= INPUT_RIGHT;
+      if (m_pKeyboard->Down(VK_LEFT) || m_pKeyboard->Down(0x41))
+          m_nInput |= INPUT_LEFT;
 
       // B, E, Q, L shift, R shift changes player ship's color
       if (m_pKeyboard->TriggerDown(0x42) || m_pKeyboard->TriggerDown(0x45) || m_pKeyboard->TriggerDown(0x51) || m_pKeyboard->TriggerDown(VK_LSHIFT)
           || m_pKeyboard->TriggerDown(VK_RSHIFT))
-          m_pPlayer->ChangeColor();
+          m_nInput |= INPUT_COLOR;
 
       // Space bar shoots bullet
       if (m_pKeyboard->TriggerDown(VK_SPACE))
-          m_pObjectManager->PlayerShoots();
-
-      // If right key and not at world edge, strafe right
-      if ((m_pKeyboard->Down(VK_RIGHT) || m_pKeyboard->Down(0x44)) && !(pos.x + w / 2 > m_vWorldSize.x))
-          m_pPlayer->StrafeRight();
+          m_nInput |= INPUT_FIRE;
 
-      // If left key and not at world edge, strafe left
-      if ((m_pKeyboard->Down(VK_LEFT) || m_pKeyboard->Down(0x41)) && !(pos.x - w / 2 < 0))
-          m_pPlayer->StrafeLeft();
-
-      // If y position minus half of sprite's height is less than 0, don't allow player to move down
-      if (pos.y - h / 2 < 0)
-      {
-          // Player cannot move down
-          if (m_pKeyboard->Down(VK_UP) || m_pKeyboard->Down(0x57))
-              m_pPlayer->SetSpeed(250.0f);
-          else
-              m_pPlayer->SetSpeed(0.0f);
-
-          // B, E, Q, L shift, R shift changes player ship's color
-          if (m_pKeyboard->TriggerDown(0x42) || m_pKeyboard->TriggerDown(0x45) || m_pKeyboard->TriggerDown(0x51) || m_pKeyboard->TriggerDown(VK_LSHIFT)
-              || m_pKeyboard->TriggerDown(VK_RSHIFT))
-              m_pPlayer->ChangeColor();
-
-          // Space bar shoots bullet
-          if (m_pKeyboard->TriggerDown(VK_SPACE))
-              m_pObjectManager->PlayerShoots();
-
-          // If right key and not at world edge, strafe right
-          if ((m_pKeyboard->Down(VK_RIGHT) || m_pKeyboard->Down(0x44)) && !(pos.x + w / 2 > m_vWorldSize.x))
-              m_pPlayer->StrafeRight();
-
-          // If left key and not at world edge, strafe left
-          if ((m_pKeyboard->Down(VK_LEFT) || m_pKeyboard->Down(0x41)) && !(pos.x - w / 2 < 0))
-              m_pPlayer->StrafeLeft();
-      }
+      // F fires homing lasers
+      if (m_pKeyboard->TriggerDown(0x46))
+          m_nInput |= INPUT_LASER;
 
-      // If y position minus half of sprite's height is greater than worldsize, don't allow player to move up
-      if (pos.y + h / 2 > m_vWorldSize.y)
-      {
-          // Player cannot move up
-          if (m_pKeyboard->Down(VK_DOWN) || m_pKeyboard->Down(0x53))
-              m_pPlayer->SetSpeed(-250.0f);
-          else
-              m_pPlayer->SetSpeed(0.0f);
-
-          // B, E, Q, L shift, R shift changes player ship's color
-          if (m_pKeyboard->TriggerDown(0x42) || m_pKeyboard->TriggerDown(0x45) || m_pKeyboard->TriggerDown(0x51) || m_pKeyboard->TriggerDown(VK_LSHIFT)
-              || m_pKeyboard->TriggerDown(VK_RSHIFT))
-              m_pPlayer->ChangeColor();
-
-          // Space bar shoots bullet
-          if (m_pKeyboard->TriggerDown(VK_SPACE))
-              m_pObjectManager->PlayerShoots();
-
-          // If right key and not at world edge, strafe right
-          if ((m_pKeyboard->Down(VK_RIGHT) || m_pKeyboard->Down(0x44)) && !(pos.x + w / 2 > m_vWorldSize.x))
-              m_pPlayer->StrafeRight();
-
-          // If left key and not at world edge, strafe left
-          if ((m_pKeyboard->Down(VK_LEFT) || m_pKeyboard->Down(0x41)) && !(pos.x - w / 2 < 0))
-              m_pPlayer->StrafeLeft();
-      }
+      // X sets off a bomb
+      if (m_pKeyboard->TriggerDown(0x58))
+          m_nInput |= INPUT_BOMB;
   } // if
 
   // if gameOver
@@ -321,7 +356,6 @@ void CGame::KeyboardHandler(){
   // if level is not intro screen or gameoverscreen and level is cleared
   if (m_nCurLevel >= 1 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == true)
   {
-      m_pPlayer->SetSpeed(0);
       m_pAudio->loop(VICTORY_MUSIC);
       if (m_pKeyboard->TriggerUp(VK_RETURN))
       {
@@ -373,95 +407,31 @@ void CGame::ControllerHandler(){
   //if (m_nCurLevel >= 1 && m_pPlayer->IsDead() == false && m_pObjectManager->getLevelCleared() == false)
   if (m_nCurLevel >= 1 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == false && m_pObjectManager->getPlayerHealth() > 0)
   {
-      const Vector2 pos = m_pPlayer->m_vPos; //position of center of sprite
-      float w, h; //sprite width and height
-      m_pRenderer->GetSize(m_pPlayer->m_nSpriteIndex, w, h);
-
-      // Controls vertical movement
+      // dpad moves the ship
       if (m_pController->GetDPadUp())
-          m_pPlayer->SetSpeed(250.0f);
-      else if (m_pController->GetDPadDown())
-          m_pPlayer->SetSpeed(-250.0f);
-      else
-          m_pPlayer->SetSpeed(0.0f);
-
-      // RB or Right Shoulder button shoots bullet
-      if (m_pController->GetButtonRSToggle())
-          m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-      // X button also shoots bullet
-      if (m_pController->GetButtonXToggle())
-          m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-      // Right on dpad and not at world edge, StrafeRight
-      if (m_pController->GetDPadRight() && !(pos.x + w / 2 > m_vWorldSize.x))
-          m_pPlayer->StrafeRight();
-
-      // Left on dpad and not at world edge, StrafeLeft
-      if (m_pController->GetDPadLeft() && !(pos.x - w / 2 < 0))
-          m_pPlayer->StrafeLeft();
-
-      // A button switches ships color
-      if (m_pController->GetButtonAToggle())
-          m_pPlayer->ChangeColor();
-
-      // LS or Left Shoulder also switches ships color
-      if (m_pController->GetButtonLSToggle())
-          m_pPlayer->ChangeColor();
-
-      // If y position minus half of sprite's height is less than 0, don't allow player to move down
-      if (pos.y - h / 2 < 0)
-      {
-          if (m_pController->GetDPadUp())
-              m_pPlayer->SetSpeed(250.0f);
-          else
-              m_pPlayer->SetSpeed(0.0f);
-
-          if (m_pController->GetDPadRight() && !(pos.x + w / 2 > m_vWorldSize.x))
-              m_pPlayer->StrafeRight();
-
-          if (m_pController->GetDPadLeft() && !(pos.x - w / 2 < 0))
-              m_pPlayer->StrafeLeft();
-
-          if (m_pController->GetButtonRSToggle())
-              m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-          if (m_pController->GetButtonXToggle())
-              m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-          if (m_pController->GetButtonAToggle())
-              m_pPlayer->ChangeColor();
-
-          if (m_pController->GetButtonLSToggle())
-              m_pPlayer->ChangeColor();
-      }
-
-      // If y position minus half of sprite's height is greater than worldsize, don't allow player to move up
-      if (pos.y + h / 2 > m_vWorldSize.y)
-      {
-          if (m_pController->GetDPadDown())
-              m_pPlayer->SetSpeed(-250.0f);
-          else
-              m_pPlayer->SetSpeed(0.0f);
-
-          if (m_pController->GetDPadRight() && !(pos.x + w / 2 > m_vWorldSize.x))
-              m_pPlayer->StrafeRight();
-
-          if (m_pController->GetDPadLeft() && !(pos.x - w / 2 < 0))
-              m_pPlayer->StrafeLeft();
-
-          if (m_pController->GetButtonRSToggle())
-              m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-          if (m_pController->GetButtonXToggle())
-              m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-
-          if (m_pController->GetButtonAToggle())
-              m_pPlayer->ChangeColor();
-
-          if (m_pController->GetButtonLSToggle())
-              m_pPlayer->ChangeColor();
-      }
+          m_nInput |= INPUT_UP;
+      if (m_pController->GetDPadDown())
+          m_nInput |= INPUT_DOWN;
+      if (m_pController->GetDPadRight())
+          m_nInput |= INPUT_RIGHT;
+      if (m_pController->GetDPadLeft())
+          m_nInput |= INPUT_LEFT;
+
+      // RB or Right Shoulder button, or X button, shoots bullet
+      if (m_pController->GetButtonRSToggle() || m_pController->GetButtonXToggle())
+          m_nInput |= INPUT_FIRE;
+
+      // A button, or LS or Left Shoulder, switches ships color
+      if (m_pController->GetButtonAToggle() || m_pController->GetButtonLSToggle())
+          m_nInput |= INPUT_COLOR;
+
+      // Y button fires homing lasers
+      if (m_pController->GetButtonYToggle())
+          m_nInput |= INPUT_LASER;
+
+      // B button sets off a bomb
+      if (m_pController->GetButtonBToggle())
+          m_nInput |= INPUT_BOMB;
   } // if
 
   // gameover
@@ -477,7 +447,6 @@ void CGame::ControllerHandler(){
   // if level is cleared, player can only press B
   if (m_nCurLevel >= 1 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == true)
   {
-      m_pPlayer->SetSpeed(0);
       m_pAudio->loop(VICTORY_MUSIC);
       
       if (m_pController->GetButtonBToggle())
@@ -490,30 +459,41 @@ void CGame::ControllerHandler(){
 
 } //ControllerHandler
 
-/// Ask the object manager to draw the game objects. RenderWorld
+/// Draw the latest render snapshot. RenderWorld
 /// is notified of the start and end of the frame so
 /// that it can let Direct3D do its pipelining jiggery-pokery.
+/// The sprites are drawn while the simulation job is still running,
+/// since the snapshot is the renderer's own copy. Particles and text
+/// come from the live game state, so they wait for the job to finish.
+/// \param sim The simulation job for this frame.
 
-void CGame::RenderFrame() {
-    m_pRenderer->BeginFrame();
-    m_pObjectManager->draw();
-    m_pParticleEngine->Draw();
+void CGame::RenderFrame(JobId sim) {
+    if (m_cRenderBuffer.Acquire()) //newest snapshot, if the simulation has published one
+        PlayEvents(m_cRenderBuffer.GetFront()); //its sounds, once
 
-    // if player is dead, it is gameover, and current level is -1
-    if (m_pObjectManager->getPlayerHealth() <= 0)
-    {
-        GameOver = true;
-        m_nCurLevel = -1;
+    const CRenderSnapshot& snapshot = m_cRenderBuffer.GetFront();
 
-        // if gameOverCalled is false, call BeginGame and set gameOverCalled to true.
-        // this ensures that BeginGame is only called once
-        if (gameOverCalled == false)
-        {
-            BeginGame();
-            gameOverCalled = true;
-        }
+    // The snapshot shows the end of the last tick. Draw one tick behind
+    // real time, partway from the previous tick to the last one, by the
+    // fraction of a tick that has passed since the snapshot was published.
+    float t = 1.0f;
+
+    if (snapshot.m_fStep > 0)
+        t = (float)min(1.0, max(0.0, (RealTime() - snapshot.m_fTime)/snapshot.m_fStep));
+
+    m_pRenderer->BeginFrame();
+    FollowCamera(Vector2::Lerp(snapshot.m_vOldCamera, snapshot.m_vCamera, t), snapshot.m_vWorldSize);
+
+    for (auto const& r: snapshot.m_vItems) {
+        CSpriteDesc2D desc = r.m_stDesc;
+        if (Vector2::DistanceSquared(r.m_vOldPos, desc.m_vPos) < SNAP_DISTANCE*SNAP_DISTANCE)
+            desc.m_vPos = Vector2::Lerp(r.m_vOldPos, desc.m_vPos, t);
+        m_pRenderer->Draw(desc);
     }
 
+    m_pJobSystem->Wait(sim); //the simulation must be done with the particles and the game state
+    m_pParticleEngine->Draw();
+
     // if current level is not intro screen, and level is not end screen, and level is not completed
     if (m_nCurLevel > 0 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == false)
     {
@@ -525,13 +505,20 @@ void CGame::RenderFrame() {
 
         // displays player's health
         m_pRenderer->DrawScreenText(health.c_str(), Vector2(10.0f, 725.0f), Colors::Red);       
+
+        // displays each player's chain length, absorbed energy and bombs left
+        const CChain& chain = m_pObjectManager->GetChain();
+
+        for (UINT i = 0; i < (m_pPlayer2 ? 2U : 1U); i++) {
+            string combo = "Chain " + to_string(chain.GetChain(i)) + "  Energy " + to_string(chain.GetEnergy(i))
+              + "  Bombs " + to_string(m_pObjectManager->GetBombs(i));
+            m_pRenderer->DrawScreenText(combo.c_str(), Vector2(400.0f, 725.0f - 30.0f*i), Colors::White);
+        }
     }
 
-    // if level is not game over, intro or end, and all enemies and bosses are defeated
-    if (m_nCurLevel > 0 && m_nCurLevel <= 9 && m_pObjectManager->getEnemyCount() == 0 && m_pObjectManager->getBossCount() == 0)
+    // if level is not game over, intro or end, and all enemies and bosses are defeated (see SimulateTick)
+    if (m_nCurLevel > 0 && m_nCurLevel <= 9 && m_pObjectManager->getLevelCleared() == true)
     {
-        m_pObjectManager->setLevelCleared(true);
-
         string level = "Level " + to_string(m_nCurLevel) + "   Cleared";
         //m_pRenderer->DrawScreenText(level.c_str(), Vector2(m_pPlayer->m_vPos.x, m_pPlayer->m_vPos.y), Colors::White);
         m_pRenderer->DrawScreenText(level.c_str(), Vector2(10, 725), Colors::LimeGreen);
@@ -544,8 +531,6 @@ void CGame::RenderFrame() {
     // if game is beaten
     if (m_nCurLevel == 10)
     {
-        m_pObjectManager->setLevelCleared(true);
-
         string win = "You Win!";
         m_pRenderer->DrawScreenText(win.c_str(), Vector2(10, 725), Colors::LimeGreen);
 
@@ -557,24 +542,65 @@ void CGame::RenderFrame() {
     m_pRenderer->EndFrame();
 } //RenderFrame
 
+/// Play the sounds and vibration that the simulation asked for in the
+/// ticks leading up to a render snapshot. This is done on the main
+/// thread because neither the audio player nor the controller is
+/// thread safe.
+/// \param snapshot A render snapshot that has just been taken.
+
+void CGame::PlayEvents(const CRenderSnapshot& snapshot){
+  for(auto const& e: snapshot.m_vEvents)
+    switch(e.m_nType){
+      case PLAY_EVENT: m_pAudio->play(e.m_nSound); break;
+      case LOOP_EVENT: m_pAudio->loop(e.m_nSound); break;
+      case STOP_EVENT: m_pAudio->stop(e.m_nSound); break;
+      case VIBRATE_EVENT: m_pController->Vibrate(e.m_nLeft, e.m_nRight); break;
+    } //switch
+} //PlayEvents
+
+/// Check for the end of the game once the frame's simulation is done.
+
+void CGame::CheckGameOver() {
+    // if player is dead, it is gameover, and current level is -1
+    if (m_pObjectManager->getPlayerHealth() <= 0)
+    {
+        GameOver = true;
+        m_nCurLevel = -1;
+
+        // if gameOverCalled is false, call BeginGame and set gameOverCalled to true.
+        // this ensures that BeginGame is only called once
+        if (gameOverCalled == false)
+        {
+            BeginGame();
+            gameOverCalled = true;
+        }
+    }
+
+    // if game is beaten
+    if (m_nCurLevel == 10)
+        m_pObjectManager->setLevelCleared(true);
+} //CheckGameOver
+
 /// Make the camera follow the player, but don't let it get
 /// too close to the edge. Unless the world is smaller than
 /// the window, in which case we center everything.
+/// \param pos Player position.
+/// \param world World width and height.
 
-void CGame::FollowCamera(){
-  Vector3 vCameraPos(m_pPlayer->GetPos()); //player position
+void CGame::FollowCamera(const Vector2& pos, const Vector2& world){
+  Vector3 vCameraPos(pos); //player position
 
-  if(m_vWorldSize.x > m_nWinWidth){ //world wider than screen
+  if(world.x > m_nWinWidth){ //world wider than screen
     vCameraPos.x = max(vCameraPos.x, m_nWinWidth/2.0f); //stay away from the left edge
-    vCameraPos.x = min(vCameraPos.x, m_vWorldSize.x - m_nWinWidth/2.0f);  //stay away from the right edge
+    vCameraPos.x = min(vCameraPos.x, world.x - m_nWinWidth/2.0f);  //stay away from the right edge
   } //if
-  else vCameraPos.x = m_vWorldSize.x/2.0f; //center horizontally.
+  else vCameraPos.x = world.x/2.0f; //center horizontally.
   
-  if(m_vWorldSize.y > m_nWinHeight){ //world higher than screen
+  if(world.y > m_nWinHeight){ //world higher than screen
     vCameraPos.y = max(vCameraPos.y, m_nWinHeight/2.0f);  //stay away from the bottom edge
-    vCameraPos.y = min(vCameraPos.y, m_vWorldSize.y - m_nWinHeight/2.0f); //stay away from the top edge
+    vCameraPos.y = min(vCameraPos.y, world.y - m_nWinHeight/2.0f); //stay away from the top edge
   } //if
-  else vCameraPos.y = m_vWorldSize.y/2.0f; //center vertically
+  else vCameraPos.y = world.y/2.0f; //center vertically
 
   m_pRenderer->SetCameraPos(vCameraPos); //camera to player
 } //FollowCamera
@@ -585,20 +611,293 @@ void CGame::FollowCamera(){
 /// prevent multiple copies of a sound from starting on the
 /// same frame. Notify the timer of the start and end of the
 /// frame so that it can calculate frame time. 
+///
+/// The simulation runs as a job on a worker thread while this
+/// thread draws the render snapshot that the previous frame's
+/// simulation published, so simulating and drawing overlap.
+/// Everything that changes game state from this thread happens
+/// before the job starts or after it has finished. The price is
+/// one frame of latency: input read this frame is simulated now,
+/// but is not seen or heard until the next frame draws the result.
 
 void CGame::ProcessFrame(){
+  if(m_pReplayVerifier){ //verify replays instead of playing
+    VerifyReplay();
+    return;
+  } //if
+
+  m_nInput &= INPUT_PRESSES; //held buttons are read afresh, presses wait for a tick
   KeyboardHandler(); //handle keyboard input
   ControllerHandler(); //handle controller input
+  ReplayHandler(); //handle replay keys
+  NetHandler(); //handle co-op keys
   m_pAudio->BeginFrame(); //notify audio player that frame has begun
-  
+
+  const JobId sim = m_pJobSystem->Submit([&](){Simulate();}); //simulate on a worker
+  RenderFrame(sim); //render a frame of animation meanwhile
+
+  m_pJobSystem->WaitAll(); //sync point, all of this frame's jobs are done
+  CheckGameOver(); //react to the end of the game
+} //ProcessFrame
+
+/// Run the simulation ticks that are due this frame and publish a
+/// render snapshot of the result.
+
+void CGame::Simulate(){
+  bool ticked = false; //whether the step timer ran any ticks this frame
+  m_pObjectManager->GetChain().ClearEvents(); //the log holds this frame's events
+
   m_pStepTimer->Tick([&](){ 
-    m_pObjectManager->move(); //move all objects
-    FollowCamera(); //make camera follow player
+    ticked = true;
+    UINT input = m_nInput; //player input for this tick
+
+    if(m_cNetSession.IsActive()){ //session simulates, and may roll back or wait
+      if(m_cNetSession.Tick(input, [&](UINT both){SimulateTick(both);}))
+        m_nInput &= ~INPUT_PRESSES; //a press only acts once
+
+      m_pParticleEngine->step(); //advance particle animation
+      return;
+    } //if
+
+    if(m_cReplay.IsPlaying()){ //replay supplies input
+      if(m_nReplayTick < m_cReplay.GetNumTicks()){
+        input = m_cReplay.GetInput(m_nReplayTick);
+        m_nReplayTick++;
+      } //if
+      else m_cReplay.EndPlayback(); //end of replay, back to live input
+    } //if
+
+    else if(m_cReplay.IsRecording())
+      m_cReplay.RecordTick(input);
+
+    SimulateTick(input); //move all objects
+    m_nInput &= ~INPUT_PRESSES; //a press only acts once
+
     m_pParticleEngine->step(); //advance particle animation
   });
 
-  RenderFrame(); //render a frame of animation
-} //ProcessFrame
+  if(ticked){ //otherwise the last snapshot is still current
+    CRenderSnapshot& snapshot = m_cRenderBuffer.GetBack();
+    m_pObjectManager->Publish(snapshot);
+    m_pEventQueue->Take(snapshot.m_vEvents); //sounds go with the picture they belong to
+    m_cNetSession.Shown(); //so that a rollback does not play them again
+    snapshot.m_fTime = RealTime();
+    snapshot.m_fStep = m_pStepTimer->GetElapsedSeconds();
+    m_cRenderBuffer.Publish(); //hand the snapshot to the renderer
+  } //if
+} //Simulate
+
+/// Verify one replay from the spool, if there is one. The keyframes
+/// come from the client, so none of them is used. Instead the level is
+/// built here from the level number and seed in the replay, and the
+/// whole replay is simulated from there as fast as possible, with no
+/// rendering and no waiting for the step timer. Every tick is the
+/// fixed SIM_TICK_SECONDS long, so the client has no say over the
+/// simulation clock.
+
+void CGame::VerifyReplay(){
+  m_pReplayVerifier->Poll([&](CReplay& replay){
+    if(replay.GetLevel() < 1 || replay.GetLevel() > 9)
+      return false; //not a level that can be played
+
+    m_nCurLevel = m_nPrevLevel = replay.GetLevel();
+    StartLevel(replay.GetSeed());
+
+    for(UINT t=0; t<replay.GetNumTicks(); t++){
+      SimulateTick(replay.GetInput(t));
+      m_pObjectManager->GetChain().ClearEvents(); //nobody is watching
+      m_pEventQueue->Clear(); //or listening
+      m_pJobSystem->WaitAll(); //recycle job storage
+    } //for
+
+    m_pParticleEngine->clear(); //particles are not part of the simulation
+    return true;
+  });
+} //VerifyReplay
+
+/// Act on one tick's worth of player input. The ship moves
+/// vertically and strafes unless that would take it past the edge
+/// of the world, and fire, color change, lasers and bombs happen once per press.
+/// \param player Pointer to the player's ship.
+/// \param input Player input bits, see eInputBits.
+
+void CGame::ApplyInput(CObject* player, UINT input){
+  const Vector2 pos = player->m_vPos; //position of center of sprite
+  float w, h; //sprite width and height
+  m_pRenderer->GetSize(player->m_nSpriteIndex, w, h);
+
+  // Controls vertical movement, player cannot move past the top or bottom
+  if ((input & INPUT_UP) && !(pos.y + h / 2 > m_vWorldSize.y))
+      player->SetSpeed(250.0f);
+  else if ((input & INPUT_DOWN) && !(pos.y - h / 2 < 0))
+      player->SetSpeed(-250.0f);
+  else
+      player->SetSpeed(0.0f);
+
+  if (input & INPUT_COLOR)
+      player->ChangeColor();
+
+  if (input & INPUT_FIRE)
+      m_pObjectManager->PlayerShoots(player);
+
+  if (input & INPUT_LASER)
+      m_pObjectManager->FireLasers(player);
+
+  if (input & INPUT_BOMB)
+      m_pObjectManager->Bomb(player);
+
+  // If right and not at world edge, strafe right
+  if ((input & INPUT_RIGHT) && !(pos.x + w / 2 > m_vWorldSize.x))
+      player->StrafeRight();
+
+  // If left and not at world edge, strafe left
+  if ((input & INPUT_LEFT) && !(pos.x - w / 2 < 0))
+      player->StrafeLeft();
+} //ApplyInput
+
+/// Advance the simulation by one tick. Everything that changes
+/// game state goes through here, so that live play, replays, seeking
+/// within a replay and co-op rollback all run exactly the same code.
+/// Every tick is SIM_TICK_SECONDS long, whatever the frame rate.
+/// \param input Player input bits for both players, see eInputBits.
+
+void CGame::SimulateTick(UINT input){
+  const bool playing = m_nCurLevel >= 1 && m_nCurLevel <= 9;
+  const UINT mask = (1 << INPUT_PLAYER2_SHIFT) - 1; //one player's input bits
+
+  if (playing && m_pObjectManager->getLevelCleared() == false && m_pObjectManager->getPlayerHealth() > 0)
+  {
+      if (m_pPlayer)
+          ApplyInput(m_pPlayer, input & mask);
+      if (m_pPlayer2)
+          ApplyInput(m_pPlayer2, (input >> INPUT_PLAYER2_SHIFT) & mask);
+  }
+  else if (playing && m_pObjectManager->getLevelCleared() == true)
+  {
+      if (m_pPlayer)
+          m_pPlayer->SetSpeed(0);
+      if (m_pPlayer2)
+          m_pPlayer2->SetSpeed(0);
+  }
+
+  m_pSimTimer->Tick((float)SIM_TICK_SECONDS); //advance simulation clock
+  m_pObjectManager->move(); //move all objects
+
+  // level is cleared when all enemies and bosses are defeated
+  if (playing && m_pObjectManager->getEnemyCount() == 0 && m_pObjectManager->getBossCount() == 0)
+      m_pObjectManager->setLevelCleared(true);
+
+  if(m_pDeterminismChecker)
+    m_pDeterminismChecker->Tick(); //hash state and check against reference
+} //SimulateTick
+
+/// Poll the co-op keys. On the intro screen F9 starts a co-op game as
+/// player 1 and F10 joins one as player 2, with the two copies of the
+/// game talking over the loopback interface. F11 cycles the simulated
+/// network conditions for testing rollback.
+
+void CGame::NetHandler(){
+  static const float latency[] = {0.0f, 0.05f, 0.1f}; //one-way latency in seconds
+  static const float loss[] = {0.0f, 0.05f, 0.1f}; //fraction of packets lost
+
+  if (m_pKeyboard->TriggerDown(VK_F11))
+  {
+      m_nNetConditions = (m_nNetConditions + 1)%3;
+      m_cNetSession.SetConditions(latency[m_nNetConditions], loss[m_nNetConditions]);
+  }
+
+  if (m_nCurLevel == 0 && !m_cNetSession.IsActive())
+  {
+      if (m_pKeyboard->TriggerDown(VK_F9))
+          StartCoop(0);
+      else if (m_pKeyboard->TriggerDown(VK_F10))
+          StartCoop(1);
+  }
+} //NetHandler
+
+/// Start a co-op game from the intro screen. Both copies of the game
+/// must start level 1 from the same state and step at the same fixed
+/// rate, so the step timer is fixed, the random number generator is
+/// reseeded, and the simulation clock and tick counter are zeroed.
+/// A co-op session lasts for one level.
+/// \param player Local player, 0 for player 1 or 1 for player 2.
+
+void CGame::StartCoop(UINT player){
+  m_pStepTimer->SetFixedTimeStep(true);
+  m_pStepTimer->SetTargetElapsedSeconds(SIM_TICK_SECONDS);
+  m_pGameRandom->seed(1);
+  m_pSimTimer->SetTotalSeconds(0.0);
+  m_pObjectManager->ResetTick(); //NextLevel clears, which resets the timers to it
+
+  m_pAudio->stop(RYDEEN_MUSIC);
+  GameOver = false;
+  m_bCoop = true;
+  NextLevel();
+  m_cCheckpoint.Clear(); //restart single player, not from the co-op level
+
+  if (player == 0)
+      m_cNetSession.Open(27015, 27016, 0);
+  else
+      m_cNetSession.Open(27016, 27015, 1);
+} //StartCoop
+
+/// Poll the replay keys. F5 restarts the current level from scratch and
+/// records it, or stops recording,
+/// F6 plays back the last recording, and while it plays F7 and F8
+/// jump back and forward by ten seconds' worth of ticks.
+
+void CGame::ReplayHandler(){
+  const UINT jump = 600; //ticks to jump when seeking
+
+  if (m_pKeyboard->TriggerDown(VK_F5) && !m_cReplay.IsPlaying() && !m_cNetSession.IsActive())
+  {
+      if (m_cReplay.IsRecording())
+          m_cReplay.EndRecording();
+      else if (m_nCurLevel >= 1 && m_nCurLevel <= 9)
+      {
+          const UINT64 seed = m_pGameRandom->GetState(); //any seed will do, it goes in the file
+          StartLevel(seed);
+          m_cReplay.BeginRecording("replay.rpl", m_nCurLevel, seed);
+      }
+  }
+
+  if (m_pKeyboard->TriggerDown(VK_F6) && !m_cReplay.IsRecording())
+  {
+      if (m_cReplay.BeginPlayback("replay.rpl"))
+      {
+          m_nCurLevel = m_nPrevLevel = m_cReplay.GetLevel();
+          SeekReplay(0);
+      }
+  }
+
+  if (m_cReplay.IsPlaying())
+  {
+      if (m_pKeyboard->TriggerDown(VK_F7))
+          SeekReplay(m_nReplayTick > jump? m_nReplayTick - jump: 0);
+
+      if (m_pKeyboard->TriggerDown(VK_F8))
+          SeekReplay(m_nReplayTick + jump);
+  }
+} //ReplayHandler
+
+/// Jump to a tick in the replay being played. The nearest keyframe
+/// at or before it is restored and the ticks after that keyframe
+/// are simulated from the recorded input, so a seek never simulates
+/// more than one keyframe interval.
+/// \param tick Tick to jump to, counted from the start of the replay.
+
+void CGame::SeekReplay(UINT tick){
+  tick = min(tick, m_cReplay.GetNumTicks());
+
+  UINT t = m_cReplay.RestoreKeyframe(tick);
+
+  for (; t < tick; t++)
+      SimulateTick(m_cReplay.GetInput(t));
+
+  m_nReplayTick = tick;
+  m_pParticleEngine->clear(); //particles are not part of the simulation
+  m_pEventQueue->Clear(); //nor are the sounds of the ticks skipped over
+} //SeekReplay
 
 
 // Zach: Level 1-3
@@ -7,6 +7,12 @@
 #include "Common.h"
 #include "ObjectManager.h"
 #include "Settings.h"
+#include "DeterminismChecker.h"
+#include "Replay.h"
+#include "ReplayVerifier.h"
+#include "NetSession.h"
+#include "JobSystem.h"
+#include "RenderSnapshot.h"
 
 /// \brief The game class.
 
@@ -24,12 +30,34 @@ class CGame:
     bool playerIsCreated = false;
     bool gameOverCalled = false;    // flag so BeginGame is only called once after gameover
 
+    CDeterminismChecker* m_pDeterminismChecker = nullptr; ///< Per-tick state hash checker, if in use.
+    CReplayVerifier* m_pReplayVerifier = nullptr; ///< Replay verifier, if running as one.
+    CSnapshot m_cCheckpoint; ///< State at the start of the current level.
+    CReplay m_cReplay; ///< Replay being recorded or played.
+    UINT m_nReplayTick = 0; ///< Next tick of the replay being played.
+    UINT m_nInput = 0; ///< Player input bits for the next tick.
+    CNetSession m_cNetSession; ///< Co-op session, if one is in progress.
+    UINT m_nNetConditions = 0; ///< Simulated network conditions for testing co-op.
+    bool m_bCoop = false; ///< Whether the level being created is co-op.
+    CTripleBuffer<CRenderSnapshot> m_cRenderBuffer; ///< Render snapshots from the simulation.
+
     void BeginGame(); ///< Begin playing the game.
+    void StartLevel(UINT64 seed); ///< Build the current level from scratch.
     void KeyboardHandler(); ///< The keyboard handler.
     void ControllerHandler(); ///< The controller handler.
-    void RenderFrame(); ///< Render an animation frame.
+    void ReplayHandler(); ///< The replay key handler.
+    void NetHandler(); ///< The co-op key handler.
+    void StartCoop(UINT player); ///< Start a co-op game.
+    void ApplyInput(CObject* player, UINT input); ///< Act on player input.
+    void SimulateTick(UINT input); ///< Advance the simulation one tick.
+    void SeekReplay(UINT tick); ///< Jump to a tick in the replay.
+    void VerifyReplay(); ///< Verify a replay from the spool.
+    void Simulate(); ///< Run this frame's simulation ticks.
+    void RenderFrame(JobId sim); ///< Render an animation frame.
+    void PlayEvents(const CRenderSnapshot& snapshot); ///< Play a snapshot's sounds and vibration.
+    void CheckGameOver(); ///< Check for the end of the game.
     void CreateObjects(); ///< Create game objects.
-    void FollowCamera(); ///< Make camera follow player character.
+    void FollowCamera(const Vector2& pos, const Vector2& world); ///< Make camera follow player character.
     void NextLevel();   // increments m_nCurLevel
     void Level_1(); //Level 1
     void GameOverFunc(); // sets level back to 0 (intro screen)
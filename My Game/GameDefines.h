@@ -19,6 +19,39 @@ enum eSpriteType{
   INTRO_SCREEN, GAME_OVER_SCREEN, BACKGROUND, VOLCANO_BACKGROUND, STAR_BACKGROUND, EARTH_BACKGROUND, DAMAGE_SPRITE, BIG_EXPLOSION, 
   BIG_SMOKE, SMALL_SMOKE, SMALL_EXPLOSION, LILBOMB, LILBOMB_EFFECT,
   RED_LIGHT_ENEMY, BLUE_LIGHT_ENEMY, RED_HEAVY_ENEMY, BLUE_HEAVY_ENEMY, FORCE_FIELD, BLACK_HOLE, JACK, QUEEN, CARD, 
-  RED_LINE, BLUE_LINE, LARGE_RESPAWN, SMALL_RESPAWN, END_SCREEN, 
+  RED_LINE, BLUE_LINE, LARGE_RESPAWN, SMALL_RESPAWN, END_SCREEN, PICKUP,
   NUM_SPRITES //MUST BE LAST
 }; //eSpriteType
+
+/// \brief How an object is killed when it reaches the edge of the world.
+
+enum eEdgeRule{
+  NO_EDGE, ///< Not killed at the edge.
+  TOP_EDGE, ///< Killed when it goes off the top.
+  ANY_EDGE ///< Killed when it goes off the left, the right or the bottom.
+}; //eEdgeRule
+
+/// Bit for a sprite type in a type mask, for spatial queries.
+/// \param t Sprite type.
+/// \return Mask with only that type's bit set.
+
+constexpr UINT64 TypeBit(int t){
+  return 1ULL << t;
+} //TypeBit
+
+static_assert(NUM_SPRITES <= 64, "sprite types must fit in a 64-bit type mask");
+
+/// \brief Player input bits.
+///
+/// One tick's worth of player input, as applied by CGame::ApplyInput
+/// and stored in replays. Fire, color change, laser and bomb are
+/// presses, the rest are held.
+
+enum eInputBits{
+  INPUT_UP = 1, INPUT_DOWN = 2, INPUT_LEFT = 4, INPUT_RIGHT = 8,
+  INPUT_FIRE = 16, INPUT_COLOR = 32, INPUT_LASER = 64, INPUT_BOMB = 128
+}; //eInputBits
+
+static const double SIM_TICK_SECONDS = 1.0/60.0; ///< Length of a simulation tick. Rendering is interpolated in between.
+static const UINT INPUT_PRESSES = INPUT_FIRE | INPUT_COLOR | INPUT_LASER | INPUT_BOMB; ///< Input bits that are presses rather than held.
+static const UINT INPUT_PLAYER2_SHIFT = 8; ///< Player 2's input bits are player 1's shifted left this far.
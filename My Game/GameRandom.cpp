@@ -0,0 +1,57 @@
+/// \file GameRandom.cpp
+/// \brief Code for the simulation random number generator CGameRandom.
+
+#include "GameRandom.h"
+
+/// Construct a generator from a seed.
+/// \param seed Seed value.
+
+CGameRandom::CGameRandom(UINT64 seed){
+  this->seed(seed);
+} //constructor
+
+/// Reseed the generator. The seed is scrambled with one round of
+/// splitmix64 so that small consecutive seeds give unrelated sequences.
+/// \param seed Seed value.
+
+void CGameRandom::seed(UINT64 seed){
+  UINT64 z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+  z ^= z >> 31;
+
+  m_nState = z? z: 0x9E3779B97F4A7C15ULL; //xorshift must not be zero
+} //seed
+
+/// Advance the generator and return a non-negative integer. Callers use
+/// it the same way as the C runtime rand(), for example rand()%100.
+/// \return Random integer in [0, 2^31 - 1].
+
+int CGameRandom::rand(){
+  m_nState ^= m_nState >> 12;
+  m_nState ^= m_nState << 25;
+  m_nState ^= m_nState >> 27;
+
+  return (int)((m_nState*0x2545F4914F6CDD1DULL) >> 33);
+} //rand
+
+/// Random float, uniformly distributed.
+/// \return Random float in [0, 1].
+
+float CGameRandom::randf(){
+  return (float)rand()/(float)0x7FFFFFFF;
+} //randf
+
+/// Reader function for the generator state.
+/// \return Generator state.
+
+UINT64 CGameRandom::GetState() const{
+  return m_nState;
+} //GetState
+
+/// Writer function for the generator state.
+/// \param state Generator state, as returned by GetState().
+
+void CGameRandom::SetState(UINT64 state){
+  m_nState = state? state: 0x9E3779B97F4A7C15ULL;
+} //SetState
@@ -0,0 +1,28 @@
+/// \file GameRandom.h
+/// \brief Interface for the simulation random number generator CGameRandom.
+
+#pragma once
+
+#include "Defines.h"
+
+/// \brief The simulation random number generator.
+///
+/// CGameRandom is a small xorshift64* generator used for every
+/// gameplay decision in the simulation. Unlike the C runtime rand()
+/// its whole state is a single 64-bit word, so it can be hashed,
+/// saved and restored along with the rest of the game state.
+
+class CGameRandom{
+  private:
+    UINT64 m_nState = 0x9E3779B97F4A7C15ULL; ///< Generator state, never zero.
+
+  public:
+    CGameRandom(UINT64 seed=1); ///< Constructor.
+
+    void seed(UINT64 seed); ///< Reseed the generator.
+    int rand(); ///< Non-negative random integer, like rand().
+    float randf(); ///< Random float in [0, 1].
+
+    UINT64 GetState() const; ///< Get generator state.
+    void SetState(UINT64 state); ///< Set generator state.
+}; //CGameRandom
@@ -0,0 +1,176 @@
+/// \file Hitbox.cpp
+/// \brief Code for the compound hitbox CHitbox.
+
+#include <algorithm>
+#include <cmath>
+
+#include "Hitbox.h"
+
+static const UINT LEAF_SIZE = 2; ///< Most parts in a leaf.
+static const UINT MAX_DEPTH = 32; ///< Size of the traversal stack, far more than a hitbox needs.
+
+/// Build the hitbox for a sprite type from the table. Sprite types
+/// that are not in the table use their bounding sphere.
+/// \param table Hitbox parts for the sprite types that have them.
+/// \param t Sprite type.
+/// \param half Half the width and height of the sprite.
+
+void CHitbox::Build(const vector<HitPartData>& table, eSpriteType t, const Vector2& half){
+  m_vParts.clear();
+  m_vNodes.clear();
+
+  const float scale = min(half.x, half.y);
+
+  for(auto const& d: table)
+    if(d.m_nType == t)
+      m_vParts.push_back({Vector2(d.m_fX*half.x, d.m_fY*half.y), d.m_fRadius*scale, d.m_nDamage});
+
+  if(!m_vParts.empty())
+    Split(0, (UINT)m_vParts.size());
+} //Build
+
+/// Build the subtree over some of the parts. The parts are split in
+/// half along the longer side of the box around their centers.
+/// \param first First part.
+/// \param count Number of parts.
+/// \return Index of the subtree's root node.
+
+UINT CHitbox::Split(UINT first, UINT count){
+  Vector2 lo = m_vParts[first].m_vOffset, hi = lo; //box around the parts
+  Vector2 clo = lo, chi = lo; //box around their centers
+
+  for(UINT i=first; i<first + count; i++){
+    const HitPart& p = m_vParts[i];
+    const Vector2 r(p.m_fRadius, p.m_fRadius);
+    lo = Vector2::Min(lo, p.m_vOffset - r);
+    hi = Vector2::Max(hi, p.m_vOffset + r);
+    clo = Vector2::Min(clo, p.m_vOffset);
+    chi = Vector2::Max(chi, p.m_vOffset);
+  } //for
+
+  const UINT node = (UINT)m_vNodes.size();
+  m_vNodes.push_back({lo, hi, first, count, 0});
+  if(count <= LEAF_SIZE)return node;
+
+  const bool wide = chi.x - clo.x >= chi.y - clo.y; //split across x
+  const UINT half = count/2;
+
+  nth_element(m_vParts.begin() + first, m_vParts.begin() + first + half, m_vParts.begin() + first + count,
+    [wide](const HitPart& a, const HitPart& b){
+      return wide? a.m_vOffset.x < b.m_vOffset.x: a.m_vOffset.y < b.m_vOffset.y;});
+
+  m_vNodes[node].m_nCount = 0; //inner node
+  Split(first, half); //left child comes next
+  const UINT right = Split(first + half, count - half);
+  m_vNodes[node].m_nRight = right;
+
+  return node;
+} //Split
+
+/// Test whether a line segment passes through a box.
+/// \param p Start of the segment.
+/// \param d Segment, from start to end.
+/// \param lo Bottom left corner of the box.
+/// \param hi Top right corner of the box.
+/// \return true if the segment touches the box.
+
+static bool SegmentBox(const Vector2& p, const Vector2& d, const Vector2& lo, const Vector2& hi){
+  float t0 = 0.0f, t1 = 1.0f;
+
+  const float pp[2] = {p.x, p.y}, dd[2] = {d.x, d.y};
+  const float ll[2] = {lo.x, lo.y}, hh[2] = {hi.x, hi.y};
+
+  for(int k=0; k<2; k++){ //slab in each axis
+    if(dd[k] == 0.0f){
+      if(pp[k] < ll[k] || pp[k] > hh[k])return false;
+    } //if
+
+    else{
+      float ta = (ll[k] - pp[k])/dd[k];
+      float tb = (hh[k] - pp[k])/dd[k];
+      if(ta > tb)swap(ta, tb);
+
+      t0 = max(t0, ta);
+      t1 = min(t1, tb);
+      if(t0 > t1)return false;
+    } //else
+  } //for
+
+  return true;
+} //SegmentBox
+
+/// Check whether there are any parts.
+/// \return true if the hitbox has no parts.
+
+bool CHitbox::IsEmpty() const{
+  return m_vParts.empty();
+} //IsEmpty
+
+/// Swept circle test of a shot against the hitbox, in the frame of the
+/// object that owns it. Boxes that the shot's path, grown by its radius,
+/// does not pass through are skipped along with everything under them.
+/// The parts in the leaves get the same swept circle test as
+/// CObjectManager::Sweep, and the earliest hit wins.
+/// \param pos Shot's center at the start of the tick, relative to the object's.
+/// \param d Shot's motion over the tick, relative to the object's.
+/// \param r Shot's radius.
+/// \param t [out] Fraction of the tick at which the shot first touches the part hit.
+/// \return Part hit, counting from 1, or 0 if the shot misses.
+
+UINT CHitbox::Test(const Vector2& pos, const Vector2& d, float r, float& t) const{
+  if(m_vNodes.empty())return 0;
+
+  UINT stack[MAX_DEPTH];
+  UINT top = 0;
+  stack[top++] = 0;
+
+  const Vector2 grow(r, r);
+  UINT hit = 0;
+  t = 2.0f;
+
+  while(top > 0){
+    const Node& node = m_vNodes[stack[--top]];
+    if(!SegmentBox(pos, d, node.m_vLo - grow, node.m_vHi + grow))continue;
+
+    if(node.m_nCount == 0){ //inner node
+      stack[top++] = node.m_nRight;
+      stack[top++] = (UINT)(&node - m_vNodes.data()) + 1; //left child
+      continue;
+    } //if
+
+    for(UINT i=node.m_nFirst; i<node.m_nFirst + node.m_nCount; i++){ //leaf
+      const HitPart& part = m_vParts[i];
+      const Vector2 p = pos - part.m_vOffset;
+      const float rr = r + part.m_fRadius;
+      const float c = p.LengthSquared() - rr*rr;
+
+      float s = 2.0f; //time of impact with this part
+
+      if(c <= 0.0f)s = 0.0f; //touching at the start
+
+      else{
+        const float a = d.LengthSquared();
+        const float b = p.Dot(d);
+        const float disc = b*b - a*c;
+
+        if(a > 0.0f && b < 0.0f && disc >= 0.0f)
+          s = (-b - sqrtf(disc))/a;
+      } //else
+
+      if(s <= 1.0f && s < t){
+        t = s;
+        hit = i + 1;
+      } //if
+    } //for
+  } //while
+
+  return hit;
+} //Test
+
+/// Reader function for the damage done by a part.
+/// \param part Part number, counting from 1.
+/// \return Hits of damage.
+
+int CHitbox::GetDamage(UINT part) const{
+  return m_vParts[part - 1].m_nDamage;
+} //GetDamage
@@ -0,0 +1,71 @@
+/// \file Hitbox.h
+/// \brief Interface for the compound hitbox CHitbox.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "GameDefines.h"
+
+using namespace std;
+
+/// \brief One circle of a compound hitbox.
+
+struct HitPart{
+  Vector2 m_vOffset; ///< Center, relative to the object's center.
+  float m_fRadius; ///< Radius.
+  int m_nDamage; ///< Hits of damage done by a shot that lands here.
+}; //HitPart
+
+/// \brief One row of the hitbox table, as read from gamesettings.xml.
+/// Offsets are fractions of the sprite's half width and height, and
+/// the radius is a fraction of the smaller of the two.
+
+struct HitPartData{
+  eSpriteType m_nType; ///< Sprite type.
+  float m_fX; ///< Offset in x.
+  float m_fY; ///< Offset in y.
+  float m_fRadius; ///< Radius.
+  int m_nDamage; ///< Hits of damage.
+}; //HitPartData
+
+/// \brief A compound hitbox made of circles.
+///
+/// An object's bounding sphere has to cover the whole sprite, so on
+/// a big boss most of it is empty corners. A compound hitbox covers
+/// the sprite with a few smaller circles instead, each with its own
+/// damage, for example a weak spot that takes double damage. The parts
+/// come from a table in gamesettings.xml, with sizes given as fractions
+/// of the sprite so that they fit whatever art is loaded.
+///
+/// The parts are kept in a tiny bounding volume hierarchy of boxes, so
+/// a shot that gets through the bounding sphere test but misses is
+/// thrown out after a box test or two rather than testing every part.
+/// Objects do not rotate, so one hitbox per sprite type serves every
+/// object of that type, and it is tested in the object's frame.
+
+class CHitbox{
+  private:
+    /// \brief A node in the bounding volume hierarchy. The left child
+    /// of an inner node comes right after it in the array.
+
+    struct Node{
+      Vector2 m_vLo; ///< Bottom left corner of the box around the parts.
+      Vector2 m_vHi; ///< Top right corner of the box around the parts.
+      UINT m_nFirst; ///< First part, for a leaf.
+      UINT m_nCount; ///< Number of parts, or 0 for an inner node.
+      UINT m_nRight; ///< Right child, for an inner node.
+    }; //Node
+
+    vector<HitPart> m_vParts; ///< Parts, in leaf order.
+    vector<Node> m_vNodes; ///< Hierarchy, root first.
+
+    UINT Split(UINT first, UINT count); ///< Build a subtree.
+
+  public:
+    void Build(const vector<HitPartData>& table, eSpriteType t, const Vector2& half); ///< Build the hitbox for a sprite type.
+    bool IsEmpty() const; ///< Whether there are any parts.
+    UINT Test(const Vector2& pos, const Vector2& d, float r, float& t) const; ///< Swept circle test.
+    int GetDamage(UINT part) const; ///< Damage done by a part.
+}; //CHitbox
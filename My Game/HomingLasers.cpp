@@ -0,0 +1,256 @@
+/// \file HomingLasers.cpp
+/// \brief Code for the homing laser volley CHomingLasers.
+
+#include <algorithm>
+#include <cmath>
+
+#include "HomingLasers.h"
+#include "Object.h"
+
+static const float LASER_SPEED = 900.0f; ///< Speed that lasers steer towards.
+static const float LASER_TURN = 8.0f; ///< How quickly lasers turn, per second.
+static const float LASER_LIFE = 2.5f; ///< Seconds before a laser fizzles out.
+
+/// Fire a laser at a target, if there is room for another one.
+/// \param pos Starting position.
+/// \param v Starting velocity.
+/// \param target Object to home in on.
+/// \param player Player who fired it, 0 or 1.
+/// \return true if the laser was fired.
+
+bool CHomingLasers::Fire(const Vector2& pos, const Vector2& v, CObject* target, UINT player){
+  if(m_vX.size() >= MAX_LASERS || target == nullptr)return false;
+
+  m_vX.push_back(pos.x); m_vY.push_back(pos.y);
+  m_vVX.push_back(v.x); m_vVY.push_back(v.y);
+  m_vOldX.push_back(pos.x); m_vOldY.push_back(pos.y);
+  m_vTX.push_back(pos.x); m_vTY.push_back(pos.y); //gathered in Update()
+  m_vTR.push_back(0.0f);
+  m_vLife.push_back(LASER_LIFE);
+  m_vTarget.push_back(target);
+  m_vPlayer.push_back(player);
+
+  return true;
+} //Fire
+
+/// Remove a laser, keeping the rest in the order they were fired.
+/// \param i Laser number.
+
+void CHomingLasers::Remove(UINT i){
+  m_vX.erase(m_vX.begin() + i); m_vY.erase(m_vY.begin() + i);
+  m_vVX.erase(m_vVX.begin() + i); m_vVY.erase(m_vVY.begin() + i);
+  m_vOldX.erase(m_vOldX.begin() + i); m_vOldY.erase(m_vOldY.begin() + i);
+  m_vTX.erase(m_vTX.begin() + i); m_vTY.erase(m_vTY.begin() + i);
+  m_vTR.erase(m_vTR.begin() + i);
+  m_vLife.erase(m_vLife.begin() + i);
+  m_vTarget.erase(m_vTarget.begin() + i);
+  m_vPlayer.erase(m_vPlayer.begin() + i);
+} //Remove
+
+/// Steer and move all lasers for one tick. First the live targets'
+/// positions and radii are gathered. Then every laser turns its velocity
+/// part of the way towards flying straight at its target at full speed,
+/// and moves. Finally lasers that have reached their target or run out
+/// of time are removed.
+/// \param dt Length of the tick in seconds.
+/// \return Targets hit this tick and who hit them, in the order the
+/// lasers were fired.
+
+const vector<LaserHit>& CHomingLasers::Update(float dt){
+  m_vHits.clear();
+  const UINT n = (UINT)m_vX.size();
+  if(n == 0)return m_vHits;
+
+  for(UINT i=0; i<n; i++){ //gather targets
+    CObject* p = m_vTarget[i];
+    if(p == nullptr)continue; //keep flying to where it was
+
+    const Vector2 pos = p->GetPos();
+    m_vTX[i] = pos.x;
+    m_vTY[i] = pos.y;
+    m_vTR[i] = p->GetBoundingSphere().Radius;
+  } //for
+
+  const float k = min(1.0f, LASER_TURN*dt); //fraction of the turn made this tick
+
+  float* const x = m_vX.data(); float* const y = m_vY.data();
+  float* const vx = m_vVX.data(); float* const vy = m_vVY.data();
+  float* const ox = m_vOldX.data(); float* const oy = m_vOldY.data();
+  const float* const tx = m_vTX.data(); const float* const ty = m_vTY.data();
+  float* const life = m_vLife.data();
+
+  for(UINT i=0; i<n; i++){ //steer and move
+    ox[i] = x[i];
+    oy[i] = y[i];
+
+    const float dx = tx[i] - x[i];
+    const float dy = ty[i] - y[i];
+    const float s = LASER_SPEED/sqrtf(max(dx*dx + dy*dy, 1.0f)); //scale to full speed
+
+    vx[i] += (dx*s - vx[i])*k;
+    vy[i] += (dy*s - vy[i])*k;
+    x[i] += vx[i]*dt;
+    y[i] += vy[i]*dt;
+    life[i] -= dt;
+  } //for
+
+  for(UINT i=n; i-->0;){ //hits and fizzles, last first so removal is safe
+    const float dx = m_vTX[i] - m_vX[i];
+    const float dy = m_vTY[i] - m_vY[i];
+    const bool reached = dx*dx + dy*dy <= m_vTR[i]*m_vTR[i];
+
+    if(reached && m_vTarget[i] != nullptr)
+      m_vHits.push_back({m_vTarget[i], m_vPlayer[i]});
+
+    if(reached || m_vLife[i] <= 0.0f)
+      Remove(i);
+  } //for
+
+  reverse(m_vHits.begin(), m_vHits.end()); //back into firing order
+  return m_vHits;
+} //Update
+
+/// Forget targets that have died, since they are about to be deleted.
+/// Their lasers carry on to where the target was last seen.
+
+void CHomingLasers::DropDead(){
+  for(auto& p: m_vTarget)
+    if(p != nullptr && p->IsDead())
+      p = nullptr;
+} //DropDead
+
+/// Remove all lasers.
+
+void CHomingLasers::Clear(){
+  m_vX.clear(); m_vY.clear();
+  m_vVX.clear(); m_vVY.clear();
+  m_vOldX.clear(); m_vOldY.clear();
+  m_vTX.clear(); m_vTY.clear(); m_vTR.clear();
+  m_vLife.clear();
+  m_vTarget.clear();
+  m_vPlayer.clear();
+  m_vHits.clear();
+} //Clear
+
+/// Reader function for the number of lasers.
+/// \return Number of lasers in flight.
+
+UINT CHomingLasers::GetSize() const{
+  return (UINT)m_vX.size();
+} //GetSize
+
+/// Reader function for a laser's position.
+/// \param i Laser number.
+/// \return Position.
+
+Vector2 CHomingLasers::GetPos(UINT i) const{
+  return Vector2(m_vX[i], m_vY[i]);
+} //GetPos
+
+/// Reader function for a laser's position at the start of the tick.
+/// \param i Laser number.
+/// \return Old position.
+
+Vector2 CHomingLasers::GetOldPos(UINT i) const{
+  return Vector2(m_vOldX[i], m_vOldY[i]);
+} //GetOldPos
+
+/// Reader function for a laser's velocity.
+/// \param i Laser number.
+/// \return Velocity.
+
+Vector2 CHomingLasers::GetVelocity(UINT i) const{
+  return Vector2(m_vVX[i], m_vVY[i]);
+} //GetVelocity
+
+/// Reader function for a laser's target.
+/// \param i Laser number.
+/// \return Pointer to the target, or nullptr if it died.
+
+CObject* CHomingLasers::GetTarget(UINT i) const{
+  return m_vTarget[i];
+} //GetTarget
+
+/// Whether any laser in flight is locked on to an object.
+/// \param p Pointer to the object.
+/// \return true if a laser is locked on to it.
+
+bool CHomingLasers::IsTarget(const CObject* p) const{
+  return find(m_vTarget.begin(), m_vTarget.end(), p) != m_vTarget.end();
+} //IsTarget
+
+/// Writer function for a laser's target, for restoring a snapshot.
+/// \param i Laser number.
+/// \param p Pointer to the target, or nullptr.
+
+void CHomingLasers::SetTarget(UINT i, CObject* p){
+  m_vTarget[i] = p;
+} //SetTarget
+
+/// Hash the lasers. Targets are left to the object manager,
+/// since they are pointers.
+/// \param hash The hash.
+
+void CHomingLasers::Hash(CStateHash& hash) const{
+  const UINT n = GetSize();
+  hash.Add(n);
+
+  for(UINT i=0; i<n; i++){
+    hash.Add(m_vX[i]); hash.Add(m_vY[i]);
+    hash.Add(m_vVX[i]); hash.Add(m_vVY[i]);
+    hash.Add(m_vTX[i]); hash.Add(m_vTY[i]); hash.Add(m_vTR[i]);
+    hash.Add(m_vLife[i]);
+    hash.Add(m_vPlayer[i]);
+  } //for
+} //Hash
+
+/// Save the lasers. Targets are left to the object manager,
+/// since they are pointers.
+/// \param s The snapshot.
+
+void CHomingLasers::Save(CSnapshot& s) const{
+  const UINT n = GetSize();
+  s.Write(n);
+
+  for(UINT i=0; i<n; i++){
+    s.Write(m_vX[i]); s.Write(m_vY[i]);
+    s.Write(m_vVX[i]); s.Write(m_vVY[i]);
+    s.Write(m_vOldX[i]); s.Write(m_vOldY[i]);
+    s.Write(m_vTX[i]); s.Write(m_vTY[i]); s.Write(m_vTR[i]);
+    s.Write(m_vLife[i]);
+    s.Write(m_vPlayer[i]);
+  } //for
+} //Save
+
+/// Load the lasers. Their targets are all nullptr until the
+/// object manager sets them.
+/// \param s The snapshot.
+/// \return false if there are more lasers than there can be, or one
+/// was fired by a player who cannot be.
+
+bool CHomingLasers::Load(CSnapshot& s){
+  UINT n = 0;
+  s.Read(n);
+  if(n > MAX_LASERS)return false;
+
+  m_vX.resize(n); m_vY.resize(n);
+  m_vVX.resize(n); m_vVY.resize(n);
+  m_vOldX.resize(n); m_vOldY.resize(n);
+  m_vTX.resize(n); m_vTY.resize(n); m_vTR.resize(n);
+  m_vLife.resize(n);
+  m_vTarget.assign(n, nullptr);
+  m_vPlayer.resize(n);
+  m_vHits.clear();
+
+  for(UINT i=0; i<n; i++){
+    s.Read(m_vX[i]); s.Read(m_vY[i]);
+    s.Read(m_vVX[i]); s.Read(m_vVY[i]);
+    s.Read(m_vOldX[i]); s.Read(m_vOldY[i]);
+    s.Read(m_vTX[i]); s.Read(m_vTY[i]); s.Read(m_vTR[i]);
+    s.Read(m_vLife[i]);
+    s.Read(m_vPlayer[i]);
+    if(m_vPlayer[i] > 1)return false;
+  } //for
+
+  return true;
+} //Load
@@ -0,0 +1,78 @@
+/// \file HomingLasers.h
+/// \brief Interface for the homing laser volley CHomingLasers.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "StateHash.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+class CObject;
+
+/// \brief A homing laser reaching its target.
+
+struct LaserHit{
+  CObject* m_pTarget; ///< Target hit.
+  UINT m_nPlayer; ///< Player who fired the laser, 0 or 1.
+}; //LaserHit
+
+/// \brief The player's homing lasers.
+///
+/// A charged counter-attack fires a volley of up to MAX_LASERS lasers,
+/// each locked on to a different enemy. The lasers are not objects in
+/// the object list. They only ever hit their own target, so they need
+/// no broad phase, and they are steered all at once each tick. Their
+/// state is kept in separate arrays of floats so that the steering loop
+/// runs straight through memory without touching the objects. The
+/// targets' positions are gathered into arrays of their own first, the
+/// only place that the loop looks at an object, so the rest of it is
+/// plain arithmetic on arrays that the compiler can vectorize.
+///
+/// A laser whose target dies on the way keeps flying to where the target
+/// was last seen and fizzles out there. The object manager must call
+/// DropDead() before it deletes dead objects, and Clear() when it
+/// deletes all of them.
+
+class CHomingLasers{
+  public:
+    static const UINT MAX_LASERS = 12; ///< Most lasers in flight at once.
+
+  private:
+    vector<float> m_vX; ///< Position x.
+    vector<float> m_vY; ///< Position y.
+    vector<float> m_vVX; ///< Velocity x.
+    vector<float> m_vVY; ///< Velocity y.
+    vector<float> m_vOldX; ///< Position x at the start of the tick.
+    vector<float> m_vOldY; ///< Position y at the start of the tick.
+    vector<float> m_vTX; ///< Target x, gathered each tick.
+    vector<float> m_vTY; ///< Target y, gathered each tick.
+    vector<float> m_vTR; ///< Target radius, gathered each tick.
+    vector<float> m_vLife; ///< Seconds left to live.
+    vector<CObject*> m_vTarget; ///< Target, or nullptr if it died.
+    vector<UINT> m_vPlayer; ///< Player who fired it, 0 or 1.
+    vector<LaserHit> m_vHits; ///< Targets hit this tick.
+
+    void Remove(UINT i); ///< Remove a laser.
+
+  public:
+    bool Fire(const Vector2& pos, const Vector2& v, CObject* target, UINT player); ///< Fire a laser.
+    const vector<LaserHit>& Update(float dt); ///< Steer and move all lasers.
+    void DropDead(); ///< Forget targets that have died.
+    void Clear(); ///< Remove all lasers.
+
+    UINT GetSize() const; ///< Number of lasers in flight.
+    Vector2 GetPos(UINT i) const; ///< Position of a laser.
+    Vector2 GetOldPos(UINT i) const; ///< Position at the start of the tick.
+    Vector2 GetVelocity(UINT i) const; ///< Velocity of a laser.
+    CObject* GetTarget(UINT i) const; ///< Target of a laser.
+    bool IsTarget(const CObject* p) const; ///< Whether a laser is locked on to an object.
+    void SetTarget(UINT i, CObject* p); ///< Set the target of a laser.
+
+    void Hash(CStateHash& hash) const; ///< Hash laser state.
+    void Save(CSnapshot& s) const; ///< Save laser state, not including targets.
+    bool Load(CSnapshot& s); ///< Load laser state, not including targets.
+}; //CHomingLasers
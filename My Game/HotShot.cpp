@@ -1,4 +1,5 @@
 #include "HotShot.h"
+#include "ObjectManager.h"
 
 HotShot::HotShot(const Vector2& loc) // Default Constructor
 {
@@ -6,13 +7,8 @@ HotShot::HotShot(const Vector2& loc) // Default Constructor
 	m_nSpriteIndex = HOTSHOT;
 	m_vPos = loc;
 
-	m_pRenderer->GetSize(m_nSpriteIndex, m_vRadius.x, m_vRadius.y);
-	m_vRadius *= 0.5f;
-
-	m_Sphere.Radius = max(m_vRadius.x, m_vRadius.y);
-	m_Sphere.Center = (Vector3)m_vPos;
-
-	m_fGunTimer = m_pStepTimer->GetTotalSeconds();
+	FitSphere();
+	Attach(BOSS_EXTRA);
 
 	SetSpeed(80.0f);
 
@@ -22,7 +18,7 @@ HotShot::HotShot(const Vector2& loc) // Default Constructor
 
 void HotShot::move()  //HotShot Moving
 {
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 front = GetViewVector();
 	const Vector2 normal_velocity(front.y, -front.x);
 	const float displacement = m_fSpeed * time;
@@ -54,22 +50,14 @@ void HotShot::move()  //HotShot Moving
 
 	m_Sphere.Center = (Vector3)m_vPos;
 
-	// Object animation. From Ned's Turkey Farm
-	const size_t nFrameCount = m_pRenderer->GetNumFrames(m_nSpriteIndex); // nFrameCount = number of sprite's frames
-	const float dt = 1000.0f * m_fFrameInterval / (1500.0f + fabsf(m_vVel.x));    // calculates animation speed
-
-	// calculates current frame
-	if (nFrameCount > 1 && m_pStepTimer->GetTotalSeconds() > m_fFrameTimer + dt) {
-		m_fFrameTimer = m_pStepTimer->GetTotalSeconds();
-		m_nCurrentFrame = (m_nCurrentFrame + 1) % nFrameCount;
-	}
+	Animate();
 }
 
 
 CObject* HotShot::Attack1(const Vector2& loc) //Signature move, returns his firetrap
 {
-	m_pAudio->play(FIRETRAP_SOUND);
-	int which = rand() % 100;
+	m_pEventQueue->play(FIRETRAP_SOUND);
+	int which = m_pGameRandom->rand() % 100;
 	CObject* trap;
 	trap = new CObject(REDFIRE, loc);
 	return trap;
@@ -77,12 +65,12 @@ CObject* HotShot::Attack1(const Vector2& loc) //Signature move, returns his fire
 
 CObject* HotShot::FireGun()  //Normal attack, returns his fireball
 {
-	m_pAudio->play(FIREBALL_SOUND);
+	m_pEventQueue->play(FIREBALL_SOUND);
 	const Vector2 pos = GetPos() - 0.5f * m_pRenderer->GetWidth(m_nSpriteIndex) * GetViewVector();
 	
 	CObject* fire_ball = new CObject(FIREBALL, pos);
 	
-	const Vector2 aim = m_pPlayer->GetPos() - GetPos();
+	const Vector2 aim = m_pObjectManager->NearestPlayer(GetPos())->GetPos() - GetPos();
 	fire_ball->SetVelocity((Vector2(0.0f, -220.0f) + aim) * .50f);
 	fire_ball->SetOrientation(GetOrientation());
 	return fire_ball;
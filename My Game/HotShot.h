@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Object.h"
 
 class HotShot : public CObject
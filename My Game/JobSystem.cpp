@@ -0,0 +1,250 @@
+/// \file JobSystem.cpp
+/// \brief Code for the job system CJobSystem.
+
+#include "JobSystem.h"
+
+static thread_local UINT g_nThread = 0; ///< Index of the current thread's deque, 0 for the main thread.
+
+/// Start the worker threads.
+/// \param threads Number of worker threads, or 0 for one per core
+///   apart from the one the main thread is on.
+
+CJobSystem::CJobSystem(UINT threads):
+  m_nReady(0), m_nUnfinished(0), m_bQuit(false)
+{
+  if(threads == 0){
+    const UINT cores = thread::hardware_concurrency();
+    threads = cores > 1? cores - 1: 0;
+  } //if
+
+  m_vQueues = vector<CQueue>(threads + 1);
+
+  for(UINT i=1; i<=threads; i++)
+    m_vThreads.push_back(thread(&CJobSystem::Worker, this, i));
+} //constructor
+
+/// Stop the worker threads. Jobs still waiting are abandoned.
+
+CJobSystem::~CJobSystem(){
+  {
+    lock_guard<mutex> lock(m_mtxSleep);
+    m_bQuit = true;
+  }
+
+  m_cvWake.notify_all();
+
+  for(auto& t: m_vThreads)
+    t.join();
+} //destructor
+
+/// Body of a worker thread. Run jobs until told to quit,
+/// sleeping while there are none.
+/// \param index Index of this thread's deque.
+
+void CJobSystem::Worker(UINT index){
+  g_nThread = index;
+
+  while(!m_bQuit){
+    if(!RunOne()){
+      unique_lock<mutex> lock(m_mtxSleep);
+      m_cvWake.wait(lock, [&](){return m_bQuit || m_nReady > 0;});
+    } //if
+  } //while
+} //Worker
+
+/// Put a job that is ready to run on the back of this thread's deque.
+/// \param id The job.
+
+void CJobSystem::Push(JobId id){
+  CQueue& q = m_vQueues[g_nThread];
+
+  {
+    lock_guard<mutex> lock(q.m_mtxLock);
+    q.m_dqJobs.push_back(id);
+  }
+
+  {
+    lock_guard<mutex> lock(m_mtxSleep);
+    m_nReady++;
+  }
+
+  m_cvWake.notify_one();
+} //Push
+
+/// Take the newest job from the back of this thread's deque, or
+/// if that is empty, steal the oldest job from another thread's.
+/// \param id [out] The job.
+/// \return true if a job was found.
+
+bool CJobSystem::Pop(JobId& id){
+  const UINT n = (UINT)m_vQueues.size();
+
+  for(UINT k=0; k<n; k++){
+    const UINT i = (g_nThread + k)%n;
+    CQueue& q = m_vQueues[i];
+    lock_guard<mutex> lock(q.m_mtxLock);
+
+    if(!q.m_dqJobs.empty()){
+      if(k == 0){ //own deque, newest first
+        id = q.m_dqJobs.back();
+        q.m_dqJobs.pop_back();
+      } //if
+
+      else{ //steal, oldest first
+        id = q.m_dqJobs.front();
+        q.m_dqJobs.pop_front();
+      } //else
+
+      m_nReady--;
+      return true;
+    } //if
+  } //for
+
+  return false;
+} //Pop
+
+/// Run one job that is ready, if there is one.
+/// \return true if a job was run.
+
+bool CJobSystem::RunOne(){
+  JobId id;
+  if(!Pop(id))return false;
+
+  CJob* job;
+
+  {
+    lock_guard<mutex> lock(m_mtxGraph);
+    job = &m_dqJobs[id];
+  }
+
+  job->m_fnTask();
+  Finish(id);
+  return true;
+} //RunOne
+
+/// Mark a job finished and push any dependents that were
+/// waiting only for it.
+/// \param id The job.
+
+void CJobSystem::Finish(JobId id){
+  vector<JobId> released;
+
+  {
+    lock_guard<mutex> lock(m_mtxGraph);
+    CJob& job = m_dqJobs[id];
+    job.m_bFinished = true;
+
+    for(JobId d: job.m_vDependents)
+      if(--m_dqJobs[d].m_nWaiting == 0)
+        released.push_back(d);
+  }
+
+  for(JobId d: released)
+    Push(d);
+
+  m_nUnfinished--;
+} //Finish
+
+/// Add a job. It runs once every job that it waits for has finished,
+/// immediately if there are none.
+/// \param task What to do.
+/// \param after Jobs that must finish first.
+/// \return Handle for the job.
+
+JobId CJobSystem::Submit(const function<void()>& task, const vector<JobId>& after){
+  JobId id;
+  bool ready;
+
+  m_nUnfinished++;
+
+  {
+    lock_guard<mutex> lock(m_mtxGraph);
+    id = (JobId)m_dqJobs.size();
+    m_dqJobs.emplace_back();
+
+    CJob& job = m_dqJobs.back();
+    job.m_fnTask = task;
+    job.m_nWaiting = 0;
+    job.m_bFinished = false;
+
+    for(JobId a: after)
+      if(!m_dqJobs[a].m_bFinished){
+        m_dqJobs[a].m_vDependents.push_back(id);
+        job.m_nWaiting++;
+      } //if
+
+    ready = job.m_nWaiting == 0;
+  }
+
+  if(ready)
+    Push(id);
+
+  return id;
+} //Submit
+
+/// Wait for a job to finish, running other jobs in the meantime.
+/// \param id The job.
+
+void CJobSystem::Wait(JobId id){
+  CJob* job;
+
+  {
+    lock_guard<mutex> lock(m_mtxGraph);
+    job = &m_dqJobs[id];
+  }
+
+  while(!job->m_bFinished)
+    if(!RunOne())
+      this_thread::yield();
+} //Wait
+
+/// Wait for every job to finish, then throw away the finished jobs.
+/// Job handles are not valid after this. Call it from the main thread
+/// at a point where no more jobs are being submitted, such as the end
+/// of a frame.
+
+void CJobSystem::WaitAll(){
+  while(m_nUnfinished > 0)
+    if(!RunOne())
+      this_thread::yield();
+
+  lock_guard<mutex> lock(m_mtxGraph);
+  m_dqJobs.clear();
+} //WaitAll
+
+/// Run a loop in parallel and wait for it to finish. The index range
+/// is cut into chunks of a fixed size, so the same chunks are made
+/// however many threads there are. Work that gathers results per chunk
+/// and merges them in chunk order therefore gets the same answer on
+/// any machine.
+/// \param n Number of iterations.
+/// \param grain Iterations per chunk.
+/// \param body Function that runs the iterations from its first argument
+///   up to but not including its second.
+
+void CJobSystem::ParallelFor(UINT n, UINT grain, const function<void(UINT, UINT)>& body){
+  if(n == 0)return;
+  grain = max(grain, 1U);
+
+  if(m_vThreads.empty() || n <= grain){ //not worth it
+    body(0, n);
+    return;
+  } //if
+
+  vector<JobId> chunks;
+
+  for(UINT i=0; i<n; i+=grain){
+    const UINT j = min(i + grain, n);
+    chunks.push_back(Submit([&body, i, j](){body(i, j);}));
+  } //for
+
+  for(JobId id: chunks)
+    Wait(id);
+} //ParallelFor
+
+/// Reader function for the number of threads.
+/// \return Number of threads that run jobs, including the main thread.
+
+UINT CJobSystem::GetNumThreads() const{
+  return (UINT)m_vThreads.size() + 1;
+} //GetNumThreads
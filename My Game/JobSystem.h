@@ -0,0 +1,79 @@
+/// \file JobSystem.h
+/// \brief Interface for the job system CJobSystem.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+typedef UINT JobId; ///< Handle for a job, valid until the next WaitAll().
+
+/// \brief The job system.
+///
+/// The job system keeps one worker thread per spare core. Each worker,
+/// and the main thread, has its own deque of jobs that are ready to run.
+/// A thread pushes and pops jobs at the back of its own deque, so it
+/// tends to work on what it just created while that is still in cache,
+/// and when its deque is empty it steals from the front of another's.
+///
+/// A job can be made to wait for other jobs to finish. It only goes onto
+/// a deque once all of them have, so chains of work can be submitted up
+/// front without blocking. A thread that waits for a job runs other jobs
+/// in the meantime, so waiting inside a job does not deadlock.
+
+class CJobSystem{
+  private:
+    /// \brief A job.
+
+    struct CJob{
+      function<void()> m_fnTask; ///< What to do.
+      atomic<int> m_nWaiting; ///< Number of unfinished jobs that this one waits for.
+      atomic<bool> m_bFinished; ///< Whether the task has run.
+      vector<JobId> m_vDependents; ///< Jobs waiting for this one.
+    }; //CJob
+
+    /// \brief A worker's deque of jobs ready to run.
+
+    struct CQueue{
+      mutex m_mtxLock; ///< Guards the deque.
+      deque<JobId> m_dqJobs; ///< Jobs ready to run.
+    }; //CQueue
+
+    deque<CJob> m_dqJobs; ///< All jobs since the last WaitAll(), indexed by JobId.
+    mutex m_mtxGraph; ///< Guards m_dqJobs and the dependency lists.
+
+    vector<thread> m_vThreads; ///< Worker threads.
+    vector<CQueue> m_vQueues; ///< Ready jobs, one deque per thread, main thread first.
+
+    mutex m_mtxSleep; ///< Guards sleeping.
+    condition_variable m_cvWake; ///< Wakes sleeping workers.
+    atomic<int> m_nReady; ///< Number of jobs on deques.
+    atomic<int> m_nUnfinished; ///< Number of jobs not yet finished.
+    atomic<bool> m_bQuit; ///< Tells workers to exit.
+
+    void Worker(UINT index); ///< Worker thread body.
+    void Push(JobId id); ///< Put a ready job on this thread's deque.
+    bool Pop(JobId& id); ///< Get a job from this thread's deque or steal one.
+    bool RunOne(); ///< Run one ready job, if there is one.
+    void Finish(JobId id); ///< Mark a job finished and release its dependents.
+
+  public:
+    CJobSystem(UINT threads=0); ///< Constructor.
+    ~CJobSystem(); ///< Destructor.
+
+    JobId Submit(const function<void()>& task, const vector<JobId>& after={}); ///< Add a job.
+    void Wait(JobId id); ///< Wait for a job to finish.
+    void WaitAll(); ///< Wait for every job and recycle job storage.
+
+    void ParallelFor(UINT n, UINT grain, const function<void(UINT, UINT)>& body); ///< Run a loop in parallel.
+    UINT GetNumThreads() const; ///< Number of threads, including the main thread.
+}; //CJobSystem
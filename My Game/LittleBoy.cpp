@@ -1,4 +1,5 @@
 #include "LittleBoy.h"
+#include "ObjectManager.h"
 
 LittleBoy::LittleBoy( const Vector2& v ) //Default Constructor
 {
@@ -6,16 +7,8 @@ LittleBoy::LittleBoy( const Vector2& v ) //Default Constructor
 	m_nSpriteIndex = LILBOY;
 	m_vPos = v;
 	SetSpeed(400.0f);
-	m_pRenderer->GetSize(m_nSpriteIndex, m_vRadius.x, m_vRadius.y);
-	m_vRadius *= 0.5f;
-
-	const Vector2 topleft(-m_vRadius.x, m_vRadius.y);
-	const Vector2 bottomrt(m_vRadius.x, -m_vRadius.y);
-
-	m_Sphere.Radius = max(m_vRadius.x, m_vRadius.y);
-	m_Sphere.Center = (Vector3)m_vPos;
-
-	m_fGunTimer = m_pStepTimer->GetTotalSeconds();
+	FitSphere();
+	Attach(BOSS_EXTRA);
 	m_bStrafeBack = true;
 	m_bStrafeRight = m_bStrafeLeft = false;
 }
@@ -31,17 +24,16 @@ void LittleBoy::move() //Movement for LittleBoy
 	// else change speed
 	else
 	{
-		int speed_manip = rand() % 20;
+		int speed_manip = m_pGameRandom->rand() % 20;
 		if (speed_manip < 3)
 			SetSpeed(50.0f);
 		else
 			SetSpeed(400.0f);
 	}
 
-	m_vOldPos = m_vPos;
 	const Vector2 pos = GetPos();
 	const Vector2 front = GetViewVector();
-	const float time = m_pStepTimer->GetElapsedSeconds();
+	const float time = m_pSimTimer->GetElapsedSeconds();
 	const Vector2 side_velocity = Vector2(front.y, -front.x);
 	const float displacement = m_fSpeed * time;
 	//Littleboy quickly moves back and forth nonstop
@@ -84,7 +76,7 @@ CObject* LittleBoy::Attack1(const Vector2& v) //Signature move, LILBOMB
 
 CObject* LittleBoy::FireGun() //Littleboy fires gun
 {
-	int n1 = rand() % 10; //Number to determine color of bullets
+	int n1 = m_pGameRandom->rand() % 10; //Number to determine color of bullets
 	Vector2 pos = GetPos() - 0.5f * GetViewVector() * m_pRenderer->GetWidth(m_nSpriteIndex);
 	CObject* bullet1;
 	if (n1 < 5) //If n1 is less than 5 it is a blue bullet. It will be a red bullet otherwise.
@@ -92,7 +84,7 @@ CObject* LittleBoy::FireGun() //Littleboy fires gun
 	else
 		bullet1 = new CObject(RED_BULLET,pos);
 
-	Vector2 aim = m_pPlayer->GetPos() - GetPos();
+	Vector2 aim = m_pObjectManager->NearestPlayer(GetPos())->GetPos() - GetPos();
 	bullet1->SetVelocity((Vector2(0.0f, -700.0f) + aim) * .25);
 	switch (nbullets) //Makes sure all 3 bullets dont spawn at the same place
 	{
@@ -113,4 +105,25 @@ CObject* LittleBoy::FireGun() //Littleboy fires gun
 		break;
 	}
 	return bullet1;
-}
\ No newline at end of file
+}
+
+void LittleBoy::Hash(CStateHash& hash) //hash simulation state, including which bullet spread fires next
+{
+	CObject::Hash(hash);
+	hash.Add(nbullets);
+}
+
+void LittleBoy::Save(CSnapshot& s) //save simulation state, including which bullet spread fires next
+{
+	CObject::Save(s);
+	s.Write(nbullets);
+}
+
+bool LittleBoy::Load(CSnapshot& s) //load simulation state, including which bullet spread fires next
+{
+	if (!CObject::Load(s))
+		return false;
+
+	s.Read(nbullets);
+	return true;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Object.h"
 
 class LittleBoy : public CObject 
@@ -9,4 +11,7 @@ public:
 	virtual void move(); //Movement for LittleBoy
 	virtual CObject* Attack1(const Vector2& v); //Signature move
 	virtual CObject* FireGun(); //Fire regular weapon
+	virtual void Hash(CStateHash& hash); //hash simulation state
+	virtual void Save(CSnapshot& s); //save simulation state
+	virtual bool Load(CSnapshot& s); //load simulation state
 };
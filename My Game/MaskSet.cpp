@@ -0,0 +1,210 @@
+/// \file MaskSet.cpp
+/// \brief Code for the pixel collision masks CMaskSet.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "MaskSet.h"
+#include "Snapshot.h"
+
+static const UINT MASK_TAG = 0x4B534D55; ///< "UMSK", marks the start of a mask file.
+static const UINT MASK_VERSION = 1; ///< Version of the mask file layout.
+
+/// \brief The name in the sprite settings of each sprite type that
+/// has masks. Sprites in the mask file that are not in here are ignored.
+
+static const struct{
+  eSpriteType m_nType; ///< Sprite type.
+  const char* m_pName; ///< Name in the sprite settings.
+} MASK_NAMES[] = {
+  {BLUE_SHIP, "BLUE_SHIP"},
+  {RED_SHIP, "RED_SHIP"},
+  {RED_LIGHT_ENEMY, "RED_LIGHT_ENEMY"},
+  {BLUE_LIGHT_ENEMY, "BLUE_LIGHT_ENEMY"},
+  {RED_HEAVY_ENEMY, "RED_HEAVY_ENEMY"},
+  {BLUE_HEAVY_ENEMY, "BLUE_HEAVY_ENEMY"},
+  {HOTSHOT, "HOTSHOT"},
+  {LILBOY, "LILBOY"},
+  {BLACK_JACK, "BLACK_JACK"},
+  {RED_BULLET, "bullet2"},
+  {BLUE_BULLET, "BLUE_BULLET"},
+  {FIREBALL, "FIREBALL"},
+}; //MASK_NAMES
+
+/// Start with no masks.
+
+CMaskSet::CMaskSet(){
+  memset(m_nFirst, 0, sizeof(m_nFirst));
+  memset(m_nCount, 0, sizeof(m_nCount));
+} //constructor
+
+/// Load the masks from a file made by Tools/make_masks.py. The whole
+/// file is read into memory, then the masks are copied into the arena
+/// in one go and the frames are checked against it, so that a bad
+/// file cannot send Overlap() outside the arena. If anything is wrong
+/// with the file then no sprite type has a mask.
+/// \param filename Name of the mask file.
+/// \return true if the masks were loaded.
+
+bool CMaskSet::Load(const char* filename){
+  memset(m_nCount, 0, sizeof(m_nCount));
+  m_vFrames.clear();
+  m_vArena.clear();
+
+  ifstream in(filename, ios::binary);
+  if(!in.is_open())return false;
+
+  const vector<char> file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  CSnapshot s;
+  s.SetData(file.data(), file.size());
+
+  UINT tag = 0, version = 0, scale = 0, sprites = 0;
+  s.Read(tag);
+  s.Read(version);
+  s.Read(scale);
+  s.Read(sprites);
+
+  if(tag != MASK_TAG || version != MASK_VERSION || scale == 0 || sprites > file.size())
+    return false;
+
+  UINT first[NUM_SPRITES] = {0}, count[NUM_SPRITES] = {0};
+
+  for(UINT i=0; i<sprites; i++){
+    BYTE length = 0;
+    s.Read(length);
+
+    string name(length, '\0');
+    s.Read(&name[0], length);
+
+    UINT frames = 0;
+    s.Read(frames);
+    if(frames > file.size())return false;
+
+    int t = -1; //sprite type, if it is one that has masks
+
+    for(auto const& m: MASK_NAMES)
+      if(name == m.m_pName)t = m.m_nType;
+
+    if(t >= 0){
+      first[t] = (UINT)m_vFrames.size();
+      count[t] = frames;
+    } //if
+
+    for(UINT f=0; f<frames; f++){
+      Frame frame;
+      s.Read(frame.m_nWidth);
+      s.Read(frame.m_nHeight);
+      s.Read(frame.m_nColumns);
+      s.Read(frame.m_nRows);
+      s.Read(frame.m_nOffset);
+      m_vFrames.push_back(frame);
+    } //for
+  } //for
+
+  UINT words = 0;
+  s.Read(words);
+  if((size_t)words*sizeof(UINT64) > file.size())return false;
+
+  m_vArena.resize(words);
+  s.Read(m_vArena.data(), words*sizeof(UINT64));
+
+  for(auto const& f: m_vFrames){ //every mask must fit in the arena
+    const size_t size = (size_t)f.m_nRows*((f.m_nColumns + 63)/64);
+
+    if((size_t)f.m_nOffset + size > m_vArena.size()){
+      m_vFrames.clear();
+      m_vArena.clear();
+      return false;
+    } //if
+  } //for
+
+  memcpy(m_nFirst, first, sizeof(m_nFirst));
+  memcpy(m_nCount, count, sizeof(m_nCount));
+  m_fScale = (float)scale;
+
+  return true;
+} //Load
+
+/// Check whether a sprite type has masks.
+/// \param t Sprite type.
+/// \return true if it has masks.
+
+bool CMaskSet::HasMask(int t) const{
+  return t >= 0 && t < NUM_SPRITES && m_nCount[t] > 0;
+} //HasMask
+
+/// Get the mask of a frame of a sprite. Frame numbers past the
+/// last mask wrap around, in case the art has changed since the
+/// masks were made.
+/// \param t Sprite type, which must have masks.
+/// \param frame Frame number.
+/// \return The frame's mask.
+
+const CMaskSet::Frame& CMaskSet::GetFrame(int t, UINT frame) const{
+  return m_vFrames[m_nFirst[t] + frame%m_nCount[t]];
+} //GetFrame
+
+/// Get 64 bits of a mask row, starting at any column. Columns off
+/// either end of the row are clear.
+/// \param row Pointer to the first word of the row.
+/// \param words Number of words in the row.
+/// \param k Column of the first bit wanted, which may be negative.
+/// \return Columns k to k + 63, with column k in the low bit.
+
+static UINT64 RowBits(const UINT64* row, int words, int k){
+  if(k <= -64 || k >= 64*words)return 0;
+  if(k < 0)return row[0] << -k;
+
+  const int q = k >> 6, s = k & 63;
+  UINT64 bits = row[q] >> s;
+  if(s > 0 && q + 1 < words)bits |= row[q + 1] << (64 - s);
+
+  return bits;
+} //RowBits
+
+/// Test whether two sprites touch, that is, whether their masks have
+/// a set bit in the same place. The second mask is placed over the
+/// first to the nearest mask bit, and then each row where they overlap
+/// is tested a word of the first mask at a time against the bits of
+/// the second mask shifted to line up with it. The first set bit in
+/// common ends the test. Sprites are drawn centered on their position,
+/// and the rows of a mask go from the top of the sprite down.
+/// \param t0 First sprite type, which must have masks.
+/// \param f0 First sprite's frame number.
+/// \param p0 First sprite's position.
+/// \param t1 Second sprite type, which must have masks.
+/// \param f1 Second sprite's frame number.
+/// \param p1 Second sprite's position.
+/// \return true if the sprites touch.
+
+bool CMaskSet::Overlap(int t0, UINT f0, const Vector2& p0, int t1, UINT f1, const Vector2& p1) const{
+  const Frame& a = GetFrame(t0, f0);
+  const Frame& b = GetFrame(t1, f1);
+
+  const float left = (p1.x - 0.5f*b.m_nWidth) - (p0.x - 0.5f*a.m_nWidth); //second's left edge from the first's
+  const float down = (p0.y + 0.5f*a.m_nHeight) - (p1.y + 0.5f*b.m_nHeight); //second's top edge below the first's
+
+  const int dx = (int)floorf(left/m_fScale + 0.5f); //second's first column in the first
+  const int dy = (int)floorf(down/m_fScale + 0.5f); //second's first row in the first
+
+  const int r0 = max(0, dy), r1 = min((int)a.m_nRows, dy + (int)b.m_nRows); //rows in common
+  const int c0 = max(0, dx), c1 = min((int)a.m_nColumns, dx + (int)b.m_nColumns); //columns in common
+  if(r0 >= r1 || c0 >= c1)return false;
+
+  const int wa = (a.m_nColumns + 63)/64; //words per row
+  const int wb = (b.m_nColumns + 63)/64;
+
+  for(int r=r0; r<r1; r++){
+    const UINT64* rowa = &m_vArena[a.m_nOffset + (size_t)r*wa];
+    const UINT64* rowb = &m_vArena[b.m_nOffset + (size_t)(r - dy)*wb];
+
+    for(int w=c0 >> 6; w<=(c1 - 1) >> 6; w++)
+      if(rowa[w] & RowBits(rowb, wb, 64*w - dx))
+        return true;
+  } //for
+
+  return false;
+} //Overlap
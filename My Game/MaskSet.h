@@ -0,0 +1,56 @@
+/// \file MaskSet.h
+/// \brief Interface for the pixel collision masks CMaskSet.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "GameDefines.h"
+
+using namespace std;
+
+/// \brief Pixel collision masks for the sprites that collide.
+///
+/// A bounding circle is a poor fit for a ship with swept-back wings
+/// or a beam that is much longer than it is wide, so two objects whose
+/// circles touch may still be well apart on screen. A mask is one bit
+/// for each little square of a sprite frame, set where the art is
+/// solid, so two objects really touch only if their masks share a set
+/// bit where they overlap. Each row of a mask is packed into 64-bit
+/// words, so a whole row of one mask is tested against the other with
+/// a shift and an AND rather than bit by bit.
+///
+/// The masks are made offline by Tools/make_masks.py from the alpha
+/// channel of the images in the sprite settings, at a reduced
+/// resolution, and loaded once at startup into a single contiguous
+/// arena. Sprite types that have no masks, or a missing mask file,
+/// simply leave the bounding circles as the last word.
+
+class CMaskSet{
+  private:
+    /// \brief Where a frame's mask is in the arena, and its size.
+
+    struct Frame{
+      UINT16 m_nWidth; ///< Width of the frame in pixels.
+      UINT16 m_nHeight; ///< Height of the frame in pixels.
+      UINT16 m_nColumns; ///< Width of the mask in bits.
+      UINT16 m_nRows; ///< Height of the mask in rows.
+      UINT m_nOffset; ///< First word of the mask in the arena.
+    }; //Frame
+
+    vector<UINT64> m_vArena; ///< All of the masks, one after the other.
+    vector<Frame> m_vFrames; ///< All of the frames, sprite by sprite.
+    UINT m_nFirst[NUM_SPRITES]; ///< First frame of each sprite type.
+    UINT m_nCount[NUM_SPRITES]; ///< Number of frames of each sprite type, 0 for none.
+    float m_fScale = 1.0f; ///< Pixels per mask bit, across and down.
+
+    const Frame& GetFrame(int t, UINT frame) const; ///< Mask of a sprite frame.
+
+  public:
+    CMaskSet(); ///< Constructor.
+
+    bool Load(const char* filename); ///< Load the masks from a file.
+    bool HasMask(int t) const; ///< Whether a sprite type has a mask.
+    bool Overlap(int t0, UINT f0, const Vector2& p0, int t1, UINT f1, const Vector2& p1) const; ///< Test whether two sprites touch.
+}; //CMaskSet
@@ -0,0 +1,310 @@
+/// \file NetSession.cpp
+/// \brief Code for the co-op network session CNetSession.
+
+#include <winsock2.h> //before anything that includes windows.h
+#include <cstring>
+
+#include "NetSession.h"
+#include "ComponentIncludes.h"
+#include "GameDefines.h"
+#include "ObjectManager.h"
+
+#pragma comment(lib, "ws2_32.lib")
+
+static const UINT NET_TAG = 0x50504F43; ///< "COPP", marks a co-op packet.
+static const UINT16 NET_BYE = 1; ///< Packet flag, the sender has left the session.
+static const double NET_TIMEOUT = 5.0; ///< Seconds of silence before the peer is given up on.
+
+/// \brief Co-op packet header.
+///
+/// The header is followed by one byte of input for each of
+/// m_nCount ticks starting at m_nFrame.
+
+struct NetHeader{
+  UINT m_nTag; ///< NET_TAG.
+  UINT m_nFrame; ///< First tick of input in this packet.
+  UINT m_nAck; ///< Sender has our input for every tick before this.
+  UINT16 m_nCount; ///< Number of ticks of input in this packet.
+  UINT16 m_nFlags; ///< Flags, see NET_BYE.
+}; //NetHeader
+
+/// Make a loopback address.
+/// \param port Port number.
+/// \return The address.
+
+static sockaddr_in Loopback(UINT16 port){
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return a;
+} //Loopback
+
+/// End the session, if any.
+
+CNetSession::~CNetSession(){
+  Close();
+} //destructor
+
+/// Open a socket on the loopback interface and start a session. The
+/// simulation must be in the same state on both peers when they start,
+/// and the session begins with the peer's input unknown, so each side
+/// gets MAX_ROLLBACK ticks ahead and then waits for the other to start.
+/// \param port Local port.
+/// \param remote Peer's port.
+/// \param player Local player, 0 or 1.
+/// \return true if the socket could be opened.
+
+bool CNetSession::Open(UINT16 port, UINT16 remote, UINT player){
+  Close();
+
+  WSADATA wsa;
+  if(WSAStartup(MAKEWORD(2, 2), &wsa) != 0)return false;
+
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  const sockaddr_in local = Loopback(port);
+  u_long nonblocking = 1;
+
+  if(s == INVALID_SOCKET || bind(s, (const sockaddr*)&local, sizeof(local)) != 0 ||
+    ioctlsocket(s, FIONBIO, &nonblocking) != 0)
+  {
+    if(s != INVALID_SOCKET)closesocket(s);
+    WSACleanup();
+    return false;
+  } //if
+
+  m_nSocket = (UINT_PTR)s;
+  m_nRemotePort = remote;
+  m_nPlayer = player;
+
+  m_nFrame = m_nRemoteFrame = m_nAcked = m_nRollbackFrom = m_nShown = 0;
+  m_fLastHeard = -1.0; //not heard from yet
+  m_dqOutgoing.clear();
+
+  memset(m_pLocal, 0, sizeof(m_pLocal));
+  memset(m_pRemote, 0, sizeof(m_pRemote));
+  memset(m_pPredicted, 0, sizeof(m_pPredicted));
+
+  m_bActive = true;
+  return true;
+} //Open
+
+/// Tell the peer that we are leaving and close the socket.
+
+void CNetSession::Close(){
+  if(!m_bActive)return;
+  m_bActive = false;
+
+  const NetHeader bye = {NET_TAG, m_nFrame, m_nRemoteFrame, 0, NET_BYE};
+  const sockaddr_in to = Loopback(m_nRemotePort);
+  sendto((SOCKET)m_nSocket, (const char*)&bye, sizeof(bye), 0, (const sockaddr*)&to, sizeof(to));
+
+  closesocket((SOCKET)m_nSocket);
+  WSACleanup();
+  m_dqOutgoing.clear();
+} //Close
+
+/// Reader function for the active flag.
+/// \return true if a session is in progress.
+
+bool CNetSession::IsActive() const{
+  return m_bActive;
+} //IsActive
+
+/// Set the latency and packet loss that outgoing packets suffer,
+/// for testing on one machine.
+/// \param latency One-way latency in seconds.
+/// \param loss Fraction of packets dropped, from 0 to 1.
+
+void CNetSession::SetConditions(float latency, float loss){
+  m_fLatency = latency;
+  m_fLoss = loss;
+} //SetConditions
+
+/// Read every packet waiting on the socket. New remote input is
+/// stored, and if it differs from what was predicted for a tick that
+/// has already been simulated then that tick is noted for rollback.
+/// Packets can arrive out of order, so input that would leave a gap
+/// is ignored and picked up from a later packet.
+
+void CNetSession::Receive(){
+  char buffer[sizeof(NetHeader) + INPUT_HISTORY];
+  NetHeader h;
+  int n = 0;
+
+  m_nRollbackFrom = m_nFrame; //no rollback
+
+  while((n = recv((SOCKET)m_nSocket, buffer, sizeof(buffer), 0)) >= (int)sizeof(NetHeader)){
+    memcpy(&h, buffer, sizeof(h));
+
+    if(h.m_nTag != NET_TAG || n < (int)sizeof(h) + h.m_nCount)
+      continue;
+
+    m_fLastHeard = m_pStepTimer->GetTotalSeconds();
+
+    if(h.m_nFlags & NET_BYE){ //peer has left
+      Close();
+      return;
+    } //if
+
+    m_nAcked = max(m_nAcked, h.m_nAck);
+
+    for(UINT i=0; i<h.m_nCount; i++){
+      const UINT f = h.m_nFrame + i;
+      if(f < m_nRemoteFrame)continue; //already known
+      if(f > m_nRemoteFrame)break; //gap
+
+      const BYTE input = (BYTE)buffer[sizeof(h) + i];
+      m_pRemote[f%INPUT_HISTORY] = input;
+      m_nRemoteFrame++;
+
+      if(f < m_nFrame && m_pPredicted[f%INPUT_HISTORY] != input)
+        m_nRollbackFrom = min(m_nRollbackFrom, f);
+    } //for
+  } //while
+} //Receive
+
+/// Send the peer every tick of local input that it has not
+/// acknowledged, along with our own acknowledgement. Packets go
+/// through the simulated network if conditions have been set.
+
+void CNetSession::Send(){
+  const UINT count = min(m_nFrame - m_nAcked, INPUT_HISTORY);
+  const NetHeader h = {NET_TAG, m_nFrame - count, m_nRemoteFrame, (UINT16)count, 0};
+
+  vector<char> packet(sizeof(h) + count);
+  memcpy(packet.data(), &h, sizeof(h));
+
+  for(UINT i=0; i<count; i++)
+    packet[sizeof(h) + i] = (char)m_pLocal[(h.m_nFrame + i)%INPUT_HISTORY];
+
+  if(m_fLoss > 0 && m_pRandom->randf() < m_fLoss)
+    return; //lost
+
+  m_dqOutgoing.push_back(make_pair(m_pStepTimer->GetTotalSeconds() + m_fLatency, move(packet)));
+} //Send
+
+/// Send the delayed packets that are due.
+
+void CNetSession::Flush(){
+  const double t = m_pStepTimer->GetTotalSeconds();
+  const sockaddr_in to = Loopback(m_nRemotePort);
+
+  while(!m_dqOutgoing.empty() && m_dqOutgoing.front().first <= t){
+    const vector<char>& packet = m_dqOutgoing.front().second;
+    sendto((SOCKET)m_nSocket, packet.data(), (int)packet.size(), 0, (const sockaddr*)&to, sizeof(to));
+    m_dqOutgoing.pop_front();
+  } //while
+} //Flush
+
+/// Get the remote input for a tick. If it has not arrived then the
+/// remote player is predicted to hold the same buttons as last time,
+/// but not to press fire or color change again.
+/// \param frame Tick number.
+/// \return Remote input bits.
+
+UINT CNetSession::Predict(UINT frame){
+  if(frame < m_nRemoteFrame)
+    return m_pRemote[frame%INPUT_HISTORY];
+
+  if(m_nRemoteFrame == 0)
+    return 0;
+
+  return m_pRemote[(m_nRemoteFrame - 1)%INPUT_HISTORY] & ~(INPUT_FIRE | INPUT_COLOR);
+} //Predict
+
+/// Combine local and remote input into input for both players,
+/// player 1 in the low bits and player 2 above them.
+/// \param local Local input bits.
+/// \param remote Remote input bits.
+/// \return Input bits for both players.
+
+UINT CNetSession::Combine(UINT local, UINT remote){
+  if(m_nPlayer == 0)
+    return local | (remote << INPUT_PLAYER2_SHIFT);
+  else return remote | (local << INPUT_PLAYER2_SHIFT);
+} //Combine
+
+/// Save the state and simulate one tick with the best input known.
+/// The lengths of the event queue and the chain event log are saved
+/// with the state, so that a rollback can take back the tick's events.
+/// \param frame Tick number.
+/// \param tick Function that simulates one tick given input for both players.
+
+void CNetSession::Simulate(UINT frame, const function<void(UINT)>& tick){
+  const UINT i = frame%(MAX_ROLLBACK + 1);
+  m_pObjectManager->Snapshot(m_pSaved[i]);
+  m_pQueued[i] = m_pEventQueue->GetSize();
+  m_pLogged[i] = m_pObjectManager->GetChain().GetEvents().size();
+
+  const UINT remote = Predict(frame);
+  m_pPredicted[frame%INPUT_HISTORY] = (BYTE)remote;
+
+  tick(Combine(m_pLocal[frame%INPUT_HISTORY], remote));
+} //Simulate
+
+/// Advance the session by one tick. Remote input is read first and
+/// any ticks that were simulated with a wrong prediction are rolled
+/// back and simulated again. Then the next tick is simulated, unless
+/// that would take the simulation too far ahead of the remote input.
+/// A tick that is simulated again must not be heard twice. The events
+/// of the ticks that have not been shown yet are still queued, so they
+/// are taken back and asked for again. Those of the ticks that have
+/// been shown are already playing, so the events from simulating
+/// them again are thrown away.
+/// \param input Local player input bits.
+/// \param tick Function that simulates one tick given input for both players.
+/// \return true if the tick was simulated, false if it has to wait.
+
+bool CNetSession::Tick(UINT input, const function<void(UINT)>& tick){
+  if(!m_bActive)return false;
+
+  Receive();
+  if(!m_bActive)return false;
+
+  if(m_nRollbackFrom < m_nFrame){ //misprediction, roll back
+    const UINT shown = max(m_nRollbackFrom, m_nShown); //first tick not yet shown
+    CChain& chain = m_pObjectManager->GetChain();
+
+    if(shown < m_nFrame){ //take back events of ticks not yet shown
+      m_pEventQueue->Truncate(m_pQueued[shown%(MAX_ROLLBACK + 1)]);
+      chain.TruncateEvents(m_pLogged[shown%(MAX_ROLLBACK + 1)]);
+    } //if
+
+    const size_t queued = m_pEventQueue->GetSize();
+    const size_t logged = chain.GetEvents().size();
+    m_pObjectManager->Restore(m_pSaved[m_nRollbackFrom%(MAX_ROLLBACK + 1)]);
+
+    for(UINT f=m_nRollbackFrom; f<m_nFrame; f++){
+      Simulate(f, tick);
+
+      if(f + 1 == shown){ //ticks already shown are not heard twice
+        m_pEventQueue->Truncate(queued);
+        chain.TruncateEvents(logged);
+      } //if
+    } //for
+  } //if
+
+  const bool advance = m_nFrame < m_nRemoteFrame + MAX_ROLLBACK &&
+    m_nFrame < m_nAcked + INPUT_HISTORY;
+
+  if(advance){
+    m_pLocal[m_nFrame%INPUT_HISTORY] = (BYTE)input;
+    Simulate(m_nFrame++, tick);
+  } //if
+
+  Send();
+  Flush();
+
+  if(m_fLastHeard >= 0.0 && m_pStepTimer->GetTotalSeconds() - m_fLastHeard > NET_TIMEOUT)
+    Close(); //peer has gone quiet
+
+  return advance;
+} //Tick
+
+/// Note that a render snapshot has been published, taking the events
+/// of every tick simulated so far with it.
+
+void CNetSession::Shown(){
+  m_nShown = m_nFrame;
+} //Shown
@@ -0,0 +1,83 @@
+/// \file NetSession.h
+/// \brief Interface for the co-op network session CNetSession.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "Component.h"
+#include "Common.h"
+#include "Defines.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+static const UINT MAX_ROLLBACK = 8; ///< Most ticks the simulation may run ahead of the remote input.
+static const UINT INPUT_HISTORY = 64; ///< Size of the input ring buffers, a power of 2.
+
+/// \brief A two-player co-op session.
+///
+/// Each peer runs the whole simulation and sends its player's input
+/// for every tick to the other over UDP. A tick is not held up waiting
+/// for remote input. Instead the remote player is predicted to keep
+/// doing what they did last, and the state before each tick is saved.
+/// When the real remote input arrives and differs from the prediction,
+/// the state is restored to before the first wrong tick and the ticks
+/// since are simulated again with the right input. The simulation is
+/// allowed to get MAX_ROLLBACK ticks ahead of the remote input, after
+/// which it stalls until more arrives, so a rollback never has to
+/// re-simulate more than that many ticks.
+///
+/// Every packet carries all of the local input that the peer has not
+/// yet acknowledged, so a lost packet is made good by the next one.
+/// For testing on one machine the session can delay and drop its own
+/// outgoing packets to stand in for a real network.
+
+class CNetSession:
+  public CComponent,
+  public CCommon{
+
+  private:
+    UINT_PTR m_nSocket = ~(UINT_PTR)0; ///< UDP socket.
+    UINT16 m_nRemotePort = 0; ///< Peer's port on the loopback interface.
+    bool m_bActive = false; ///< Whether a session is in progress.
+    UINT m_nPlayer = 0; ///< Local player, 0 or 1.
+
+    UINT m_nFrame = 0; ///< Next tick to simulate.
+    UINT m_nRemoteFrame = 0; ///< Remote input is known for every tick before this.
+    UINT m_nAcked = 0; ///< Peer has our input for every tick before this.
+    UINT m_nRollbackFrom = 0; ///< Earliest tick simulated with a wrong prediction.
+    UINT m_nShown = 0; ///< Events of every tick before this have been handed to the main thread.
+    double m_fLastHeard = 0; ///< Time the peer was last heard from.
+
+    BYTE m_pLocal[INPUT_HISTORY]; ///< Local input by tick.
+    BYTE m_pRemote[INPUT_HISTORY]; ///< Known remote input by tick.
+    BYTE m_pPredicted[INPUT_HISTORY]; ///< Remote input used by tick.
+    CSnapshot m_pSaved[MAX_ROLLBACK + 1]; ///< State before each recent tick.
+    size_t m_pQueued[MAX_ROLLBACK + 1]; ///< Length of the event queue before each recent tick.
+    size_t m_pLogged[MAX_ROLLBACK + 1]; ///< Length of the chain event log before each recent tick.
+
+    float m_fLatency = 0; ///< Simulated one-way latency in seconds.
+    float m_fLoss = 0; ///< Simulated packet loss, fraction of packets.
+    deque<pair<double, vector<char>>> m_dqOutgoing; ///< Delayed packets and when to send them.
+
+    void Receive(); ///< Read packets from the peer.
+    void Send(); ///< Send unacknowledged input to the peer.
+    void Flush(); ///< Send delayed packets whose time has come.
+    UINT Predict(UINT frame); ///< Remote input to use for a tick.
+    UINT Combine(UINT local, UINT remote); ///< Input for both players.
+    void Simulate(UINT frame, const function<void(UINT)>& tick); ///< Simulate one tick.
+
+  public:
+    ~CNetSession(); ///< Destructor.
+
+    bool Open(UINT16 port, UINT16 remote, UINT player); ///< Start a session.
+    void Close(); ///< End the session.
+    bool IsActive() const; ///< Whether a session is in progress.
+
+    void SetConditions(float latency, float loss); ///< Set simulated network conditions.
+    bool Tick(UINT input, const function<void(UINT)>& tick); ///< Advance one tick.
+    void Shown(); ///< Note that the events of every tick so far have been handed over.
+}; //CNetSession
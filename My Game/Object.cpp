@@ -8,6 +8,22 @@
 #include "ParticleEngine.h"
 #include "ObjectManager.h"  // using this for enemyHit function
 
+static const float FRAME_INTERVAL = 0.1f; ///< Interval between animation frames.
+static const float EXPLOSION_LIFE = 0.5f; ///< Explosion animation lifespan in seconds.
+
+/// Get the kind of optional state that a sprite type needs.
+/// \param t Sprite type.
+/// \return Kind of optional state.
+
+static eExtraType ExtraType(int t){
+  switch(t){
+    case BLUE_SHIP: case RED_SHIP: return SHIP_EXTRA;
+    case HOTSHOT: case LILBOY: case BLACK_JACK: return BOSS_EXTRA;
+    case CARD: case QUEEN: case JACK: return CARD_EXTRA;
+    case SMALL_EXPLOSION: return EXPLOSION_EXTRA;
+    default: return NO_EXTRA;
+  } //switch
+} //ExtraType
 
 // default constructor
 CObject::CObject() :
@@ -22,50 +38,133 @@ CObject::CObject() :
 CObject::CObject(eSpriteType t, const Vector2& p){ 
   m_nSpriteIndex = t;
   m_vPos = p;
-  explosionBirthTime = m_pStepTimer->GetTotalSeconds(); // gets when explosion is created
+  m_vOldPos = p; //so that a new object is not drawn sliding in from the origin
+  Attach(ExtraType(t));
 
-  m_pRenderer->GetSize(t, m_vRadius.x, m_vRadius.y);
-  m_vRadius *= 0.5f;
-  
-  const Vector2 topleft(-m_vRadius.x, m_vRadius.y);
-  const Vector2 bottomrt(m_vRadius.x, -m_vRadius.y);
+  if(m_nExtra == EXPLOSION_EXTRA)
+    m_pExplosion->m_fBirthTime = m_pSimTimer->GetTotalSeconds(); // gets when explosion is created
 
-  m_Sphere.Radius = max(m_vRadius.x, m_vRadius.y);
-  m_Sphere.Center = (Vector3)m_vPos;
-  
-  m_fGunTimer = m_pStepTimer->GetTotalSeconds();
+  FitSphere();
 
   if (m_nSpriteIndex == FORCE_FIELD) //force field has 10 health
       m_fHealth = 10;
   if (m_nSpriteIndex == CARD) { //If card randomly choose which type it will be: queen or jack
       m_fHealth = 3;
-      int choose = rand() % 100;
+      int choose = m_pGameRandom->rand() % 100;
       if (choose <= 50)
-          reveal = QUEEN;
+          m_pCard->m_nReveal = QUEEN;
       else
-          reveal = JACK;
+          m_pCard->m_nReveal = JACK;
   }
 
 } //constructor
 
+/// Give back any optional state.
+
 CObject::~CObject() {
+  Detach();
 } //destructor
 
+/// Attach optional state from the right pool, in its initial condition.
+/// Any optional state of a different kind is given back first, and
+/// state of the same kind is kept as it is.
+/// \param t Kind of optional state.
+
+void CObject::Attach(eExtraType t){
+  if(m_nExtra == t)return;
+  Detach();
+
+  switch(t){
+    case SHIP_EXTRA: m_pShip = m_pExtraStore->m_cShips.Acquire(); break;
+    case BOSS_EXTRA: m_pBoss = m_pExtraStore->m_cBosses.Acquire(); break;
+    case CARD_EXTRA: m_pCard = m_pExtraStore->m_cCards.Acquire(); break;
+    case EXPLOSION_EXTRA: m_pExplosion = m_pExtraStore->m_cExplosions.Acquire(); break;
+    default: break;
+  } //switch
+
+  m_nExtra = (BYTE)t;
+} //Attach
+
+/// Give optional state back to the pool that it came from.
+
+void CObject::Detach(){
+  switch(m_nExtra){
+    case SHIP_EXTRA: m_pExtraStore->m_cShips.Release(m_pShip); break;
+    case BOSS_EXTRA: m_pExtraStore->m_cBosses.Release(m_pBoss); break;
+    case CARD_EXTRA: m_pExtraStore->m_cCards.Release(m_pCard); break;
+    case EXPLOSION_EXTRA: m_pExtraStore->m_cExplosions.Release(m_pExplosion); break;
+    default: break;
+  } //switch
+
+  m_nExtra = NO_EXTRA;
+  m_pShip = nullptr;
+} //Detach
+
+/// Reader function for the player ship state.
+/// \return Pointer to the player ship state, or nullptr if this is not a player ship.
+
+ShipState* CObject::GetShip(){
+  return m_nExtra == SHIP_EXTRA? m_pShip: nullptr;
+} //GetShip
+
+/// Reader function for the boss state.
+/// \return Pointer to the boss state, or nullptr if this is not a boss.
+
+BossState* CObject::GetBoss(){
+  return m_nExtra == BOSS_EXTRA? m_pBoss: nullptr;
+} //GetBoss
+
+/// Reader function for the card state.
+/// \return Pointer to the card state, or nullptr if this is not a card.
+
+CardState* CObject::GetCard(){
+  return m_nExtra == CARD_EXTRA? m_pCard: nullptr;
+} //GetCard
+
+/// Reader function for the explosion state.
+/// \return Pointer to the explosion state, or nullptr if this is not an explosion.
+
+ExplosionState* CObject::GetExplosion(){
+  return m_nExtra == EXPLOSION_EXTRA? m_pExplosion: nullptr;
+} //GetExplosion
+
+/// Fit the bounding sphere around the sprite, centered on the object.
+
+void CObject::FitSphere(){
+  float w, h; //sprite width and height
+  m_pRenderer->GetSize(m_nSpriteIndex, w, h);
+
+  m_Sphere.Radius = 0.5f*max(w, h);
+  m_Sphere.Center = (Vector3)m_vPos;
+} //FitSphere
+
+/// Move on to the next animation frame when it is time to.
+/// From Ned's Turkey Farm.
+
+void CObject::Animate(){
+  const size_t nFrameCount = m_pRenderer->GetNumFrames(m_nSpriteIndex); // nFrameCount = number of sprite's frames
+  const float dt = 1000.0f*FRAME_INTERVAL/1500.0f; // calculates animation speed
+
+  // calculates current frame
+  if (nFrameCount > 1 && m_pSimTimer->GetTotalSeconds() > m_fFrameTimer + dt) {
+      m_fFrameTimer = m_pSimTimer->GetTotalSeconds();
+      m_nCurrentFrame = (m_nCurrentFrame + 1) % nFrameCount;
+  }
+} //Animate
+
 /// Move and update all bounding shapes.
 /// The player object gets moved by the controller, everything
 /// else moves an amount that depends on its velocity and the
-/// frame time.
+/// frame time. The object manager has already saved the position
+/// in m_vOldPos, so overrides need not.
 
 void CObject::move(){
-  m_vOldPos = m_vPos;
-  
-  const float t = m_pStepTimer->GetElapsedSeconds();
+  const float t = m_pSimTimer->GetElapsedSeconds();
 
 //Player movement
   if(m_nSpriteIndex == BLUE_SHIP || m_nSpriteIndex == RED_SHIP){ //Move player object
     const Vector2 viewvec = GetViewVector();
     m_vPos += m_fSpeed*t*viewvec;
-    //m_fRoll += m_fRotSpeed*t;
     
     Vector2 norm(viewvec.y, -viewvec.x); 
     const float delta = 300.0f*t;
@@ -86,17 +185,7 @@ void CObject::move(){
   else m_vPos += m_vVelocity*t;
 
   m_Sphere.Center = (Vector3)m_vPos; //update bounding sphere
-
-  // Object animation. From Ned's Turkey Farm
-  const size_t nFrameCount = m_pRenderer->GetNumFrames(m_nSpriteIndex); // nFrameCount = number of sprite's frames
-  const float dt = 1000.0f * m_fFrameInterval / (1500.0f + fabsf(m_vVel.x));    // calculates animation speed
-
-  // calculates current frame
-  if (nFrameCount > 1 && m_pStepTimer->GetTotalSeconds() > m_fFrameTimer + dt) {
-      m_fFrameTimer = m_pStepTimer->GetTotalSeconds();
-      m_nCurrentFrame = (m_nCurrentFrame + 1) % nFrameCount;
-  }
-
+  Animate();
 } //move
 
 
@@ -104,7 +193,7 @@ void CObject::CollisionResponse() {
     Vector2 newPos;
     float width, height, x;
     m_pRenderer->GetSize(m_nSpriteIndex, width, height);
-    x = (float)(rand() % 700) + 200; //Choose random location to place enemy
+    x = (float)(m_pGameRandom->rand() % 700) + 200; //Choose random location to place enemy
     if (m_vPos.x + width < 0) { //Out of bounds on the left side of the screen
         newPos = Vector2(x, 500.0f);
     }
@@ -116,7 +205,7 @@ void CObject::CollisionResponse() {
     }
 
     if (m_nSpriteIndex == BLACK_JACK || m_nSpriteIndex == HOTSHOT) { //Respawn bosses with bigger portal sprite
-        m_pAudio->play(RESPAWN_SOUND);
+        m_pEventQueue->play(RESPAWN_SOUND);
         CParticleDesc2D spawn;
         spawn.m_nSpriteIndex = LARGE_RESPAWN;
         spawn.m_vPos = newPos;
@@ -129,13 +218,9 @@ void CObject::CollisionResponse() {
         m_vPos = newPos;
         UpdatePos();
         m_pParticleEngine->create(spawn);
-        if (force_field) {
-            force_field->m_vPos = newPos;
-            force_field->UpdatePos();
-        }
     } //smaller portal sprite
     else if (m_nSpriteIndex == BLUE_HEAVY_ENEMY || m_nSpriteIndex == BLUE_LIGHT_ENEMY || m_nSpriteIndex == RED_HEAVY_ENEMY || m_nSpriteIndex == RED_LIGHT_ENEMY) {
-        m_pAudio->play(RESPAWN_SOUND);
+        m_pEventQueue->play(RESPAWN_SOUND);
         CParticleDesc2D spawn;
         spawn.m_nSpriteIndex = SMALL_RESPAWN;
         spawn.m_vPos = newPos;
@@ -172,14 +257,16 @@ void CObject::StrafeBack(){
   m_bStrafeBack = true;
 } //StrafeBack
 
-//Set the Strafe foward Flag
+//Set the Strafe foward Flag, which only bosses have
 void CObject::StrafeForward() {
-    m_bStrafeFoward = true;
+    if (BossState* boss = GetBoss())
+        boss->m_bStrafeForward = true;
 }
 
 
-void CObject::Charge() { //Charging
-    charging = true;
+void CObject::Charge() { //Charging, which only bosses do
+    if (BossState* boss = GetBoss())
+        boss->m_bCharging = true;
     m_bStrafeBack = true;
 }
 
@@ -187,7 +274,7 @@ void CObject::Charge() { //Charging
 /// Perform a death particle effect to mark the death of an object.
 
 void CObject::DeathFX(){
-  m_pAudio->play(DEATH_SOUND);
+  m_pEventQueue->play(DEATH_SOUND);
   m_pObjectManager->create(SMALL_EXPLOSION, m_vPos);
 
   /*
@@ -219,13 +306,18 @@ void CObject::DeathFX(){
 } //DeathFX
 
 /// Kill an object by marking its "is dead" flag. The object
-/// will get deleted later at the appropriate time.
+/// will get deleted later at the appropriate time. If it has timers
+/// set, the object manager is told so that it can drop them first.
 
 void CObject::kill(){
+  if(m_bTimed && !m_bDead)
+    m_pObjectManager->TimedDeath();
+
   m_bDead = true;
-  if (m_nSpriteIndex == BLACK_JACK) {
-      if (force_field)
-          force_field->kill();
+  BossState* boss = GetBoss();
+  if (m_nSpriteIndex == BLACK_JACK && boss) {
+      if (boss->m_pForceField)
+          boss->m_pForceField->kill();
   }
 
   //DeathFX();
@@ -246,13 +338,6 @@ void CObject::SetSpeed(float speed){
   m_fSpeed = speed;
 } //SetVelocity
 
-/// Set the object's rotational speed in revolutions per second.
-/// \param speed Rotational speed in RPS.
-
-void CObject::SetRotSpeed(float speed){
-  m_fRotSpeed = speed;
-} //Rotate
-
 // set health
 void CObject::SetHealth(int h)
 {
@@ -268,9 +353,12 @@ int CObject::GetHealth()
 // player is hit
 void CObject::hit()
 {
+    ShipState* ship = GetShip();
+    if (!ship) return; // only player ships can be hit
+
     // calculate the difference in time since the player was last hit and the current time
-    float CurrentHitTime = m_pStepTimer->GetTotalSeconds();
-    float difference = CurrentHitTime - PreviousHitTime;
+    float CurrentHitTime = m_pSimTimer->GetTotalSeconds();
+    float difference = CurrentHitTime - ship->m_fHitTime;
     //HitFX();
 
     // if the difference is greater than 2 and the level is not completed, decrement health.
@@ -280,9 +368,9 @@ void CObject::hit()
         HitFX();        // hit effects
        // m_fHealth--;    // decrement health
         m_pObjectManager->decrementPlayerHealth();  // decrement player health
-        PreviousHitTime = m_pStepTimer->GetTotalSeconds();  // get new previous hit time
-        m_pController->Vibrate(100, 100);
-        m_pAudio->play(PLAYERHIT_SOUND);
+        ship->m_fHitTime = m_pSimTimer->GetTotalSeconds();  // get new previous hit time
+        m_pEventQueue->Vibrate(100, 100);
+        m_pEventQueue->play(PLAYERHIT_SOUND);
     }
     // if health <= 0, kill object
     //if (m_fHealth <= 0)
@@ -294,15 +382,15 @@ void CObject::hit()
 }
 
 // enemy is hit
-void CObject::enemyHit()
+void CObject::enemyHit(int damage)
 {
     HitFX();        // hit effects
-    m_fHealth--;    // decrement health
+    m_fHealth -= damage;    // take damage
 
     // if health <= 0, increment score by 100, and kill object
     if (m_fHealth <= 0)
     {
-        m_pObjectManager->EnemyKilledScore();   // +100 score
+        m_pObjectManager->EnemyKilledScore(this);   // +100 score
         kill(); // kill object
         DeathFX();  // death effects
     }
@@ -373,16 +461,7 @@ void CObject::ChangeColor() //Player changes their color to either red or blue
     else if (m_nSpriteIndex == RED_SHIP)
         m_nSpriteIndex = BLUE_SHIP;
 
-    m_pRenderer->GetSize(m_nSpriteIndex, m_vRadius.x, m_vRadius.y);
-    m_vRadius *= 0.5f;
-
-    const Vector2 topleft(-m_vRadius.x, m_vRadius.y);
-    const Vector2 bottomrt(m_vRadius.x, -m_vRadius.y);
-
-    m_Sphere.Radius = max(m_vRadius.x, m_vRadius.y);
-    m_Sphere.Center = (Vector3)m_vPos;
-
-    m_fGunTimer = m_pStepTimer->GetTotalSeconds();
+    FitSphere();
 }
 
 
@@ -395,7 +474,7 @@ CObject* CObject::Attack1( const Vector2& v) //Players signature move
 
 CObject* CObject::FireGun() //Players gun is shot by default
 {
-    m_pAudio->play(PLAYERGUN_SOUND);
+    m_pEventQueue->play(PLAYERGUN_SOUND);
 
     const Vector2 view = GetViewVector();
     Vector2 pos = GetPos() +
@@ -406,9 +485,9 @@ CObject* CObject::FireGun() //Players gun is shot by default
     CObject* pBullet = new CObject(BULLET_SPRITE, pos); //create bullet
 
     const Vector2 norm(view.y, -view.x); //normal to direction
-    const float m = 2.0f * m_pRandom->randf() - 1.0f;
+    const float m = 2.0f * m_pGameRandom->randf() - 1.0f;
     const Vector2 deflection = 0.01f * m * norm;
-    pBullet->SetVelocity(m_pPlayer->GetVelocity() + 500.0f * (view + deflection));
+    pBullet->SetVelocity(GetVelocity() + 500.0f * (view + deflection));
     pBullet->SetOrientation(135);
 
     //particle effect for gun fire
@@ -431,7 +510,7 @@ CObject* CObject::FireGun() //Players gun is shot by default
 
 void CObject::HitFX() 
 {
-    m_pAudio->play(DAMAGE_SOUND);
+    m_pEventQueue->play(DAMAGE_SOUND);
     CParticleDesc2D damage_effect;
     damage_effect.m_nSpriteIndex = DAMAGE_SPRITE;
     damage_effect.m_vPos = m_vPos - (0.5f * m_pRenderer->GetWidth(m_nSpriteIndex) * GetViewVector());
@@ -451,12 +530,15 @@ void CObject::React(const Vector2& v)
 // returns if explosion animation's lifespan is over
 bool CObject::explosionTooOld()
 {
-    return m_pStepTimer->GetTotalSeconds() - explosionBirthTime >= explosionLifeTime;
+    ExplosionState* explosion = GetExplosion();
+    return explosion && m_pSimTimer->GetTotalSeconds() - explosion->m_fBirthTime >= EXPLOSION_LIFE;
 }
 
 void CObject::ActivateForceField(CObject* ff) { //set force field for object for keep up with
-    force_field = ff;
-    ff_on = true;
+    if (BossState* boss = GetBoss()) {
+        boss->m_pForceField = ff;
+        boss->m_bForceFieldOn = true;
+    }
 }
 
 void CObject::UpdatePos() { //keep up with position of the object
@@ -473,4 +555,227 @@ void CObject::heal() { //heals the player
         heart_effect.m_fFadeOutFrac = 0.5f;
         heart_effect.m_fMaxScale = 0.5f;
         m_pParticleEngine->create(heart_effect);
-}
\ No newline at end of file
+}
+
+/// Hash the simulation state of this object in a fixed order. Only
+/// state that affects future ticks is included; pointers are not
+/// hashed because their values differ from run to run.
+/// \param hash The hash to be added to.
+
+void CObject::Hash(CStateHash& hash){
+  hash.Add(m_nSpriteIndex);
+  hash.Add(m_nCurrentFrame);
+  hash.Add(m_vPos);
+  hash.Add(m_fRoll);
+  hash.Add(m_vVelocity);
+  hash.Add(m_fSpeed);
+  hash.Add(m_fHealth);
+  hash.Add(m_bDead);
+  hash.Add(m_bGrazed);
+  hash.Add(m_cPolarity);
+  hash.Add(m_nPlayer);
+  hash.Add(m_bStrafeLeft);
+  hash.Add(m_bStrafeRight);
+  hash.Add(m_bStrafeBack);
+  hash.Add(m_bArmed);
+  hash.Add(m_bTimed);
+  hash.Add(m_fFrameTimer);
+  hash.Add(m_nExtra);
+
+  switch(m_nExtra){
+    case SHIP_EXTRA:
+      hash.Add(m_pShip->m_fHitTime);
+      break;
+
+    case BOSS_EXTRA:
+      hash.Add(m_pBoss->m_bCardsReady);
+      hash.Add(m_pBoss->m_bForceFieldReady);
+      hash.Add(m_pBoss->m_bBlackHoleReady);
+      hash.Add(m_pBoss->m_bCharging);
+      hash.Add(m_pBoss->m_bForceFieldOn);
+      hash.Add(m_pBoss->m_bBlackHoleOn);
+      hash.Add(m_pBoss->m_bStrafeForward);
+      break;
+
+    case CARD_EXTRA:
+      hash.Add(m_pCard->m_nReveal);
+      break;
+
+    case EXPLOSION_EXTRA:
+      hash.Add(m_pExplosion->m_fBirthTime);
+      break;
+  } //switch
+} //Hash
+
+/// \brief Plain old data copy of the simulation state of a CObject.
+///
+/// Saving an object fills one of these and writes it to the snapshot
+/// with a single memcpy, and loading does the reverse. Pointers to
+/// other objects are not in here; the object manager saves those as
+/// list indices. Optional state follows it, if there is any.
+
+struct ObjectState{
+  int nSpriteIndex; ///< Sprite type.
+  UINT nCurrentFrame; ///< Animation frame.
+  Vector2 vPos; ///< Position.
+  float fRoll; ///< Orientation.
+  float fSphereRadius; ///< Bounding sphere radius.
+  Vector2 vOldPos; ///< Last position.
+  Vector2 vVelocity; ///< Velocity.
+  float fSpeed; ///< Speed.
+  int nHealth; ///< Health.
+  float fFrameTimer; ///< Animation frame timer.
+  bool bDead; ///< Is dead or not.
+  bool bGrazed; ///< Shot has grazed a ship already.
+  char cPolarity; ///< Color of the ship that fired a player shot.
+  BYTE nPlayer; ///< Player who fired a player shot.
+  bool bStrafeLeft; ///< Strafe left.
+  bool bStrafeRight; ///< Strafe right.
+  bool bStrafeBack; ///< Strafe back.
+  bool bArmed; ///< Gun can fire.
+  bool bTimed; ///< Has timers set.
+  BYTE nExtra; ///< Kind of optional state.
+}; //ObjectState
+
+/// \brief Plain old data copy of the simulation state in a BossState.
+/// The pointers are left to the object manager.
+
+struct BossSave{
+  bool bCardsReady; ///< Cards can be dealt.
+  bool bForceFieldReady; ///< Force field can be put up.
+  bool bBlackHoleReady; ///< A black hole can be opened.
+  bool bCharging; ///< Is charging or not.
+  bool bForceFieldOn; ///< Force field is activated.
+  bool bBlackHoleOn; ///< Black hole is activated.
+  bool bStrafeForward; ///< Strafe forward.
+}; //BossSave
+
+/// Save the simulation state of this object to a snapshot.
+/// \param s The snapshot.
+
+void CObject::Save(CSnapshot& s){
+  ObjectState d;
+
+  d.nSpriteIndex = m_nSpriteIndex;
+  d.nCurrentFrame = (UINT)m_nCurrentFrame;
+  d.vPos = m_vPos;
+  d.fRoll = m_fRoll;
+  d.fSphereRadius = m_Sphere.Radius;
+  d.vOldPos = m_vOldPos;
+  d.vVelocity = m_vVelocity;
+  d.fSpeed = m_fSpeed;
+  d.nHealth = m_fHealth;
+  d.fFrameTimer = m_fFrameTimer;
+  d.bDead = m_bDead;
+  d.bGrazed = m_bGrazed;
+  d.cPolarity = m_cPolarity;
+  d.nPlayer = m_nPlayer;
+  d.bStrafeLeft = m_bStrafeLeft;
+  d.bStrafeRight = m_bStrafeRight;
+  d.bStrafeBack = m_bStrafeBack;
+  d.bArmed = m_bArmed;
+  d.bTimed = m_bTimed;
+  d.nExtra = m_nExtra;
+
+  s.Write(d);
+
+  switch(m_nExtra){
+    case SHIP_EXTRA:
+      s.Write(m_pShip->m_fHitTime);
+      break;
+
+    case BOSS_EXTRA: {
+      BossSave b;
+      b.bCardsReady = m_pBoss->m_bCardsReady;
+      b.bForceFieldReady = m_pBoss->m_bForceFieldReady;
+      b.bBlackHoleReady = m_pBoss->m_bBlackHoleReady;
+      b.bCharging = m_pBoss->m_bCharging;
+      b.bForceFieldOn = m_pBoss->m_bForceFieldOn;
+      b.bBlackHoleOn = m_pBoss->m_bBlackHoleOn;
+      b.bStrafeForward = m_pBoss->m_bStrafeForward;
+      s.Write(b);
+    } //case
+    break;
+
+    case CARD_EXTRA:
+      s.Write(m_pCard->m_nReveal);
+      break;
+
+    case EXPLOSION_EXTRA:
+      s.Write(m_pExplosion->m_fBirthTime);
+      break;
+  } //switch
+} //Save
+
+/// Load the simulation state of this object from a snapshot.
+/// Timers hold simulation clock times, and the object manager puts
+/// the clock back to the time of the snapshot, so they are loaded as is.
+/// The object must already be of the sprite type that the snapshot
+/// says it is. A snapshot may have come from a file, so nothing is
+/// taken on trust: the sprite type must match, the optional state must
+/// be the kind that the type needs, the animation frame must exist,
+/// and a shot must belong to player 0 or 1.
+/// \param s The snapshot.
+/// \return false if the state was not valid, leaving the object unchanged.
+
+bool CObject::Load(CSnapshot& s){
+  ObjectState d;
+  s.Read(d);
+
+  if(d.nSpriteIndex != m_nSpriteIndex || d.nExtra != ExtraType(d.nSpriteIndex) || d.nPlayer > 1 ||
+    d.nCurrentFrame >= max(m_pRenderer->GetNumFrames(d.nSpriteIndex), (size_t)1))
+      return false;
+
+  m_nSpriteIndex = d.nSpriteIndex;
+  m_nCurrentFrame = d.nCurrentFrame;
+  m_vPos = d.vPos;
+  m_fRoll = d.fRoll;
+  m_Sphere.Radius = d.fSphereRadius;
+  m_Sphere.Center = (Vector3)m_vPos;
+  m_vOldPos = d.vOldPos;
+  m_vVelocity = d.vVelocity;
+  m_fSpeed = d.fSpeed;
+  m_fHealth = d.nHealth;
+  m_fFrameTimer = d.fFrameTimer;
+  m_bDead = d.bDead;
+  m_bGrazed = d.bGrazed;
+  m_cPolarity = d.cPolarity;
+  m_nPlayer = d.nPlayer;
+  m_bStrafeLeft = d.bStrafeLeft;
+  m_bStrafeRight = d.bStrafeRight;
+  m_bStrafeBack = d.bStrafeBack;
+  m_bArmed = d.bArmed;
+  m_bTimed = d.bTimed;
+
+  switch(m_nExtra){
+    case SHIP_EXTRA:
+      s.Read(m_pShip->m_fHitTime);
+      break;
+
+    case BOSS_EXTRA: {
+      BossSave b;
+      s.Read(b);
+      m_pBoss->m_bCardsReady = b.bCardsReady;
+      m_pBoss->m_bForceFieldReady = b.bForceFieldReady;
+      m_pBoss->m_bBlackHoleReady = b.bBlackHoleReady;
+      m_pBoss->m_bCharging = b.bCharging;
+      m_pBoss->m_bForceFieldOn = b.bForceFieldOn;
+      m_pBoss->m_bBlackHoleOn = b.bBlackHoleOn;
+      m_pBoss->m_bStrafeForward = b.bStrafeForward;
+    } //case
+    break;
+
+    case CARD_EXTRA:
+      s.Read(m_pCard->m_nReveal);
+
+      if(m_pCard->m_nReveal != CARD && m_pCard->m_nReveal != QUEEN && m_pCard->m_nReveal != JACK)
+        return false;
+      break;
+
+    case EXPLOSION_EXTRA:
+      s.Read(m_pExplosion->m_fBirthTime);
+      break;
+  } //switch
+
+  return true;
+} //Load
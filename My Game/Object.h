@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <climits>
+
 #include "GameDefines.h"
 #include "Renderer.h"
 #include "Common.h"
@@ -12,6 +14,12 @@
 #include "Particle.h"
 #include "ParticleEngine.h"
 #include "Helpers.h"
+#include "GameRandom.h"
+#include "SimTimer.h"
+#include "StateHash.h"
+#include "Snapshot.h"
+#include "ExtraState.h"
+#include "EventQueue.h"
 
 /// \brief The game object. 
 ///
@@ -26,49 +34,42 @@ class CObject:
 
   protected:
     BoundingSphere m_Sphere; ///< Bounding sphere.
-    Vector3 m_vVel = Vector3::Zero; // Velocity. Needed for player animation.
 
     float m_fSpeed = 0; ///< Speed.
-    float m_fRotSpeed = 0; ///< Rotational speed.
-    float orig_speed = 0;
     int m_fHealth = 3; // set health = 3
-    int m_pPlayerScore = 0;
-    Vector2 m_vOldPos; ///< Last position.
+    Vector2 m_vOldPos; ///< Position at the start of the tick, set by the object manager before anything moves.
     Vector2 m_vVelocity; ///< Velocity.
-    bool m_bDead = false; ///< Is dead or not.
-    bool charging = false; ///<If object is charging or not
-    bool ff_on = false; ///<Force field is activated
-    bool bh_on = false; ///A black hole is activated by this object
+    UINT m_nSweepRank = UINT_MAX; ///< Place in the broad phase's sorted order last tick.
+    UINT m_nIndexRank = UINT_MAX; ///< Place in the spatial index last time it was built.
 
+    float m_fFrameTimer = 0.0f; ///< Last time the frame was changed.
+
+    bool m_bDead = false; ///< Is dead or not.
+    bool m_bGrazed = false; ///< Shot has grazed a ship already.
+    char m_cPolarity = 0; ///< Color of the ship that fired a player shot, 'r' or 'b'.
+    BYTE m_nPlayer = 0; ///< Player who fired a player shot, 0 or 1.
     bool m_bStrafeLeft = false; ///< Strafe left.
     bool m_bStrafeRight = false; ///< Strafe right.
     bool m_bStrafeBack = false; ///< Strafe back.
-    bool m_bStrafeFoward = false; ///< Strafe Foward
+    bool m_bArmed = false; ///< Gun has cooled down and can fire.
+    bool m_bTimed = false; ///< Has timers set in the object manager's timer wheel.
+    BYTE m_nExtra = NO_EXTRA; ///< Kind of optional state attached, an eExtraType.
 
+    /// Optional state, which only some kinds of object have. Which
+    /// of these is in use is given by m_nExtra.
 
-    Vector2 m_vRadius; ///< Half width and height of object sprite.
+    union{
+      ShipState* m_pShip = nullptr; ///< Player ship state.
+      BossState* m_pBoss; ///< Boss state.
+      CardState* m_pCard; ///< Card state.
+      ExplosionState* m_pExplosion; ///< Explosion state.
+    }; //union
 
-    float m_fGunTimer = 0.0f; ///< Gun fire timer.
-    float m_fChangeColorTimer; //timer for changing color
-    float m_fForceFieldTimer; //timer for force field
-    float m_fBlackHoleTimer; //timer for black hole
-    float m_fCardTimer; //timer for cards
+    void Attach(eExtraType t); ///< Attach optional state.
+    void Detach(); ///< Give optional state back to its pool.
+    void FitSphere(); ///< Fit the bounding sphere to the sprite.
+    void Animate(); ///< Advance the animation frame.
 
-    // responsible for animation
-    float m_fFrameTimer = 0.0f; ///< Last time the frame was changed.
-    float m_fFrameInterval = 0.1f; ///< Interval between frames.
-
-    float PreviousHitTime = 0.0f;  // Time since player was last hit
-
-    // responsible for explosion animation lifespan
-    float explosionBirthTime = 0.0f;
-    float explosionLifeTime = 0.5f;
-
-    //Force field of Object
-    CObject* force_field = nullptr;
-    //black hole of the object
-    CObject* black_hole = nullptr;
-    eSpriteType reveal; //queen or jack card
   public:
     CObject(); // default constructor
     CObject(eSpriteType t, const Vector2& p); ///< Constructor.
@@ -80,7 +81,7 @@ class CObject:
     void SetHealth(int h);  // set health
     int GetHealth();    // get health
     void hit(); // player is hit
-    void enemyHit();    // enemy is hit
+    void enemyHit(int damage=1);    // enemy is hit
 
     void kill(); ///< Kill me.
     bool IsDead(); ///< Query whether dead.
@@ -90,7 +91,6 @@ class CObject:
     
     void SetSpeed(float speed); ///< Set speed.
     float GetSpeed(); ///< Set speed.
-    void SetRotSpeed(float speed); ///< Set rotational velocity.
 
     Vector2 GetViewVector(); //Get view vector.
 
@@ -106,6 +106,11 @@ class CObject:
     void StrafeForward(); ///< Strafe Forward
     void Charge(); ///< Charging
     
+    ShipState* GetShip(); ///< Get player ship state.
+    BossState* GetBoss(); ///< Get boss state.
+    CardState* GetCard(); ///< Get card state.
+    ExplosionState* GetExplosion(); ///< Get explosion state.
+
     const BoundingSphere& GetBoundingSphere(); ///< Get bounding sphere.
     const Vector2& GetPos(); ///< Get position.
 
@@ -117,6 +122,9 @@ class CObject:
     bool explosionTooOld(); // returns if explosion animation's lifespan is over
     void UpdatePos(); //Updates the position of the CObject
     void heal(); //Heals the Player
+    virtual void Hash(CStateHash& hash); ///< Hash simulation state.
+    virtual void Save(CSnapshot& s); ///< Save simulation state.
+    virtual bool Load(CSnapshot& s); ///< Load simulation state.
 }; //CObject
 
 
@@ -1,11 +1,233 @@
 /// \file ObjectManager.cpp
 /// \brief Code for the the object manager class CObjectManager.
 
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
 #include "ObjectManager.h"
 #include "ComponentIncludes.h"
 #include "ParticleEngine.h"
+#include "JobSystem.h"
+#include "DebugPrintf.h"
+
+static const UINT SNAPSHOT_TAG = 0x42475355; ///< "USGB", marks the start of a snapshot. Change it whenever the layout changes.
+static const UINT MAX_OBJECTS = 65536; ///< Most objects that a snapshot may hold.
+static const float MAX_SWEEP = 256.0f; ///< Longest real move in one tick, anything further is a teleport.
+static const float LINE_BAND = 15.0f; ///< A line hazard hits ships whose center is this close to it in y.
+static const float GRAZE_MARGIN = 24.0f; ///< A shot that misses a ship by less than this grazes it.
+static const int LASER_COST = 10; ///< Energy used by each homing laser.
+static const float LASER_LAUNCH = 300.0f; ///< Speed of a homing laser as it leaves the ship.
+static const float LASER_FAN = 0.3f; ///< Angle in radians between lasers in a volley.
+static const int BOMBS = 3; ///< Bombs each player starts a game with.
+static const float BOMB_RADIUS = 300.0f; ///< Enemies this close to a bomb are damaged.
+static const int BOMB_DAMAGE = 2; ///< Number of hits a bomb does to each enemy.
+static const int PICKUP_POINTS = 20; ///< Points for collecting a pickup.
+static const float PICKUP_SPEED = 400.0f; ///< Speed at which pickups home in on a player.
+static const float ENEMY_RANGE = 800.0f; ///< How close a player must be for an enemy to fire.
+static const float HOTSHOT_RANGE = 800.0f; ///< How close a player must be for HotShot to attack.
+static const float LILBOY_RANGE = 800.0f; ///< How close a player must be for LittleBoy to attack.
+static const float LILBOY_REACH = 100.0f; ///< How far to either side of LittleBoy a player can be attacked.
+static const float BLACK_JACK_RANGE = 700.0f; ///< How close a player must be for BlackJack to attack.
+static const float BLACK_JACK_REACH = 180.0f; ///< How far to the right of BlackJack a player can be attacked.
+static const float PICKUP_LIFE = 3.0f; ///< Seconds before an uncollected pickup vanishes.
+static const float FIRE_TRAP_LIFE = 3.0f; ///< Seconds that HotShot's fire trap lasts.
+static const float BLACK_HOLE_LIFE = 5.0f; ///< Seconds that BlackJack's black hole lasts.
+static const float BIG_EXPLOSION_LIFE = 0.85f; ///< Seconds that a big explosion stays on screen.
+static const float CARD_COOLDOWN = 21.0f; ///< Seconds between BlackJack dealing cards.
+static const float FORCE_FIELD_COOLDOWN = 5.0f; ///< Seconds after BlackJack's force field goes down before it can go up again.
+static const float BLACK_HOLE_COOLDOWN = 10.0f; ///< Seconds after a black hole closes before BlackJack can open another.
+static const float CHANGE_COLOR_INTERVAL = 5.0f; ///< Seconds between BlackJack changing the players' colors.
+static const char* const MASK_FILE = "Media\\Masks\\masks.bin"; ///< Pixel collision masks, made by Tools/make_masks.py.
+
+/// Names of the sprite types, as in eSpriteType, for reading them
+/// from gamesettings.xml.
+
+static const char* const SPRITE_NAMES[] = {
+  "PLAYER_SPRITE", "TURRET_SPRITE", "BULLET_SPRITE", "RED_BULLET",
+  "SMOKE_SPRITE", "SPARK_SPRITE", "FLOOR_SPRITE", "BLUE_SHIP",
+  "RED_SHIP", "HEART1_SPRITE", "BLUE_BULLET", "HOTSHOT", "FIREBALL",
+  "LILBOY", "BLACK_JACK", "REDFIRE", "INTRO_SCREEN",
+  "GAME_OVER_SCREEN", "BACKGROUND", "VOLCANO_BACKGROUND",
+  "STAR_BACKGROUND", "EARTH_BACKGROUND", "DAMAGE_SPRITE",
+  "BIG_EXPLOSION", "BIG_SMOKE", "SMALL_SMOKE", "SMALL_EXPLOSION",
+  "LILBOMB", "LILBOMB_EFFECT", "RED_LIGHT_ENEMY", "BLUE_LIGHT_ENEMY",
+  "RED_HEAVY_ENEMY", "BLUE_HEAVY_ENEMY", "FORCE_FIELD", "BLACK_HOLE",
+  "JACK", "QUEEN", "CARD", "RED_LINE", "BLUE_LINE", "LARGE_RESPAWN",
+  "SMALL_RESPAWN", "END_SCREEN", "PICKUP"
+}; //SPRITE_NAMES
+
+static_assert(sizeof(SPRITE_NAMES)/sizeof(SPRITE_NAMES[0]) == NUM_SPRITES, "a sprite type has no name");
+
+/// Sprite types of enemies, for weapons that seek them out.
+
+static const UINT64 ENEMY_TYPES =
+  TypeBit(RED_LIGHT_ENEMY) | TypeBit(BLUE_LIGHT_ENEMY) |
+  TypeBit(RED_HEAVY_ENEMY) | TypeBit(BLUE_HEAVY_ENEMY) |
+  TypeBit(HOTSHOT) | TypeBit(LILBOY) | TypeBit(BLACK_JACK);
+
+/// Sprite types of enemy shots, which a bomb cancels.
+
+static const UINT64 SHOT_TYPES = TypeBit(RED_BULLET) | TypeBit(BLUE_BULLET) | TypeBit(FIREBALL);
+
+/// Test whether a sprite type is a line hazard, which is collided
+/// with as a horizontal band rather than a circle.
+/// \param t Sprite type.
+/// \return true if it is a line hazard.
+
+static bool IsBand(int t){
+  return t == RED_LINE || t == BLUE_LINE;
+} //IsBand
+
+/// Test whether a sprite type is an enemy shot, which only ever hits
+/// ships, and is tested against them in blocks by CShotPack.
+/// \param t Sprite type.
+/// \return true if it is an enemy shot.
+
+static bool IsShot(int t){
+  return t == RED_BULLET || t == BLUE_BULLET || t == FIREBALL;
+} //IsShot
+
+/// Get the archetype of a sprite type. Anything that is not
+/// one of the others is an effect.
+/// \param t Sprite type.
+/// \return Archetype.
+
+static eArchetype Archetype(int t){
+  switch(t){
+    case BACKGROUND: case EARTH_BACKGROUND: case STAR_BACKGROUND:
+    case VOLCANO_BACKGROUND: case INTRO_SCREEN: case GAME_OVER_SCREEN:
+    case END_SCREEN:
+      return BACKGROUND_ARCHETYPE;
+
+    case BLUE_SHIP: case RED_SHIP:
+      return PLAYER_ARCHETYPE;
+
+    case RED_LIGHT_ENEMY: case BLUE_LIGHT_ENEMY:
+      return LIGHT_ENEMY_ARCHETYPE;
+
+    case RED_HEAVY_ENEMY: case BLUE_HEAVY_ENEMY:
+      return HEAVY_ENEMY_ARCHETYPE;
+
+    case HOTSHOT: case LILBOY: case BLACK_JACK:
+      return BOSS_ARCHETYPE;
+
+    case BULLET_SPRITE: case RED_BULLET: case BLUE_BULLET: case FIREBALL:
+      return BULLET_ARCHETYPE;
+
+    case REDFIRE: case LILBOMB: case BLACK_HOLE: case FORCE_FIELD:
+    case CARD: case QUEEN: case JACK: case RED_LINE: case BLUE_LINE:
+      return HAZARD_ARCHETYPE;
+
+    default: return EFFECT_ARCHETYPE;
+  } //switch
+} //Archetype
+
+/// Find a sprite type by name.
+/// \param name Name, as in eSpriteType.
+/// \return Sprite type, or NUM_SPRITES if there is none of that name.
+
+static eSpriteType SpriteType(const char* name){
+  for(int t=0; t<NUM_SPRITES; t++)
+    if(strcmp(SPRITE_NAMES[t], name) == 0)
+      return (eSpriteType)t;
+
+  return NUM_SPRITES;
+} //SpriteType
+
+/// Read the hitbox table from the hitboxes tag of gamesettings.xml.
+/// Each part tag gives the sprite type, the offset of the part from
+/// the sprite's center as fractions of its half width and height,
+/// the radius as a fraction of the smaller of the two, and the hits
+/// of damage that a shot landing there does. Parts with an unknown
+/// sprite type are left out.
+/// \param settings The settings tag.
+/// \param table [out] Hitbox parts.
+
+static void ReadHitboxes(const XMLElement* settings, vector<HitPartData>& table){
+  const XMLElement* tag = settings? settings->FirstChildElement("hitboxes"): nullptr;
+  if(tag == nullptr)return;
+
+  for(auto p=tag->FirstChildElement("part"); p; p=p->NextSiblingElement("part")){
+    const char* name = p->Attribute("sprite");
+    const eSpriteType t = name? SpriteType(name): NUM_SPRITES;
+
+    if(t == NUM_SPRITES){
+      DEBUGPRINTF("Hitbox part for unknown sprite %s\n", name? name: "(none)");
+      continue;
+    } //if
+
+    HitPartData d = {t, 0.0f, 0.0f, 0.0f, 1};
+    p->QueryFloatAttribute("x", &d.m_fX);
+    p->QueryFloatAttribute("y", &d.m_fY);
+    p->QueryFloatAttribute("radius", &d.m_fRadius);
+    p->QueryIntAttribute("damage", &d.m_nDamage);
+    table.push_back(d);
+  } //for
+} //ReadHitboxes
+
+/// Convert a cooldown to simulation ticks. A cooldown is over on the
+/// first tick after it has run for strictly longer than its length.
+/// \param seconds Length of the cooldown.
+/// \return Number of ticks.
+
+static UINT Ticks(float seconds){
+  return (UINT)(seconds/SIM_TICK_SECONDS) + 1;
+} //Ticks
+
+/// Build the compound hitboxes from the table in gamesettings.xml,
+/// load the pixel collision masks, read the rules tag of
+/// gamesettings.xml and fill in the rules for each sprite type. The
+/// sprites must be loaded first, since the hitboxes are sized to fit
+/// them.
 
 CObjectManager::CObjectManager(){
+  vector<HitPartData> table; //hitbox parts from gamesettings.xml
+  ReadHitboxes(m_pXmlSettings, table);
+  m_vHitboxes.resize(NUM_SPRITES);
+
+  for(int t=0; t<NUM_SPRITES; t++){
+    float w, h; //sprite width and height
+    m_pRenderer->GetSize((eSpriteType)t, w, h);
+    m_vHitboxes[t].Build(table, (eSpriteType)t, 0.5f*Vector2(w, h));
+  } //for
+
+  if(!m_cMasks.Load(MASK_FILE))
+    DEBUGPRINTF("No pixel collision masks in %s\n", MASK_FILE);
+
+  const XMLElement* rules = m_pXmlSettings? m_pXmlSettings->FirstChildElement("rules"): nullptr;
+
+  if(rules){
+    rules->QueryBoolAttribute("shotcancel", &m_bShotCancel);
+
+    UINT budget = m_cAI.GetBudget(); //enemy decisions per tick
+    rules->QueryUnsignedAttribute("aibudget", &budget);
+    SetAIBudget(budget);
+  } //if
+
+  for(int t=0; t<NUM_SPRITES; t++)
+    m_stRules[t].m_nArchetype = Archetype(t);
+
+  m_stRules[BULLET_SPRITE].m_nEdge = TOP_EDGE; //player bullets fly off the top
+
+  for(int t: {RED_BULLET, BLUE_BULLET, CARD, QUEEN, JACK, RED_LINE, BLUE_LINE})
+    m_stRules[t].m_nEdge = ANY_EDGE;
+
+  m_stRules[REDFIRE].m_fLife = FIRE_TRAP_LIFE;
+  m_stRules[BLACK_HOLE].m_fLife = BLACK_HOLE_LIFE;
+  m_stRules[BIG_EXPLOSION].m_fLife = BIG_EXPLOSION_LIFE;
+  m_stRules[PICKUP].m_fLife = PICKUP_LIFE;
+
+  m_stRules[RED_LIGHT_ENEMY].m_fCooldown = 0.9f; //shoots every 0.9 seconds
+  m_stRules[BLUE_LIGHT_ENEMY].m_fCooldown = 0.9f;
+  m_stRules[RED_HEAVY_ENEMY].m_fCooldown = 2.0f; //shoots every 2 seconds
+  m_stRules[BLUE_HEAVY_ENEMY].m_fCooldown = 2.0f;
+  m_stRules[HOTSHOT].m_fCooldown = 1.3f; //does something every 1.3 seconds
+  m_stRules[LILBOY].m_fCooldown = 0.5f; //shoots or drops a bomb every half second
+  m_stRules[BLACK_JACK].m_fCooldown = 1.0f; //does something every second
+
+  for(auto& r: m_stRules)
+    r.m_bTimed = r.m_fLife > 0.0f || r.m_fCooldown > 0.0f;
 } //constructor
 
 /// Destruct all of the objects in the object list.
@@ -22,7 +244,7 @@ CObjectManager::~CObjectManager(){
 
 CObject* CObjectManager::create(eSpriteType t, const Vector2& v){
   CObject* p = new CObject(t, v); 
-  m_stdObjectList.push_back(p); 
+  add(p); 
   return p;
 } //create
 
@@ -35,14 +257,73 @@ void CObjectManager::clear(){
     delete p; //delete object
 
   m_stdObjectList.clear(); //clear the object list
+  m_bIndexed = false; //the index points at deleted objects
+
+  for(auto& v: m_vArchetype) //and so do the archetypes
+    v.clear();
+
+  m_vSpawned.clear();
+  m_cBullets.Clear();
+  m_cLasers.Clear(); //and so do the lasers
+  m_cAttachments.Clear(); //and the attachments
+  m_cTimers.Reset(m_nTick); //and the timers
+  m_cAI.Clear(); //and the enemies waiting for a turn
+  m_bTimedDeath = false;
 } //clear
 
-/// Draw the objects in the object list.
+/// Get the draw layer for a sprite type. Backgrounds go
+/// underneath everything and full-screen pictures on top.
+/// \param t Sprite type.
+/// \return Layer number, lower layers are drawn first.
 
-void CObjectManager::draw(){
-  for(auto const& p: m_stdObjectList) //for each object
-    m_pRenderer->Draw(*(CSpriteDesc2D*)p);
-} //draw
+static int Layer(int t){
+  switch(t){
+    case BACKGROUND: case EARTH_BACKGROUND:
+    case STAR_BACKGROUND: case VOLCANO_BACKGROUND:
+      return 0;
+
+    case INTRO_SCREEN: case GAME_OVER_SCREEN: case END_SCREEN:
+      return 2;
+
+    default: return 1;
+  } //switch
+} //Layer
+
+/// Copy what the renderer needs from the objects in the object list
+/// into a render snapshot, sorted by layer. The sort is stable so
+/// objects within a layer are drawn in list order, as they always were.
+/// \param s [out] The render snapshot.
+
+void CObjectManager::Publish(CRenderSnapshot& s){
+  s.m_vItems.clear();
+
+  for(auto const& p: m_stdObjectList){ //for each object
+    RenderItem r;
+    r.m_stDesc = *(CSpriteDesc2D*)p;
+    r.m_vOldPos = p->m_vOldPos;
+    r.m_nLayer = Layer(p->m_nSpriteIndex);
+    s.m_vItems.push_back(r);
+  } //for
+
+  for(UINT i=0; i<m_cLasers.GetSize(); i++){ //for each homing laser
+    const Vector2 v = m_cLasers.GetVelocity(i);
+    RenderItem r;
+    r.m_stDesc.m_nSpriteIndex = BULLET_SPRITE;
+    r.m_stDesc.m_vPos = m_cLasers.GetPos(i);
+    r.m_stDesc.m_fRoll = atan2f(-v.x, v.y); //nose along the velocity
+    r.m_stDesc.m_f4Tint = XMFLOAT4(Colors::Cyan);
+    r.m_vOldPos = m_cLasers.GetOldPos(i);
+    r.m_nLayer = Layer(BULLET_SPRITE);
+    s.m_vItems.push_back(r);
+  } //for
+
+  stable_sort(s.m_vItems.begin(), s.m_vItems.end(),
+    [](const RenderItem& a, const RenderItem& b){return a.m_nLayer < b.m_nLayer;});
+
+  s.m_vCamera = m_pPlayer? m_pPlayer->GetPos(): m_vWorldSize/2;
+  s.m_vOldCamera = m_pPlayer? m_pPlayer->m_vOldPos: s.m_vCamera;
+  s.m_vWorldSize = m_vWorldSize;
+} //Publish
 
 /// Test whether an object's left, right, top or bottom
 /// edge has crossed the left, right, top, bottom edge of
@@ -82,332 +363,554 @@ bool CObjectManager::AtWorldEdge(CObject* p){
   return false; //default
 } //AtWorldEdge
 
-/// Move all of the objects and perform 
-/// broad phase collision detection and response.
+/// Put the objects that have been added since the last tick into their
+/// archetypes. The archetypes are kept from tick to tick rather than
+/// rebuilt. New objects go on the end, as they do on the object list,
+/// and Ungroup() takes objects out before they are deleted, so each
+/// archetype stays in list order. An object's sprite type can change,
+/// as a card's does when it is turned over, but never to one of another
+/// archetype. Objects created while the systems run are not in any
+/// archetype until the next tick, so they first move then, and that is
+/// also when their timers are set. Bullets have their position and
+/// velocity copied into the bullet arrays.
+
+void CObjectManager::Group(){
+  for(auto const& p: m_vSpawned){ //for each new object
+    const TypeRules& r = m_stRules[p->m_nSpriteIndex];
+    m_vArchetype[r.m_nArchetype].push_back(p);
+
+    if(r.m_nArchetype == BULLET_ARCHETYPE){
+      float w, h; //sprite width and height
+      m_pRenderer->GetSize(p->m_nSpriteIndex, w, h);
+      m_cBullets.Add(p->m_vPos, p->m_vVelocity, w, h, r.m_nEdge);
+    } //if
 
-void CObjectManager::move(){
-  for(auto const& p: m_stdObjectList){ //for each object
+    if(r.m_bTimed && !p->m_bTimed && !p->m_bDead)
+      StartTimers(p);
+  } //for
 
-    p->move(); //move it
+  m_vSpawned.clear();
+} //Group
 
-    switch(p->m_nSpriteIndex){
-      case RED_LIGHT_ENEMY: {
-        const Vector2 v = m_pPlayer->m_vPos - p->m_vPos;//distance from player
-        bool bVisible = v.Length() < 800.0f; //player in range for attack
-
-        if(bVisible && m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 0.9f){ //shoots every 0.9 seconds
-          p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-          CObject* ebullet = p->FireGun();
-          m_stdObjectList.push_back( ebullet );
-        } //if
-        if (AtWorldEdge(p))//dont leave screen
-            p->CollisionResponse();
-      } //case
-      break;
+/// Take objects that are about to be deleted out of their archetypes,
+/// and bullets out of the bullet arrays, keeping the rest in order.
+/// Only the archetypes that lose objects are gone through, once each,
+/// and the objects are found by address, so none of the others are
+/// looked at. The objects must not have been deleted yet.
+/// \param doomed Objects about to be deleted. This sorts them by address.
 
-      case HOTSHOT: {
-          const Vector2 v = m_pPlayer->m_vPos - p->m_vPos;//distance from player
-          bool bVisible = v.Length() < 800.0f;
-          if (bVisible) { //Player is in hotshots range
-              if (m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 1.3) { //does something every 1.3 seconds
-                  p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-                  int choose_attack = rand() % 100; //randomly choose hotshots attack
-                  if (choose_attack < 70) { //shoots fireballs
-                      const Vector2 target_player = m_pPlayer->m_vPos - p->m_vPos;
-                      CObject* fire_ball = p->FireGun();
-                      m_stdObjectList.push_back( fire_ball );
-                  }
-                  else {// Hotshot summons firetrap
-                      float range = 512.0f - m_pPlayer->m_vPos.x;
-                      Vector2 pos(0.0f, m_pPlayer->m_vPos.y);
-                      if (range >= 0)
-                          pos.x = m_pPlayer->m_vPos.x + 250.0f; //spawn right of the player
-                      else
-                          pos.x = m_pPlayer->m_vPos.x - 250.0f; //spawn to the left of player
-
-                      CObject* fire_trap = p->Attack1(pos);
-                      fire_trap->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-                      m_stdObjectList.push_back(fire_trap);
-                  }
-              } //if
-          }//if
-      }
-     break;
-
-      case BLUE_LIGHT_ENEMY: {
-          const Vector2 v = m_pPlayer->m_vPos - p->m_vPos; //distance from player
-          bool bVisible = v.Length() < 800.0f; //player in range for attack
-
-          if (bVisible && m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 0.9f) { //shoots every ,9 seconds
-              p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-              CObject* ebullet = p->FireGun();
-              m_stdObjectList.push_back( ebullet );
-          } //if
-          if (AtWorldEdge(p))//Dont leave screen
-              p->CollisionResponse();
-      } //case
-      break;
+void CObjectManager::Ungroup(vector<CObject*>& doomed){
+  if(doomed.empty())return;
 
-      case RED_HEAVY_ENEMY: {
-          const Vector2 v = m_pPlayer->m_vPos - p->m_vPos;//distance from player
-          bool bVisible = v.Length() < 800.0f; //player in range for attack
-
-          if (bVisible && m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 2) {//shoots every 2 seconds
-              p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-              CObject* ebullet = p->FireGun();
-              m_stdObjectList.push_back(ebullet);
-          } //if
-          if (AtWorldEdge(p))
-              p->CollisionResponse();
-      } //case
-      break;
+  sort(doomed.begin(), doomed.end());
+  bitset<NUM_ARCHETYPES> touched; //archetypes that lose objects
+
+  for(auto const& p: doomed)
+    touched.set(m_stRules[p->m_nSpriteIndex].m_nArchetype);
+
+  auto gone = [&](CObject* p){
+    return binary_search(doomed.begin(), doomed.end(), p);
+  }; //gone
+
+  for(UINT a=0; a<NUM_ARCHETYPES; a++){
+    if(!touched[a])continue;
+
+    vector<CObject*>& v = m_vArchetype[a];
+    const UINT n = (UINT)v.size();
+    UINT k = 0; //number kept
+    m_vGone.clear();
+
+    for(UINT i=0; i<n; i++)
+      if(gone(v[i]))m_vGone.push_back(i);
+      else v[k++] = v[i];
+
+    v.resize(k);
+
+    if(a == BULLET_ARCHETYPE)
+      m_cBullets.Remove(m_vGone);
+  } //for
+
+  m_vSpawned.erase(remove_if(m_vSpawned.begin(), m_vSpawned.end(), gone), m_vSpawned.end());
+} //Ungroup
+
+/// Set a timer to go off after a number of seconds.
+/// \param p Object that it belongs to.
+/// \param e What happens when it goes off.
+/// \param seconds Number of seconds from now.
+
+void CObjectManager::Schedule(CObject* p, eTimerEvent e, float seconds){
+  m_cTimers.Schedule(p, e, m_nTick + Ticks(seconds));
+  p->m_bTimed = true;
+} //Schedule
+
+/// Set the timers of an object that has just turned up: its lifetime,
+/// its gun cooldown, and BlackJack's cooldowns for his other attacks.
+/// \param p Pointer to an object.
+
+void CObjectManager::StartTimers(CObject* p){
+  const TypeRules& r = m_stRules[p->m_nSpriteIndex];
+
+  if(r.m_fLife > 0.0f)
+    Schedule(p, LIFE_TIMER, r.m_fLife);
 
-      case BLUE_HEAVY_ENEMY: {
-          const Vector2 v = m_pPlayer->m_vPos - p->m_vPos; //distance from player
-          bool bVisible = v.Length() < 800.0f; //players in range for attack
-
-          if (bVisible && m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 2) { //shoots every 2 seconds
-              p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-              CObject* ebullet = p->FireGun();
-              m_stdObjectList.push_back(ebullet);
-          } //if
-          if (AtWorldEdge(p)) //Make sure enemy doe snot leave screen
-             p->CollisionResponse();
-      } //case
+  if(r.m_fCooldown > 0.0f)
+    Schedule(p, GUN_TIMER, r.m_fCooldown);
+
+  if(p->m_nSpriteIndex == BLACK_JACK){
+    Schedule(p, CARD_TIMER, CARD_COOLDOWN);
+    Schedule(p, FORCE_FIELD_TIMER, FORCE_FIELD_COOLDOWN);
+    Schedule(p, BLACK_HOLE_TIMER, BLACK_HOLE_COOLDOWN);
+    Schedule(p, CHANGE_COLOR_TIMER, CHANGE_COLOR_INTERVAL);
+  } //if
+} //StartTimers
+
+/// Respond to a timer going off. Timers of objects that have died
+/// since are ignored, since the objects are about to be deleted.
+/// \param t The timer.
+
+void CObjectManager::OnTimer(const CTimerWheel::Timer& t){
+  CObject* const p = t.m_pObject;
+  if(p->m_bDead)return;
+
+  switch(t.m_nEvent){
+    case GUN_TIMER:
+      p->m_bArmed = true;
+      if(m_stRules[p->m_nSpriteIndex].m_nArchetype == LIGHT_ENEMY_ARCHETYPE ||
+        m_stRules[p->m_nSpriteIndex].m_nArchetype == HEAVY_ENEMY_ARCHETYPE)
+        m_cAI.Add(p); //wait for a turn to decide whether to fire
       break;
 
-      case LILBOY: {
-          const Vector2 range = m_pPlayer->GetPos() - p->GetPos(); //distance between player and littleboy
-          bool in_range = abs(range.x) < 100.0f && range.Length() < 800.0f; //player is in rnage for attack
-          if (in_range) 
-          {
-              if (m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 0.5) { //Either shoots gun or drops bomb every 1/2 seconds
-                  p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-                  int choose_attack = rand() % 100; //Randomly chooses whcih attack littleboy wil do
-                  if (choose_attack < 25) {
-                      CObject* bomb = p->Attack1(Vector2::Zero);
-                      m_stdObjectList.push_back(bomb);
-                  }
-                  else {//Shoots diverse colors of bullets
-                      CObject* b1 = p->FireGun();
-                      CObject* b2 = p->FireGun();
-                      CObject* b3 = p->FireGun();
-                      m_stdObjectList.push_back(b1);
-                      m_stdObjectList.push_back(b2);
-                      m_stdObjectList.push_back(b3);
-                  }
-              }
-          }
-      }
-                 if (AtWorldEdge(p)) //Make sure littleboy does not leave screen
-                     p->CollisionResponse();
-      break; 
-
-      //Blackjack
-      case BLACK_JACK: {
-          const Vector2 range = m_pPlayer->GetPos() - p->GetPos(); //distance between player and blackjack
-          bool in_range = range.x < 180.0f && range.Length() < 700.0f; //Player is in range for attack
-          if (in_range) {
-              //FireGun, change player colors, change its own colors, forcefield, Cards, charge at player
-              if (m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 1) { //Does something every second
-                  p->m_fGunTimer = m_pStepTimer->GetTotalSeconds();
-                  int choose_attack = rand() % 100; //randomly choose blackjacks next move
-                  //summons random poker cards every 21 seconds
-                  if (choose_attack < 23 && !p->charging && m_pStepTimer->GetTotalSeconds() > p->m_fCardTimer + 21) {
-                      CObject* c1 = new CObject(CARD, Vector2(200.0f, 1000.0f));
-                      CObject* c2 = new CObject(CARD, Vector2(500.0f, 1000.0f));
-                      CObject* c3 = new CObject(CARD, Vector2(750.0f, 1000.0f));
-                      c1->SetVelocity(Vector2(0.0f,-110.0f));
-                      c2->SetVelocity(c1->GetVelocity());
-                      c3->SetVelocity(c2->GetVelocity());
-                      m_stdObjectList.push_back(c1);
-                      m_stdObjectList.push_back(c2);
-                      m_stdObjectList.push_back(c3);
-                      p->m_fCardTimer = m_pStepTimer->GetTotalSeconds();
-                  }//Cards
-                  else if (choose_attack < 75 && !p->charging) { //Fire gun
-                      CObject* b1 = p->FireGun();
-                      CObject* b2 = p->FireGun();
-                      m_stdObjectList.push_back(b1);
-                      m_stdObjectList.push_back(b2);
-                  }//FireGun
-                  else if (!p->ff_on && m_pStepTimer->GetTotalSeconds() > p->m_fForceFieldTimer + 5 && !p->m_bStrafeFoward && !p->m_bStrafeBack ) {
-                      CObject* ff = new CObject(FORCE_FIELD, p->GetPos()); 
-                      p->ActivateForceField(ff);
-                      m_stdObjectList.push_back(ff);
-                  }//Force field
-                  else {
-                      if(!p->charging && !p->ff_on)
-                        p->Charge();
-                  }//Charge at player
-              }
-
-          }
-          //blackjacks Blackhole is summoned every 10 seconds as long as it is not charging or another black hole is active
-          if (m_pStepTimer->GetTotalSeconds() > p->m_fBlackHoleTimer + 10 && !p->charging && !p->bh_on) {
-              float range = 512.0f - m_pPlayer->m_vPos.x;
-              Vector2 pos(0.0f,m_pPlayer->m_vPos.y);
-              if (range >= 0)
-                  pos.x = m_pPlayer->m_vPos.x + 250.0f; //will spawn to the right of the player
-              else 
-                  pos.x = m_pPlayer->m_vPos.x - 250.0f; //will spawn to the players left
-
-              CObject* bh = new CObject(BLACK_HOLE, pos);
-              m_stdObjectList.push_back(bh);
-              p->bh_on = true;
-              m_pAudio->loop(BH_SOUND);
-          }
-          //black jack will automatically change the players color 
-          if (m_pStepTimer->GetTotalSeconds() > p->m_fChangeColorTimer + 5) {
-              p->m_fChangeColorTimer = m_pStepTimer->GetTotalSeconds();
-              m_pPlayer->ChangeColor();
-          }
-
-          //Make sure black jack does not leave the screen
-          if (AtWorldEdge(p))
-              p->CollisionResponse();
-      }
+    case LIFE_TIMER:
+      p->kill();
+      if(p->m_nSpriteIndex == BLACK_HOLE)
+        CloseBlackHole();
       break;
 
-      // player bullet
-      case BULLET_SPRITE: { 
-          if (currentBoss && !currentBoss->ff_on) {
-              const Vector2 range = p->GetPos() - currentBoss->GetPos();
-              bool point_blank_range = abs(range.y) < 250.0f && abs(range.x) < 100.0f;//Only true when players bullet is at range for dodge to be necessary
-              int reaction = rand()%100; //Probabilty if the boss will dodge 
-              bool dodge; //Does the boss dodge it?
-              //Black Jakc and littleboy can dodge players bullets
-              if (currentBoss->m_nSpriteIndex == BLACK_JACK) //Black jack has 50 chance of dodging the bullet
-                  dodge = reaction < 50;
-              else if (currentBoss->m_nSpriteIndex == LILBOY) //Littleboy has a 25 chance of dodging the bullet
-                  dodge = reaction < 25;
-              else { dodge = false; }
-              //If the bullet is in point blank range, the boss is not moving up or down, and the dodge probabilty is a success
-              //Then boss will dodge the bullet
-              if (point_blank_range && (!currentBoss->m_bStrafeBack && !currentBoss->m_bStrafeFoward) && dodge) {
-                  const Vector2 boss = currentBoss->GetPos();
-                  const Vector2 bullet = p->GetPos();
-                  if (AtWorldEdge(currentBoss)) { //Make sure boss does not leave the screen
-                      float width, hieght;
-                      m_pRenderer->GetSize(currentBoss->m_nSpriteIndex, width, hieght);
-                      if (boss.x - width / 2 < 0 && !currentBoss->m_bStrafeLeft)
-                          currentBoss->StrafeRight();
-                      else if (boss.x + width / 2 > m_vWorldSize.x && !currentBoss->m_bStrafeRight)
-                          currentBoss->StrafeLeft();
-                  }
-                  else {
-                      if (bullet.x < boss.x && !currentBoss->m_bStrafeLeft)
-                          currentBoss->StrafeRight();
-                      else if (bullet.x > boss.x && !currentBoss->m_bStrafeRight)
-                          currentBoss->StrafeLeft();
-                      else {
-                          if (boss.x <= m_vWinCenter.x && !currentBoss->m_bStrafeLeft)
-                              currentBoss->StrafeRight();
-                          else
-                              currentBoss->StrafeLeft();
-                      }
-                  }
-
-              }
-          }
-          // kill bullet at worldedge
-          if (p->m_vPos.y >= m_vWorldSize.y)
-          {
-              p->kill();
-          }
-      }
+    case CARD_TIMER: p->GetBoss()->m_bCardsReady = true; break;
+    case FORCE_FIELD_TIMER: p->GetBoss()->m_bForceFieldReady = true; break;
+    case BLACK_HOLE_TIMER: p->GetBoss()->m_bBlackHoleReady = true; break;
+
+    case CHANGE_COLOR_TIMER: //black jack will automatically change the players color
+      if(m_pPlayer)
+        m_pPlayer->ChangeColor();
+      if(m_pPlayer2)
+        m_pPlayer2->ChangeColor();
+      Schedule(p, CHANGE_COLOR_TIMER, CHANGE_COLOR_INTERVAL);
       break;
+  } //switch
+} //OnTimer
 
-      // enemy red bullet
-      case RED_BULLET:
-        if (AtWorldEdge(p)) {
-           p->kill();
-           //m_pAudio->play(RICOCHET_SOUND);
-          } //if
-       break;
-
-       // enemy blue bullet
-      case BLUE_BULLET:
-          if (AtWorldEdge(p)) {
-              p->kill();
-              //m_pAudio->play(RICOCHET_SOUND);
-          } //if
-          break;
-
-      case REDFIRE: //Hotshots fire trap will only lasts 3 seconds
-          if (m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 3)
-              p->kill();
-          break;
-
-      case LILBOMB: {
-          Vector2 pos = p->GetPos();
-          if (pos.y <= 200.0f) { //Littleboys bomb is triggered
-              p->kill();
-              CObject* exp = new CObject(BIG_EXPLOSION, pos);
-              m_stdObjectList.push_back(exp);
-          }
-          
-      }
-          break;
-
-      case BLACK_HOLE: { //black hole lasts for only 5 seconds
-          if (m_pStepTimer->GetTotalSeconds() > p->m_fGunTimer + 5) {
-              p->kill();
-              m_pAudio->stop(BH_SOUND);
-              currentBoss->m_fBlackHoleTimer = m_pStepTimer->GetTotalSeconds();
-              currentBoss->bh_on = false;
-          }
-      }
-         break;
-
-      case CARD: 
-          if (AtWorldEdge(p)) { //card leaves screen
-              p->kill();
-          } //if
-       break;
-      case QUEEN: //Queen card leaves screen
-          if (AtWorldEdge(p)) {
-              p->kill();
-          }//if
-       break;
-      case JACK:
-          if (AtWorldEdge(p)) { //Jack card leaves screen
-              p->kill();
-          } //if
-       break;
-      case BIG_EXPLOSION: //Explosion stays on screen for less than one second
-          if (m_pStepTimer->GetTotalSeconds() >  p->m_fGunTimer + 0.85) {
-              p->kill();
-            }
-          break;
-      
-      case RED_LINE:
-          if (AtWorldEdge(p))
-          {
-              p->kill();
-          }
-          break;
-
-      case BLUE_LINE:
-          if (AtWorldEdge(p))
-          {
-              p->kill();
-          }
-          break;
-
-      default:
-          break;
-    } //switch
-  } //for
+/// Start an object's gun cooling down after it has fired.
+/// \param p Pointer to an object.
+
+void CObjectManager::Reload(CObject* p){
+  p->m_bArmed = false;
+  Schedule(p, GUN_TIMER, m_stRules[p->m_nSpriteIndex].m_fCooldown);
+} //Reload
+
+/// A black hole has closed, so the boss can open another one
+/// once the cooldown is over. Only BlackJack opens black holes, and
+/// he may have died while this one was open, in which case there is
+/// nobody left to cool down.
+
+void CObjectManager::CloseBlackHole(){
+  m_pEventQueue->stop(BH_SOUND);
+
+  if(currentBoss == nullptr || currentBoss->IsDead() || currentBoss->m_nSpriteIndex != BLACK_JACK)
+    return; //boss is gone
+
+  currentBoss->GetBoss()->m_bBlackHoleOn = false;
+  Schedule(currentBoss, BLACK_HOLE_TIMER, BLACK_HOLE_COOLDOWN);
+} //CloseBlackHole
+
+/// Note that an object with timers has died, so that its timers
+/// are dropped before it is deleted.
+
+void CObjectManager::TimedDeath(){
+  m_bTimedDeath = true;
+} //TimedDeath
+
+/// Drop the timers of dead objects, if any objects
+/// with timers have died since this was last done. Enemies waiting
+/// for a turn have timers, so they are dropped here too.
+
+void CObjectManager::DropTimers(){
+  if(m_bTimedDeath){
+    m_cTimers.DropDead();
+    m_cAI.DropDead();
+  } //if
+
+  m_bTimedDeath = false;
+} //DropTimers
+
+/// Test whether an object has reached the edge of the world, according
+/// to the rules for its sprite type. Objects that die of old age are
+/// killed by their timers instead. This only reads the object, so the
+/// systems can call it in parallel.
+/// \param p Pointer to an object.
+/// \return true if it should be killed.
+
+bool CObjectManager::Expired(CObject* p){
+  const TypeRules& r = m_stRules[p->m_nSpriteIndex];
+
+  return
+    (r.m_nEdge == TOP_EDGE && p->m_vPos.y >= m_vWorldSize.y) ||
+    (r.m_nEdge == ANY_EDGE && AtWorldEdge(p));
+} //Expired
+
+/// Run a system over the objects of an archetype in parallel, a range
+/// of them at a time. The body may only change the objects in its
+/// range, and asks for anything else to be done by adding a command.
+/// Killing an object, putting it back on screen and creating objects
+/// all touch shared state, the random number generator among it, so
+/// the commands are carried out afterwards on this thread. They are
+/// carried out in archetype order, which is the order in which the
+/// serial loop did them, so the simulation comes out exactly the same.
+/// \param a Archetype.
+/// \param body What to do to the objects with indices in a range.
+
+void CObjectManager::RunSystem(eArchetype a, const function<void(UINT, UINT, vector<Command>&)>& body){
+  const UINT grain = 64; //objects per chunk
+  const UINT n = (UINT)m_vArchetype[a].size();
+  const UINT chunks = (n + grain - 1)/grain;
+
+  if(m_vCommands.size() < chunks)
+    m_vCommands.resize(chunks);
+
+  for(UINT c=0; c<chunks; c++) //with no workers the whole loop runs as one chunk
+    m_vCommands[c].clear();
+
+  m_pJobSystem->ParallelFor(n, grain, [&](UINT begin, UINT end){
+    body(begin, end, m_vCommands[begin/grain]);
+  });
+
+  for(UINT c=0; c<chunks; c++) //chunks in archetype order
+    for(auto const& cmd: m_vCommands[c])
+      switch(cmd.m_nType){
+        case KILL_COMMAND: cmd.m_pObject->kill(); break;
+        case RESPAWN_COMMAND: cmd.m_pObject->CollisionResponse(); break;
+        case SPAWN_COMMAND: add(new CObject(cmd.m_nSprite, cmd.m_vPos)); break;
+      } //switch
+} //RunSystem
+
+/// Move all of the objects and perform 
+/// broad phase collision detection and response. The objects are
+/// kept in archetypes and each archetype is moved by its own
+/// system, so that each system only does what its objects need
+/// rather than every object going through one big switch.
+
+void CObjectManager::move(){
+  Index(); //positions at the start of the tick, for spatial queries
+
+  for(auto const& t: m_cTimers.Advance(m_nTick)) //timers that go off this tick
+    OnTimer(t);
+
+  Group(); //new objects join their archetypes
+
+  for(auto const& v: m_vArchetype) //where everything starts the tick, for sweeps and interpolation
+    for(auto const& p: v)
+      p->m_vOldPos = p->m_vPos;
+
+  MoveBackgrounds();
+  MovePlayers();
+  MoveEnemies(LIGHT_ENEMY_ARCHETYPE);
+  MoveEnemies(HEAVY_ENEMY_ARCHETYPE);
+  ThinkEnemies();
+  MoveBosses();
+  MoveBullets();
+  MoveHazards();
+  MoveEffects();
+  m_cAttachments.Resolve(); //children follow their parents
 
   //now do object-object collision detection and response and
   //remove any dead objects from the object list.
 
+  BossDodge(); //boss dodges player bullets that get too close
+  MoveLasers(); //homing lasers hit their targets
+
   BroadPhase(); //broad phase collision detection and response
+  m_cAttachments.Resolve(); //again, for parents moved by collision response
+  ScoreChain(); //score absorbed shots and chains
+  m_cLasers.DropDead(); //before their targets are deleted
+  m_cAttachments.DropDead(); //and before attached objects are
+  DropTimers(); //and before objects with timers are
   CullDeadObjects(); //remove dead objects from object list
+  m_bIndexed = false; //objects have moved and some are gone
   SpawnBoss(); //Check and see if level is ready to spawn the boss
+
+  m_nTick++; //one more simulation tick done
 } //move
 
+/// Background system. Backgrounds and full-screen pictures
+/// are plain objects, so they skip the virtual call.
+
+void CObjectManager::MoveBackgrounds(){
+  for(auto const& p: m_vArchetype[BACKGROUND_ARCHETYPE])
+    p->CObject::move();
+} //MoveBackgrounds
+
+/// Player system. Ships are plain objects, so they skip the virtual call.
+
+void CObjectManager::MovePlayers(){
+  for(auto const& p: m_vArchetype[PLAYER_ARCHETYPE])
+    p->CObject::move();
+} //MovePlayers
+
+/// Enemy system, for either light or heavy enemies. Enemies follow
+/// their paths in parallel, and any that wander off are put back on
+/// screen afterwards.
+/// \param a Archetype, light or heavy enemies.
+
+void CObjectManager::MoveEnemies(eArchetype a){
+  RunSystem(a, [&](UINT begin, UINT end, vector<Command>& commands){
+    for(UINT i=begin; i<end; i++){
+      CObject* const p = m_vArchetype[a][i];
+      p->move();
+
+      if(AtWorldEdge(p)) //dont leave screen
+        commands.push_back({RESPAWN_COMMAND, p});
+    } //for
+  });
+} //MoveEnemies
+
+/// Enemy decisions. Enemies whose guns have cooled down wait in the
+/// AI scheduler and take turns checking whether a player is in range,
+/// so that no more than a fixed number of them think each tick however
+/// many enemies there are. Those that fire start cooling down again,
+/// and the rest wait for another turn.
+
+void CObjectManager::ThinkEnemies(){
+  m_cAI.Turns(m_vTurns);
+
+  for(auto const& p: m_vTurns){
+    CObject* const target = NearestPlayer(p->m_vPos); //player to attack, if any are left
+
+    if(target && Vector2::DistanceSquared(target->m_vPos, p->m_vPos) < ENEMY_RANGE*ENEMY_RANGE){ //player in range for attack
+      Reload(p);
+      add(p->FireGun());
+    } //if
+
+    else m_cAI.Add(p); //try again later
+  } //for
+} //ThinkEnemies
+
+/// Boss system. There is only ever one boss at a time, so
+/// choosing its attacks by sprite type costs next to nothing.
+
+void CObjectManager::MoveBosses(){
+  for(auto const& p: m_vArchetype[BOSS_ARCHETYPE]){
+    p->move();
+    CObject* const target = NearestPlayer(p->m_vPos); //player that the boss goes after
+    if(target == nullptr)continue; //nobody left to attack
+
+    switch(p->m_nSpriteIndex){
+      case HOTSHOT: HotShotAttacks(p, target); break;
+      case LILBOY: LittleBoyAttacks(p, target); break;
+      case BLACK_JACK: BlackJackAttacks(p, target); break;
+    } //switch
+  } //for
+} //MoveBosses
+
+/// Bullet system. Bullets are moved and tested against the edge of the
+/// world in the bullet arrays, without touching the objects, and then
+/// their new positions are copied into the objects. All they do is die
+/// at the edge of the world.
+
+void CObjectManager::MoveBullets(){
+  const float dt = m_pSimTimer->GetElapsedSeconds();
+  const vector<CObject*>& v = m_vArchetype[BULLET_ARCHETYPE];
+
+  RunSystem(BULLET_ARCHETYPE, [&](UINT begin, UINT end, vector<Command>& commands){
+    m_cBullets.Move(begin, end, dt, m_vWorldSize);
+
+    for(UINT i=begin; i<end; i++){ //copy back to the objects
+      CObject* const p = v[i];
+      p->m_vPos = m_cBullets.GetPos(i);
+      p->m_Sphere.Center = (Vector3)p->m_vPos;
+      p->Animate();
+
+      if(m_cBullets.IsOut(i))
+        commands.push_back({KILL_COMMAND, p});
+    } //for
+  });
+} //MoveBullets
+
+/// Hazard system. Hazards die at the edge of the world or when their
+/// time is up, and LittleBoy's bomb goes off when it gets low enough.
+
+void CObjectManager::MoveHazards(){
+  RunSystem(HAZARD_ARCHETYPE, [&](UINT begin, UINT end, vector<Command>& commands){
+    for(UINT i=begin; i<end; i++){
+      CObject* const p = m_vArchetype[HAZARD_ARCHETYPE][i];
+      p->move();
+
+      if(Expired(p))
+        commands.push_back({KILL_COMMAND, p});
+
+      else if(p->m_nSpriteIndex == LILBOMB && p->m_vPos.y <= 200.0f){ //Littleboys bomb is triggered
+        commands.push_back({KILL_COMMAND, p});
+        commands.push_back({SPAWN_COMMAND, nullptr, BIG_EXPLOSION, p->GetPos()});
+      } //else if
+    } //for
+  });
+} //MoveHazards
+
+/// Effect system. Effects are plain objects, so they skip the virtual
+/// call. They die when their time is up, and pickups home in on the
+/// nearest player.
+
+void CObjectManager::MoveEffects(){
+  RunSystem(EFFECT_ARCHETYPE, [&](UINT begin, UINT end, vector<Command>& commands){
+    for(UINT i=begin; i<end; i++){
+      CObject* const p = m_vArchetype[EFFECT_ARCHETYPE][i];
+      p->CObject::move();
+
+      CObject* const target = p->m_nSpriteIndex == PICKUP? NearestPlayer(p->m_vPos): nullptr;
+
+      if(target){ //pickups home in on the nearest player
+        const Vector2 v = target->m_vPos - p->m_vPos;
+        p->SetVelocity(PICKUP_SPEED*v/max(v.Length(), 1.0f));
+      } //if
+
+      if(Expired(p))
+        commands.push_back({KILL_COMMAND, p});
+    } //for
+  });
+} //MoveEffects
+
+/// HotShot shoots fireballs or summons a fire trap
+/// beside the player when his gun has cooled down.
+/// \param p Pointer to HotShot.
+/// \param target Player that HotShot goes after.
+
+void CObjectManager::HotShotAttacks(CObject* p, CObject* target){
+  const Vector2 v = target->m_vPos - p->m_vPos;//distance from player
+  const bool bVisible = v.LengthSquared() < HOTSHOT_RANGE*HOTSHOT_RANGE;
+
+  if(bVisible && p->m_bArmed){
+    Reload(p);
+    const int choose_attack = m_pGameRandom->rand() % 100; //randomly choose hotshots attack
+
+    if(choose_attack < 70) //shoots fireballs
+      add(p->FireGun());
+
+    else{ //Hotshot summons firetrap
+      const float range = 512.0f - target->m_vPos.x;
+      Vector2 pos(0.0f, target->m_vPos.y);
+
+      if(range >= 0)
+        pos.x = target->m_vPos.x + 250.0f; //spawn right of the player
+      else
+        pos.x = target->m_vPos.x - 250.0f; //spawn to the left of player
+
+      add(p->Attack1(pos));
+    } //else
+  } //if
+} //HotShotAttacks
+
+/// LittleBoy either drops a bomb or shoots a spread of bullets
+/// when the player is underneath and his gun has cooled down.
+/// \param p Pointer to LittleBoy.
+/// \param target Player that LittleBoy goes after.
+
+void CObjectManager::LittleBoyAttacks(CObject* p, CObject* target){
+  const Vector2 range = target->GetPos() - p->GetPos(); //distance between player and littleboy
+  const bool in_range = abs(range.x) < LILBOY_REACH && range.LengthSquared() < LILBOY_RANGE*LILBOY_RANGE; //player is in range for attack
+
+  if(in_range && p->m_bArmed){ //Either shoots gun or drops bomb
+    Reload(p);
+    const int choose_attack = m_pGameRandom->rand() % 100; //Randomly chooses which attack littleboy will do
+
+    if(choose_attack < 25)
+      add(p->Attack1(Vector2::Zero));
+
+    else{ //Shoots diverse colors of bullets
+      CObject* b1 = p->FireGun();
+      CObject* b2 = p->FireGun();
+      CObject* b3 = p->FireGun();
+      add(b1);
+      add(b2);
+      add(b3);
+    } //else
+  } //if
+
+  if(AtWorldEdge(p)) //Make sure littleboy does not leave screen
+    p->CollisionResponse();
+} //LittleBoyAttacks
+
+/// BlackJack fires its gun, summons cards, puts up its force field or
+/// charges at the player when his gun has cooled down, and summons a
+/// black hole when that has cooled down. Cards, the force field and
+/// black holes each have their own cooldown, and his timer changes
+/// the players' colors.
+/// \param p Pointer to BlackJack.
+/// \param target Player that BlackJack goes after.
+
+void CObjectManager::BlackJackAttacks(CObject* p, CObject* target){
+  BossState* boss = p->GetBoss();
+  const Vector2 range = target->GetPos() - p->GetPos(); //distance between player and blackjack
+  const bool in_range = range.x < BLACK_JACK_REACH && range.LengthSquared() < BLACK_JACK_RANGE*BLACK_JACK_RANGE; //Player is in range for attack
+
+  //FireGun, change player colors, change its own colors, forcefield, Cards, charge at player
+  if(in_range && p->m_bArmed){
+    Reload(p);
+    const int choose_attack = m_pGameRandom->rand() % 100; //randomly choose blackjacks next move
+
+    //summons random poker cards every 21 seconds
+    if(choose_attack < 23 && !boss->m_bCharging && boss->m_bCardsReady){
+      CObject* c1 = new CObject(CARD, Vector2(200.0f, 1000.0f));
+      CObject* c2 = new CObject(CARD, Vector2(500.0f, 1000.0f));
+      CObject* c3 = new CObject(CARD, Vector2(750.0f, 1000.0f));
+      c1->SetVelocity(Vector2(0.0f,-110.0f));
+      c2->SetVelocity(c1->GetVelocity());
+      c3->SetVelocity(c2->GetVelocity());
+      add(c1);
+      add(c2);
+      add(c3);
+      boss->m_bCardsReady = false;
+      Schedule(p, CARD_TIMER, CARD_COOLDOWN);
+    } //if
+
+    else if(choose_attack < 75 && !boss->m_bCharging){ //Fire gun
+      CObject* b1 = p->FireGun();
+      CObject* b2 = p->FireGun();
+      add(b1);
+      add(b2);
+    } //else if
+
+    else if(!boss->m_bForceFieldOn && boss->m_bForceFieldReady && !boss->m_bStrafeForward && !p->m_bStrafeBack){ //Force field
+      CObject* ff = new CObject(FORCE_FIELD, p->GetPos()); 
+      p->ActivateForceField(ff);
+      boss->m_bForceFieldReady = false; //until it goes down and cools off
+      m_cAttachments.Attach(ff, p, Vector2::Zero); //force field goes where blackjack goes
+      add(ff);
+    } //else if
+
+    else if(!boss->m_bCharging && !boss->m_bForceFieldOn) //Charge at player
+      p->Charge();
+  } //if
+
+  //blackjacks Blackhole is summoned 10 seconds after the last one closed as long as it is not charging
+  if(boss->m_bBlackHoleReady && !boss->m_bCharging && !boss->m_bBlackHoleOn){
+    const float range = 512.0f - target->m_vPos.x;
+    Vector2 pos(0.0f, target->m_vPos.y);
+
+    if(range >= 0)
+      pos.x = target->m_vPos.x + 250.0f; //will spawn to the right of the player
+    else 
+      pos.x = target->m_vPos.x - 250.0f; //will spawn to the players left
+
+    add(new CObject(BLACK_HOLE, pos));
+    boss->m_bBlackHoleOn = true;
+    boss->m_bBlackHoleReady = false; //until it closes and cools off
+    m_pEventQueue->loop(BH_SOUND);
+  } //if
+
+  //Make sure black jack does not leave the screen
+  if(AtWorldEdge(p))
+    p->CollisionResponse();
+} //BlackJackAttacks
+
 /// Create a bullet object and a flash particle effect.
 /// It is assumed that the object is round and that the bullet
 /// appears at the edge of the object in the direction
@@ -416,7 +919,7 @@ void CObjectManager::move(){
 /// \param bullet Sprite type of bullet.
 
 void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
-  m_pAudio->play(GUN_SOUND);
+  m_pEventQueue->play(GUN_SOUND);
 
   const Vector2 view = pObj->GetViewVector();
   Vector2 pos = pObj->GetPos() + 
@@ -427,7 +930,7 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
   CObject* pBullet = m_pObjectManager->create(bullet, pos); //create bullet
 
   const Vector2 norm(view.y, -view.x); //normal to direction
-  const float m = 2.0f*m_pRandom->randf() - 1.0f;
+  const float m = 2.0f*m_pGameRandom->randf() - 1.0f;
   const Vector2 deflection = 0.01f*m*norm;
 
   pBullet->SetVelocity(m_pPlayer->GetVelocity() + 500.0f*(view + deflection));
@@ -451,7 +954,10 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
 /// This is a "bring out yer dead" Monty Python type of thing.
 /// Iterate through the objects and check whether their "is dead"
 /// flag has been set. If so, then delete its pointer from
-/// the object list and destruct the object.
+/// the object list and destruct the object. The objects are deleted
+/// together at the end, after they have been taken out of their
+/// archetypes, so that a new object cannot be given the address of
+/// a dead one while the archetypes still hold it.
 
 void CObjectManager::CullDeadObjects(){
   for(auto i=m_stdObjectList.begin(); i!=m_stdObjectList.end();){
@@ -460,61 +966,568 @@ void CObjectManager::CullDeadObjects(){
           || (*i)->m_nSpriteIndex == RED_HEAVY_ENEMY))
       {
           enemyCount--;
-             delete* i; //delete object-
+             m_vDying.push_back(*i); //delete it later
           i = m_stdObjectList.erase(i); //remove from object list and advance to next object
       }
       //Boss is dead
       else if ((*i)->IsDead() && ((*i)->m_nSpriteIndex == HOTSHOT || (*i)->m_nSpriteIndex == LILBOY || (*i)->m_nSpriteIndex == BLACK_JACK))
       {
-          m_pAudio->play(DEATH_SOUND);
+          m_pEventQueue->play(DEATH_SOUND);
           CObject* exp = new CObject(BIG_EXPLOSION, (*i)->GetPos());
-          m_stdObjectList.push_back(exp);
+          add(exp);
           bossCount--;
-          delete* i; //delete object-
+          if(*i == currentBoss)
+            currentBoss = nullptr; //so that nothing reaches it once it is deleted
+          m_vDying.push_back(*i); //delete it later
           i = m_stdObjectList.erase(i); //remove from object list and advance to next object
       }
       //Littleboys bomb explodes
       else if ((*i)->IsDead() && (*i)->m_nSpriteIndex == LILBOMB) {
-          m_pAudio->play(DEATH_SOUND);
+          m_pEventQueue->play(DEATH_SOUND);
           CObject* exp = new CObject(BIG_EXPLOSION, (*i)->GetPos());
-          m_stdObjectList.push_back(exp);
-          delete* i;
+          add(exp);
+          m_vDying.push_back(*i);
           i = m_stdObjectList.erase(i);
       }
       else if ((*i)->m_nSpriteIndex == FORCE_FIELD && (*i)->IsDead()) { //blackjacks Force field is destroyed
-           currentBoss->ff_on = false;
-           currentBoss->m_fForceFieldTimer = m_pStepTimer->GetTotalSeconds();
-           delete* i;
+           if(currentBoss && currentBoss->m_nSpriteIndex == BLACK_JACK){ //unless blackjack was deleted first
+             currentBoss->GetBoss()->m_bForceFieldOn = false;
+             currentBoss->GetBoss()->m_pForceField = nullptr;
+             if(!currentBoss->IsDead())
+               Schedule(currentBoss, FORCE_FIELD_TIMER, FORCE_FIELD_COOLDOWN);
+           } //if
+           m_vDying.push_back(*i);
            i = m_stdObjectList.erase(i);
-           currentBoss->force_field = nullptr;
        }
       //anything else that is dead, bullets, player etc.
       else if (((*i)->IsDead()) || ((*i)->m_nSpriteIndex == SMALL_EXPLOSION && (*i)->explosionTooOld())) { //"He's dead, Dave." --- Holly, Red Dwarf
-      delete *i; //delete object-
+      if (*i == m_pPlayer)
+          m_pPlayer = nullptr; //enemies go after player 2 from now on
+      if (*i == m_pPlayer2)
+          m_pPlayer2 = nullptr; //enemies go after player 1 from now on
+      m_vDying.push_back(*i); //delete it later
       i = m_stdObjectList.erase(i); //remove from object list and advance to next object
     } //if
 
     else i++; //advance to next object
   } //for
+
+  Ungroup(m_vDying); //while they can still be looked at
+
+  for(auto const& p: m_vDying)
+    delete p;
+
+  m_vDying.clear();
 } //CullDeadObjects
 
 /// Perform collision detection and response for all pairs
 /// of objects in the object list, making sure that each
-/// pair is processed only once.
+/// pair is processed only once. Objects are tested as circles
+/// swept from where they were at the start of the tick to where
+/// they are now, so that a fast object cannot pass right through
+/// another between ticks. Almost everything in this game moves up
+/// or down, so candidate pairs come from sweep and prune on y: the
+/// circles are kept sorted by the bottom of the y-interval that
+/// they sweep, and each one only needs to be tested against those
+/// after it that start below its top. Testing the candidates is split
+/// into chunks that run in parallel, each writing to its own contact
+/// list. The responses change the objects and play sounds, so they
+/// are done afterwards on this thread, in order of time of impact,
+/// with ties in object list order. That order does not depend on
+/// the sort order, the number of threads, or anything from
+/// previous ticks. Enemy shots and line hazards are left out of the
+/// circle test and tested against the ships separately.
 
 void CObjectManager::BroadPhase(){
-  for(auto i=m_stdObjectList.begin(); i!=m_stdObjectList.end(); i++){
-      for (auto j = next(i); j != m_stdObjectList.end(); j++)
-          NarrowPhase(*i, *j);
+  const UINT grain = 16; //proxies per chunk
+
+  m_vObjects.clear(); //circles first, then enemy shots, then bands
+
+  for(auto const& p: m_stdObjectList)
+    if(!IsBand(p->m_nSpriteIndex) && !IsShot(p->m_nSpriteIndex))
+      m_vObjects.push_back(p);
+
+  const UINT n = (UINT)m_vObjects.size(); //number of circles
+
+  for(auto const& p: m_stdObjectList)
+    if(IsShot(p->m_nSpriteIndex))
+      m_vObjects.push_back(p);
+
+  const UINT b = (UINT)m_vObjects.size(); //index of the first band
+
+  for(auto const& p: m_stdObjectList)
+    if(IsBand(p->m_nSpriteIndex))
+      m_vObjects.push_back(p);
+
+  SortProxies(n);
+
+  const UINT chunks = (n + grain - 1)/grain;
+
+  if(m_vPairs.size() < chunks)
+    m_vPairs.resize(chunks);
+
+  for(UINT c=0; c<chunks; c++) //with no workers the whole loop runs as one chunk
+    m_vPairs[c].clear();
+
+  const vector<SweepProxy>& sorted = m_cSweep.GetProxies();
+
+  m_pJobSystem->ParallelFor(n, grain, [&](UINT begin, UINT end){
+    vector<Contact>& pairs = m_vPairs[begin/grain];
+
+    for(UINT k=begin; k<end; k++){
+      const SweepProxy& a = sorted[k];
+
+      for(UINT m=k + 1; m<n && sorted[m].m_fLo <= a.m_fHi; m++){
+        UINT i = a.m_nIndex, j = sorted[m].m_nIndex;
+        if(i > j)swap(i, j); //first in list order goes first
+
+        float t;
+        UINT part = 0;
+
+        if(Sweep(m_vObjects[i], m_vObjects[j], t) && Refine(m_vObjects[i], m_vObjects[j], t, part))
+          pairs.push_back({i, j, t, part});
+      } //for
+    } //for
+  });
+
+  m_vContacts.clear();
+
+  for(UINT c=0; c<chunks; c++)
+    m_vContacts.insert(m_vContacts.end(), m_vPairs[c].begin(), m_vPairs[c].end());
+
+  QueryShots(n, b); //ships against enemy shots
+  QueryCancels(n, b); //player shots against enemy shots
+  QueryBands(n, b); //ships against line hazards
+
+  sort(m_vContacts.begin(), m_vContacts.end(), [](const Contact& a, const Contact& b){
+    if(a.m_fTime != b.m_fTime)return a.m_fTime < b.m_fTime;
+    if(a.m_nFirst != b.m_nFirst)return a.m_nFirst < b.m_nFirst;
+    return a.m_nSecond < b.m_nSecond;
+  });
+
+  for(auto const& c: m_vContacts){ //responses, earliest first
+    CObject* const p0 = m_vObjects[c.m_nFirst];
+    CObject* const p1 = m_vObjects[c.m_nSecond];
+
+    if(c.m_nPart > 0)PartHit(p0, p1, c.m_nPart);
+    else if(c.m_nSecond < n || c.m_nSecond >= b)NarrowPhase(p0, p1);
+    else if(p0->m_nSpriteIndex == BULLET_SPRITE)ShotCancel(p0, p1);
+    else ShotHit(p0, p1);
   } //for
 } //BroadPhase
 
+/// Bring the sweep and prune proxies up to date for this tick. Each
+/// object keeps its place in last tick's sorted order, which
+/// CSweepPrune uses to sort this tick's intervals in close to linear
+/// time.
+/// \param n Number of circles at the start of m_vObjects.
+
+void CObjectManager::SortProxies(UINT n){
+  m_vProxies.clear();
+  m_vRanks.clear();
+
+  for(UINT i=0; i<n; i++){
+    m_vProxies.push_back(MakeProxy(i));
+    m_vRanks.push_back(m_vObjects[i]->m_nSweepRank);
+  } //for
+
+  m_cSweep.Sort(m_vProxies, m_vRanks);
+
+  for(UINT i=0; i<n; i++) //remember the order for next tick
+    m_vObjects[i]->m_nSweepRank = m_vRanks[i];
+} //SortProxies
+
+/// Make a sweep and prune proxy for an object, that is, the y-interval
+/// covered by its bounding circle as it moves over the tick.
+/// \param i Index of the object in m_vObjects.
+/// \return The proxy.
+
+SweepProxy CObjectManager::MakeProxy(UINT i){
+  CObject* p = m_vObjects[i];
+  const float r = p->m_Sphere.Radius;
+  const float y1 = p->m_Sphere.Center.y; //now
+
+  Vector2 d = p->m_vPos - p->m_vOldPos; //motion this tick
+  if(d.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d = Vector2::Zero; //teleported
+
+  const float y0 = y1 - d.y; //start of tick
+
+  return {min(y0, y1) - r, max(y0, y1) + r, i};
+} //MakeProxy
+
+/// Swept circle test. Each object's bounding circle moves in a straight
+/// line from its position at the start of the tick to its position now.
+/// Working in the first object's frame, the second one moves along
+/// a single line, and the time at which the distance between them
+/// first equals the sum of the radii is the smaller root of a quadratic.
+/// An object that moved further than MAX_SWEEP in one tick was
+/// teleported rather than moved, so it is tested where it is now.
+/// \param p0 Pointer to the first object.
+/// \param p1 Pointer to the second object.
+/// \param t [out] Fraction of the tick at which they first touch.
+/// \return true if they touch at some time during the tick.
+
+bool CObjectManager::Sweep(CObject* p0, CObject* p1, float& t){
+  Vector2 d0 = p0->m_vPos - p0->m_vOldPos; //first object's motion
+  Vector2 d1 = p1->m_vPos - p1->m_vOldPos; //second object's motion
+
+  if(d0.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d0 = Vector2::Zero;
+  if(d1.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d1 = Vector2::Zero;
+
+  const float r = p0->m_Sphere.Radius + p1->m_Sphere.Radius; //sum of radii
+  const Vector2 v = d1 - d0; //relative motion
+  const Vector2 p = Vector2(p1->m_Sphere.Center) - Vector2(p0->m_Sphere.Center) - v; //relative position at start
+
+  const float c = p.LengthSquared() - r*r;
+
+  if(c <= 0.0f){ //touching at the start of the tick
+    t = 0.0f;
+    return true;
+  } //if
+
+  const float a = v.LengthSquared();
+  const float b = p.Dot(v);
+  if(a == 0.0f || b >= 0.0f)return false; //not closing
+
+  const float disc = b*b - a*c;
+  if(disc < 0.0f)return false; //closest approach is too far apart
+
+  t = (-b - sqrtf(disc))/a;
+  return t <= 1.0f;
+} //Sweep
+
+/// Find contacts between ships and enemy shots. The shots are packed
+/// into arrays and each ship is tested against a whole block of them
+/// at a time, using the same swept circle test as the other objects.
+/// Shots of the ship's own color are absorbed on the spot. They are
+/// taken out of the block's live mask so that the other ship cannot
+/// absorb them too, and only their number goes to the chain scorer.
+/// The rest do damage if they get through the pixel mask test, so they
+/// become contacts and wait their turn.
+/// Shots that come within GRAZE_MARGIN of a ship but miss it graze it,
+/// which the same test finds at the same time. Each shot remembers
+/// whether it has grazed, so that it only counts once, however many
+/// ticks it spends close to the ship.
+/// \param n Number of circles at the start of m_vObjects. Ships are among them.
+/// \param b Index one past the last shot. The shots follow the circles.
+
+void CObjectManager::QueryShots(UINT n, UINT b){
+  if(b == n)return; //no shots
+
+  m_cShots.Clear();
+
+  for(UINT i=n; i<b; i++){
+    CObject* p = m_vObjects[i];
+    const int t = p->m_nSpriteIndex;
+    const char color = t == RED_BULLET? 'r': t == BLUE_BULLET? 'b': 0;
+
+    Vector2 d = p->m_vPos - p->m_vOldPos; //motion this tick
+    if(d.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d = Vector2::Zero; //teleported
+    m_cShots.Add(Vector2(p->m_Sphere.Center) - d, d, p->m_Sphere.Radius, color, !p->m_bDead, p->m_bGrazed);
+  } //for
+
+  m_cShots.Pad();
+
+  for(UINT j=0; j<n; j++){ //for each ship
+    CObject* ship = m_vObjects[j];
+    const int t = ship->m_nSpriteIndex;
+    if((t != BLUE_SHIP && t != RED_SHIP) || ship->m_bDead)continue; //dead ships absorb nothing
+
+    const char color = t == RED_SHIP? 'r': 'b';
+    const UINT player = ship == m_pPlayer2? 1: 0;
+    UINT absorbed = 0;
+    UINT grazed = 0;
+
+    Vector2 d = ship->m_vPos - ship->m_vOldPos;
+    if(d.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d = Vector2::Zero;
+    const Vector2 pos = Vector2(ship->m_Sphere.Center) - d;
+
+    for(UINT k=0; k<m_cShots.GetNumBlocks(); k++){
+      float toi[CShotPack::BLOCK];
+      UINT nearby = 0;
+      const UINT mask = m_cShots.Test(k, pos, d, ship->m_Sphere.Radius, GRAZE_MARGIN, toi, nearby);
+
+      const UINT grazes = m_cShots.Graze(k, nearby & ~mask); //near misses
+      grazed += (UINT)bitset<CShotPack::BLOCK>(grazes).count();
+
+      for(UINT lane=0, m=grazes; m; lane++, m >>= 1)
+        if(m & 1)
+          m_vObjects[n + k*CShotPack::BLOCK + lane]->m_bGrazed = true;
+
+      if(mask == 0)continue;
+
+      const UINT same = m_cShots.GetColorMask(k, color);
+      const UINT taken = m_cShots.Take(k, mask & same); //absorbed
+      absorbed += (UINT)bitset<CShotPack::BLOCK>(taken).count();
+
+      for(UINT lane=0, m=taken; m; lane++, m >>= 1)
+        if(m & 1)
+          m_vObjects[n + k*CShotPack::BLOCK + lane]->kill(); // destroy bullet
+
+      for(UINT lane=0, m=mask & ~same; m; lane++, m >>= 1) //damage
+        if(m & 1){
+          const UINT i = n + k*CShotPack::BLOCK + lane;
+          if(PixelHit(ship, m_vObjects[i], toi[lane]))
+            m_vContacts.push_back({j, i, toi[lane]});
+        } //if
+    } //for
+
+    if(absorbed > 0)
+      m_cChain.Absorb(player, absorbed);
+
+    if(grazed > 0)
+      m_cChain.Graze(player, grazed);
+  } //for
+} //QueryShots
+
+/// Response to an enemy shot of the other color hitting a ship.
+/// \param ship Pointer to the ship.
+/// \param shot Pointer to the shot.
+
+void CObjectManager::ShotHit(CObject* ship, CObject* shot){
+  if(ship->m_bDead || shot->m_bDead)return; //used up by an earlier contact
+
+  shot->kill(); // destroy bullet
+  ship->hit(); // player is hit
+} //ShotHit
+
+/// Get the axis-aligned box around the circle that an object sweeps
+/// over the tick.
+/// \param p Pointer to the object.
+/// \param lo [out] Bottom left corner.
+/// \param hi [out] Top right corner.
+
+void CObjectManager::SweptBox(CObject* p, Vector2& lo, Vector2& hi){
+  const Vector2 c1 = Vector2(p->m_Sphere.Center); //now
+  const Vector2 r(p->m_Sphere.Radius, p->m_Sphere.Radius);
+
+  Vector2 d = p->m_vPos - p->m_vOldPos; //motion this tick
+  if(d.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d = Vector2::Zero; //teleported
+
+  const Vector2 c0 = c1 - d; //start of tick
+  lo = Vector2::Min(c0, c1) - r;
+  hi = Vector2::Max(c0, c1) + r;
+} //SweptBox
+
+/// Compound hitbox test for a pair whose bounding circles touch. If
+/// one is a player shot and the other has a compound hitbox, the shot
+/// is tested against the hitbox's parts in the other object's frame,
+/// which turns a hit on an empty corner of the sprite into a miss and
+/// gives the time at which the part was hit. Other pairs get the pixel
+/// mask test.
+/// \param p0 Pointer to the first object.
+/// \param p1 Pointer to the second object.
+/// \param t [in, out] Time of impact.
+/// \param part [out] Part hit, counting from 1, or 0 if there is no hitbox.
+/// \return false if the shot misses all of the parts.
+
+bool CObjectManager::Refine(CObject* p0, CObject* p1, float& t, UINT& part){
+  part = 0;
+
+  CObject* shot = p0;
+  CObject* target = p1;
+  if(target->m_nSpriteIndex == BULLET_SPRITE)swap(shot, target);
+  if(shot->m_nSpriteIndex != BULLET_SPRITE)return PixelHit(p0, p1, t);
+
+  const CHitbox& box = m_vHitboxes[target->m_nSpriteIndex];
+  if(box.IsEmpty())return true;
+
+  Vector2 d0 = shot->m_vPos - shot->m_vOldPos; //motion this tick
+  if(d0.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d0 = Vector2::Zero; //teleported
+
+  Vector2 d1 = target->m_vPos - target->m_vOldPos;
+  if(d1.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d1 = Vector2::Zero;
+
+  const Vector2 pos = (Vector2(shot->m_Sphere.Center) - d0) - (Vector2(target->m_Sphere.Center) - d1);
+
+  part = box.Test(pos, d0 - d1, shot->m_Sphere.Radius, t);
+  return part > 0;
+} //Refine
+
+/// Pixel mask test for a pair whose bounding circles touch. If both
+/// sprites have masks, they only really touch if the masks overlap.
+/// The masks are compared where the objects are at the time of impact,
+/// halfway from there to the end of the tick, and at the end of the
+/// tick, which between them cover all but the thinnest slivers of art
+/// at the speeds things move here. Objects are not rotated, so the
+/// masks are too.
+/// \param p0 Pointer to the first object.
+/// \param p1 Pointer to the second object.
+/// \param t [in, out] Time of impact, moved on to the first time at which the masks overlap.
+/// \return false if the masks never overlap.
+
+bool CObjectManager::PixelHit(CObject* p0, CObject* p1, float& t){
+  const int t0 = p0->m_nSpriteIndex;
+  const int t1 = p1->m_nSpriteIndex;
+  if(!m_cMasks.HasMask(t0) || !m_cMasks.HasMask(t1))return true;
+
+  Vector2 d0 = p0->m_vPos - p0->m_vOldPos; //motion this tick
+  if(d0.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d0 = Vector2::Zero; //teleported
+
+  Vector2 d1 = p1->m_vPos - p1->m_vOldPos;
+  if(d1.LengthSquared() > MAX_SWEEP*MAX_SWEEP)d1 = Vector2::Zero;
+
+  const float times[3] = {t, 0.5f*(t + 1.0f), 1.0f};
+
+  for(const float s: times){
+    const Vector2 q0 = p0->m_vPos - (1.0f - s)*d0;
+    const Vector2 q1 = p1->m_vPos - (1.0f - s)*d1;
+
+    if(m_cMasks.Overlap(t0, p0->m_nCurrentFrame, q0, t1, p1->m_nCurrentFrame, q1)){
+      t = s;
+      return true;
+    } //if
+  } //for
+
+  return false;
+} //PixelHit
+
+/// Response to a player shot hitting part of a compound hitbox. The
+/// shot is used up and the target takes the part's damage.
+/// \param p0 Pointer to the first object.
+/// \param p1 Pointer to the second object.
+/// \param part Part hit, counting from 1.
+
+void CObjectManager::PartHit(CObject* p0, CObject* p1, UINT part){
+  if(p0->m_bDead || p1->m_bDead)return; //used up by an earlier contact
+
+  CObject* shot = p0;
+  CObject* target = p1;
+  if(target->m_nSpriteIndex == BULLET_SPRITE)swap(shot, target);
+
+  shot->kill(); // destroy bullet
+  m_nShooter = shot->m_nPlayer; //credit for the kill
+  target->enemyHit(m_vHitboxes[target->m_nSpriteIndex].GetDamage(part));
+
+  if(target->m_nSpriteIndex == RED_HEAVY_ENEMY || target->m_nSpriteIndex == BLUE_HEAVY_ENEMY)
+    m_pEventQueue->play(CLANG_SOUND);
+} //PartHit
+
+/// Find contacts between player shots and enemy shots of the other
+/// color, if shot cancelling is on. There can be thousands of each,
+/// so testing every pair is out of the question. Instead the enemy
+/// shots' swept boxes are binned into a uniform grid, and each player
+/// shot probes the grid with its own swept box. Candidates of the right
+/// color get the swept circle test, and hits become contacts so that
+/// they are responded to in time of impact order with everything else.
+/// \param n Number of circles at the start of m_vObjects. Player shots are among them.
+/// \param b Index one past the last shot. The shots follow the circles.
+
+void CObjectManager::QueryCancels(UINT n, UINT b){
+  if(!m_bShotCancel || b == n)return;
+
+  Vector2 lo, hi;
+  m_cShotGrid.Clear();
+
+  for(UINT i=n; i<b; i++){
+    SweptBox(m_vObjects[i], lo, hi);
+    m_cShotGrid.Add(lo, hi);
+  } //for
+
+  m_cShotGrid.Build();
+
+  for(UINT j=0; j<n; j++){ //for each player shot
+    CObject* bullet = m_vObjects[j];
+    if(bullet->m_nSpriteIndex != BULLET_SPRITE || bullet->m_bDead)continue;
+
+    const int other = bullet->m_cPolarity == 'r'? BLUE_BULLET: bullet->m_cPolarity == 'b'? RED_BULLET: -1;
+    if(other < 0)continue; //fired by nobody in particular
+
+    SweptBox(bullet, lo, hi);
+    m_cShotGrid.Query(lo, hi, m_vNearShots);
+
+    for(auto const& k: m_vNearShots){
+      CObject* shot = m_vObjects[n + k];
+      float t;
+
+      if(shot->m_nSpriteIndex == other && Sweep(bullet, shot, t))
+        m_vContacts.push_back({j, n + k, t});
+    } //for
+  } //for
+} //QueryCancels
+
+/// Response to a player shot meeting an enemy shot of the other color.
+/// They cancel each other out.
+/// \param bullet Pointer to the player shot.
+/// \param shot Pointer to the enemy shot.
+
+void CObjectManager::ShotCancel(CObject* bullet, CObject* shot){
+  if(bullet->m_bDead || shot->m_bDead)return; //used up by an earlier contact
+
+  bullet->kill();
+  shot->kill();
+} //ShotCancel
+
+/// Find contacts between ships and line hazards. A line is as wide
+/// as the world, so it is a band in y, and since everything moves
+/// in a straight line over a tick, a ship and a line touch if the
+/// ship's center comes within LINE_BAND of the line in y at some time
+/// during the tick. Each line's swept y-interval goes into a list
+/// sorted by its lower end, and each ship finds the lines whose
+/// interval could overlap its own by binary search on that list.
+/// \param n Number of circles at the start of m_vObjects.
+/// \param b Index of the first line in m_vObjects. The lines are at the end.
+
+void CObjectManager::QueryBands(UINT n, UINT b){
+  m_vBands.clear();
+  float extent = 0.0f; //largest band interval
+
+  for(UINT i=b; i<(UINT)m_vObjects.size(); i++){
+    CObject* p = m_vObjects[i];
+    const float y0 = p->m_vOldPos.y, y1 = p->m_vPos.y;
+    const Band band = {min(y0, y1) - LINE_BAND, max(y0, y1) + LINE_BAND, i};
+    extent = max(extent, band.m_fHi - band.m_fLo);
+    m_vBands.push_back(band);
+  } //for
+
+  if(m_vBands.empty())return;
+
+  sort(m_vBands.begin(), m_vBands.end(),
+    [](const Band& a, const Band& b){return a.m_fLo < b.m_fLo || (a.m_fLo == b.m_fLo && a.m_nIndex < b.m_nIndex);});
+
+  for(UINT j=0; j<n; j++){ //for each ship
+    CObject* ship = m_vObjects[j];
+    const int t = ship->m_nSpriteIndex;
+    if(t != BLUE_SHIP && t != RED_SHIP)continue;
+
+    float y0 = ship->m_vOldPos.y, y1 = ship->m_vPos.y;
+    if(fabsf(y1 - y0) > MAX_SWEEP)y0 = y1; //teleported
+
+    const float lo = min(y0, y1), hi = max(y0, y1);
+
+    auto it = lower_bound(m_vBands.begin(), m_vBands.end(), lo - extent,
+      [](const Band& b, float y){return b.m_fLo < y;});
+
+    for(; it != m_vBands.end() && it->m_fLo <= hi; ++it){
+      if(it->m_fHi < lo)continue;
+
+      CObject* line = m_vObjects[it->m_nIndex];
+      float l0 = line->m_vOldPos.y, l1 = line->m_vPos.y;
+      if(fabsf(l1 - l0) > MAX_SWEEP)l0 = l1; //teleported
+
+      const float p = y0 - l0; //ship relative to line at start
+      const float v = (y1 - y0) - (l1 - l0); //relative motion
+      float toi = -1.0f;
+
+      if(fabsf(p) <= LINE_BAND)toi = 0.0f; //in the band at the start
+      else if(p > LINE_BAND && v < 0.0f)toi = (LINE_BAND - p)/v; //entering from above
+      else if(p < -LINE_BAND && v > 0.0f)toi = (-LINE_BAND - p)/v; //entering from below
+
+      if(toi >= 0.0f && toi <= 1.0f)
+        m_vContacts.push_back({it->m_nIndex, j, toi});
+    } //for
+  } //for
+} //QueryBands
+
 /// Perform collision detection and response for a pair of objects.
 /// We are talking about bullets hitting the player and the
 /// turrets here. When a collision is detected the response
 /// is to delete the bullet (i.e. mark its "is dead" flag)
 /// play a particle effect at the point of contact, and play one 
-/// sound for the player and another for the turrets.
+/// sound for the player and another for the turrets. The broad phase
+/// has already found that the pair touch, and contacts arrive in time
+/// order, so a bullet that was used up by an earlier contact this tick
+/// does not hit anything else.
 /// \param p0 Pointer to the first object.
 /// \param p1 Pointer to the second object.
 
@@ -522,7 +1535,9 @@ void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
   eSpriteType t0 = (eSpriteType)p0->m_nSpriteIndex;
   eSpriteType t1 = (eSpriteType)p1->m_nSpriteIndex;
 
-  if(p0->m_Sphere.Intersects(p1->m_Sphere)){ //bounding spheres intersect
+  if(!p0->m_bDead && !p1->m_bDead){ //not used up by an earlier contact this tick
+    if(t0 == BULLET_SPRITE)m_nShooter = p0->m_nPlayer; //credit for any kill
+    else if(t1 == BULLET_SPRITE)m_nShooter = p1->m_nPlayer;
 
    //Contact between the light red enemy and the player
       if (t0 == BLUE_SHIP && t1 == RED_LIGHT_ENEMY) //player hits enemy
@@ -627,111 +1642,49 @@ void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
 //Contact between the light enemy and the players bullet
     else if(t0 == BULLET_SPRITE && t1 == RED_LIGHT_ENEMY){ //bullet hits turret
         p0->kill(); // destroy bullet
-      m_pAudio->play(CLANG_SOUND);
+      m_pEventQueue->play(CLANG_SOUND);
     } //if
 
     else if(t1 == BULLET_SPRITE && t0 == RED_LIGHT_ENEMY){ //enemy hit by bullet
       p1->kill(); // destroy bullet
       p0->enemyHit();   // turret is hit
-      m_pAudio->play(CLANG_SOUND);
+      m_pEventQueue->play(CLANG_SOUND);
     } //else if
     else if (t0 == BULLET_SPRITE && t1 == BLUE_LIGHT_ENEMY) { //bullet hits enemy
         p0->kill(); // destroy bullet
-        m_pAudio->play(CLANG_SOUND);
+        m_pEventQueue->play(CLANG_SOUND);
     } //if
 
     else if (t1 == BULLET_SPRITE && t0 == BLUE_LIGHT_ENEMY) { //enemy hit by bullet
         p1->kill(); // destroy bullet
         p0->enemyHit(); // turret is hit
-        m_pAudio->play(CLANG_SOUND);
+        m_pEventQueue->play(CLANG_SOUND);
     } //else if
 
 
       //Contact between the heavy enemy and the players bullet
     else if (t0 == BULLET_SPRITE && t1 == RED_HEAVY_ENEMY) { //bullet hits turret
           p0->kill(); // destroy bullet
-          m_pAudio->play(CLANG_SOUND);
+          m_pEventQueue->play(CLANG_SOUND);
       } //if
 
     else if (t1 == BULLET_SPRITE && t0 == RED_HEAVY_ENEMY) { //enemy hit by bullet
           p1->kill(); // destroy bullet
           p0->enemyHit();   // turret is hit
-          m_pAudio->play(CLANG_SOUND);
+          m_pEventQueue->play(CLANG_SOUND);
       } //else if
     else if (t0 == BULLET_SPRITE && t1 == BLUE_HEAVY_ENEMY) { //bullet hits enemy
           p0->kill(); // destroy bullet
-          m_pAudio->play(CLANG_SOUND);
+          m_pEventQueue->play(CLANG_SOUND);
       } //if
 
     else if (t1 == BULLET_SPRITE && t0 == BLUE_HEAVY_ENEMY) { //enemy hit by bullet
           p1->kill(); // destroy bullet
           p0->enemyHit(); // turret is hit
-          m_pAudio->play(CLANG_SOUND);
+          m_pEventQueue->play(CLANG_SOUND);
       } //else if
 
-//Contact between the regular enemy's bullet and the player
-     else if(t0 == RED_BULLET && t1 == BLUE_SHIP){ // blue player hit by red bullet
-      p0->kill(); // destroy bullet
-    } //else if
-
-     else if(t1 == RED_BULLET && t0 == BLUE_SHIP){ // red bullet hits blue player
-      p1->kill(); // destroy bullet
-      p0->hit(); // player is hit
-    } //else if
-     else if (t0 == BLUE_BULLET && t1 == RED_SHIP) { // red player hit by blue bullet
-        p0->kill(); // destroy bullet
-    } //else if
-
-     else if (t1 == BLUE_BULLET && t0 == RED_SHIP) { // blue bullet hits red player
-        p1->kill(); // destroy bullet
-        p0->hit(); // player is hit
-    } //else if
-
-
-     // same color bullet and ship collision
-     else if (t0 == BLUE_BULLET && t1 == BLUE_SHIP) { // blue player hit by blue bullet
-          p0->kill(); // destroy bullet
-          m_nScore += 10;
-          m_pAudio->play(ABSORB_SOUND);
-      } //else if
-
-     else if (t1 == BLUE_BULLET && t0 == BLUE_SHIP) { // blue bullet hits blue player
-          p1->kill(); // destroy bullet
-          m_nScore += 10;
-          m_pAudio->play(ABSORB_SOUND);
-      } //else if
-      
-     else if (t0 == RED_BULLET && t1 == RED_SHIP) { // red player hit by red bullet
-          p0->kill(); // destroy bullet
-          m_nScore += 10;
-          m_pAudio->play(ABSORB_SOUND);
-      } //else if
-
-     else if (t1 == RED_BULLET && t0 == RED_SHIP) { // red bullet hits red player
-          p1->kill(); // destroy bullet
-          m_nScore += 10;
-          m_pAudio->play(ABSORB_SOUND);
-      } //else if
-
-
-//Contact between the hotshot's fireball and the player
-     else if (t0 == FIREBALL && t1 == BLUE_SHIP) { //player hit by bullet
-        p0->kill(); // destroy bullet
-    } //else if
-
-     else if (t1 == FIREBALL && t0 == BLUE_SHIP) { //bullet hits player
-        p1->kill(); // destroy bullet
-        p0->hit(); // player is hit
-    } //else if
-     else if (t0 == FIREBALL && t1 == RED_SHIP) { //player hit by bullet
-        p0->kill(); // destroy bullet
-    } //else if
-
-     else if (t1 == FIREBALL && t0 == RED_SHIP) { //bullet hits player
-        p1->kill(); // destroy bullet
-        p0->hit(); // player is hit
-    } //else if
-
+//Contact between enemy shots and the player is handled by ShotHit
 
 //Contact between the player bullet and hotshot
      else if (t0 == BULLET_SPRITE && t1 == HOTSHOT) { //hotshot hit by bullet
@@ -782,11 +1735,11 @@ void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
 //If the card is hit, it will reveal what type of card it is: queen or jack
      else if (t0 == CARD && t1 == BULLET_SPRITE) {
      p1->kill();
-     p0->m_nSpriteIndex = p0->reveal;
+     p0->m_nSpriteIndex = p0->GetCard()->m_nReveal;
     } //else if
      else if (t1 == CARD && t0 == BULLET_SPRITE) {
      p0->kill();
-     p1->m_nSpriteIndex = p1->reveal;
+     p1->m_nSpriteIndex = p1->GetCard()->m_nReveal;
     } //else if
 
 
@@ -869,6 +1822,16 @@ void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
      p1->kill();
     } //else if
 
+//Player collects a pickup left by a bomb
+     else if (t0 == PICKUP && (t1 == RED_SHIP || t1 == BLUE_SHIP)) {
+     p0->kill();
+     m_nScore += PICKUP_POINTS;
+    } //else if
+     else if (t1 == PICKUP && (t0 == RED_SHIP || t0 == BLUE_SHIP)) {
+     p1->kill();
+     m_nScore += PICKUP_POINTS;
+    } //else if
+
 
 //Contact between the player bullet and lilboy
      else if (t0 == BULLET_SPRITE && t1 == LILBOY) { //lilboy hit by bullet
@@ -911,26 +1874,22 @@ void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
      p0->hit(); // player is hit
     } //else if
 
-    /*
-    // Contact between red line and player
-     else if (t0 == RED_LINE && t1 == BLUE_SHIP) { // blue player hit by bomb
-     p1->hit();
+// Line hazards hit ships of the other color that cross them
+     else if (t0 == RED_LINE && t1 == BLUE_SHIP) { // blue player crosses red line
+     p1->hit(); // player is hit
     } //else if
 
-     else if (t1 == RED_LINE && t0 == BLUE_SHIP) { // bomb hits blue player
+     else if (t1 == RED_LINE && t0 == BLUE_SHIP) { // red line crossed by blue player
      p0->hit(); // player is hit
     } //else if
-    
-     
-    // Contact between blue line and player
-     else if (t0 == BLUE_LINE && t1 == RED_SHIP) { // red player hit by bomb
+
+     else if (t0 == BLUE_LINE && t1 == RED_SHIP) { // red player crosses blue line
      p1->hit(); // player is hit
     } //else if
 
-     else if (t1 == BLUE_LINE && t0 == RED_SHIP) { // bomb hits red player
+     else if (t1 == BLUE_LINE && t0 == RED_SHIP) { // blue line crossed by red player
      p0->hit(); // player is hit
     } //else if
-    */
     
 
   } //if
@@ -942,22 +1901,60 @@ int CObjectManager::GetScore()
     return m_nScore;
 } //GetScoreCount
 
-// increase score by 100 when enemy is killed
-void CObjectManager::EnemyKilledScore()
+// increase score by 100 when enemy is killed, and tell the chain its color
+// and which player killed it
+void CObjectManager::EnemyKilledScore(CObject* p)
 {
     m_nScore += 100;
+
+    switch (p->m_nSpriteIndex) {
+    case RED_LIGHT_ENEMY: case RED_HEAVY_ENEMY:
+        m_cChain.Kill(m_nShooter, 'r');
+        break;
+    case BLUE_LIGHT_ENEMY: case BLUE_HEAVY_ENEMY:
+        m_cChain.Kill(m_nShooter, 'b');
+        break;
+    default: //bosses and force fields are not part of chains
+        break;
+    }
 }
 
-// reset score when gameover
+/// Score this tick's absorbed shots and chain links. One absorb
+/// sound is played however many shots were absorbed.
+
+void CObjectManager::ScoreChain(){
+  const size_t first = m_cChain.GetEvents().size(); //events before this tick
+  m_nScore += m_cChain.Tick();
+
+  const vector<ChainEvent>& events = m_cChain.GetEvents();
+
+  for(size_t i=first; i<events.size(); i++)
+    if(events[i].m_nType == CHAIN_ABSORB){
+      m_pEventQueue->play(ABSORB_SOUND);
+      break;
+    } //if
+} //ScoreChain
+
+/// Reader function for the chain scorer, for the HUD and
+/// for weapons that spend absorbed energy.
+/// \return Reference to the chain scorer.
+
+CChain& CObjectManager::GetChain(){
+  return m_cChain;
+} //GetChain
+
+// reset score, chain and bombs when gameover
 void CObjectManager::ResetScore()
 {
     m_nScore = 0;
+    m_cChain.Reset();
+    m_nBombs[0] = m_nBombs[1] = BOMBS;
 }
 
 CObject* CObjectManager::createHotShot(const Vector2& v) //Create Hotshot Boss
 {
     CObject * h = new HotShot( v );
-    m_stdObjectList.push_back(h);
+    add(h);
     //bossCount++;
     return h;
 }
@@ -967,7 +1964,7 @@ CObject* CObjectManager::createLittleBoy(const Vector2& v) //Create LittleBoy Bo
 {
     CObject * l = new LittleBoy(v);
     currentBoss = l;
-    m_stdObjectList.push_back(l);
+    add(l);
     //bossCount++;
     return l;
 }
@@ -976,7 +1973,7 @@ CObject* CObjectManager::createBlackJack(const Vector2& v) //Create BlackJack Bo
 {
     CObject* bj = new BlackJack(v);
     currentBoss = bj;
-    m_stdObjectList.push_back(bj);
+    add(bj);
     //bossCount++;
     return bj;
 }
@@ -984,7 +1981,7 @@ CObject* CObjectManager::createBlackJack(const Vector2& v) //Create BlackJack Bo
 CObject* CObjectManager::createEnemy(const Vector2& v, char c, int p ) //Create Normal Enemies
 {
     CObject* e = new CEnemyObject( v, c, p );
-    m_stdObjectList.push_back(e);
+    add(e);
 
     // do not count RED_LINE and BLUE_LINE as enemies
     if (e->m_nSpriteIndex != RED_LINE && e->m_nSpriteIndex != BLUE_LINE)
@@ -993,28 +1990,528 @@ CObject* CObjectManager::createEnemy(const Vector2& v, char c, int p ) //Create
     return e;
 }
 
+/// Put an object on the end of the object list. It joins its archetype
+/// at the start of the next tick.
+/// \param obj Pointer to the object.
+
 void CObjectManager::add( CObject* obj ) //Adds a CObject to the CObjectManager
 {
     m_stdObjectList.push_back(obj);
+    m_vSpawned.push_back(obj);
 }
 
-CObject* CObjectManager::PlayerShoots() //The player is shooting their gun
+CObject* CObjectManager::PlayerShoots(CObject* player) //The player is shooting their gun
 {
-    CObject* player_bullet = m_pPlayer->FireGun();
-    m_stdObjectList.push_back(player_bullet);
+    CObject* player_bullet = player->FireGun();
+    player_bullet->m_cPolarity = player->m_nSpriteIndex == RED_SHIP? 'r': 'b'; //color of the ship that fired it
+    player_bullet->m_nPlayer = player == m_pPlayer2? 1: 0; //who fired it
+    add(player_bullet);
     return player_bullet;
 }
 
+/// Find the player closest to a point, for enemies to aim at.
+/// In single player this is always the player. Once one ship in a
+/// co-op game has died, it is always the other one.
+/// \param pos The point.
+/// \return Pointer to the closest player, or nullptr if neither is alive.
+
+CObject* CObjectManager::NearestPlayer(const Vector2& pos){
+  if(m_pPlayer == nullptr)
+    return m_pPlayer2;
+
+  if(m_pPlayer2 == nullptr)
+    return m_pPlayer;
+
+  const float d1 = Vector2::DistanceSquared(m_pPlayer->m_vPos, pos);
+  const float d2 = Vector2::DistanceSquared(m_pPlayer2->m_vPos, pos);
+
+  return d2 < d1? m_pPlayer2: m_pPlayer;
+} //NearestPlayer
+
+/// Attach an object to another, so that it stays at the same offset
+/// from it. Attached objects are put in place after everything has
+/// moved each tick, so they do not have to follow their parent
+/// themselves. Nothing is attached if that would make a loop.
+/// \param child Pointer to the object to attach.
+/// \param parent Pointer to the object to attach it to.
+/// \param offset Child's position relative to the parent.
+/// \return true if it was attached.
+
+bool CObjectManager::Attach(CObject* child, CObject* parent, const Vector2& offset){
+  return m_cAttachments.Attach(child, parent, offset);
+} //Attach
+
+/// Fire a volley of homing lasers from a player's ship, paid for with
+/// energy from absorbed shots. Each laser locks on to a different one
+/// of the nearest enemies that no laser in flight is already locked on
+/// to, as many as the player can pay for and there is room for, and
+/// they leave the ship in a fan before curving round. Only the lasers
+/// actually fired are paid for.
+/// \param player Pointer to the player's ship.
+/// \return Number of lasers fired.
+
+UINT CObjectManager::FireLasers(CObject* player){
+  const UINT who = player == m_pPlayer2? 1: 0; //player number
+  const UINT room = CHomingLasers::MAX_LASERS - m_cLasers.GetSize();
+  const UINT afford = (UINT)(m_cChain.GetEnergy(who)/LASER_COST);
+  const UINT k = min(room, afford);
+  if(k == 0)return 0;
+
+  m_vLockOn.clear(); //nearest enemies not locked on to already
+
+  for(auto const& p: QueryNearest(player->m_vPos, k + m_cLasers.GetSize(), ENEMY_TYPES))
+    if(m_vLockOn.size() < k && !m_cLasers.IsTarget(p))
+      m_vLockOn.push_back(p);
+
+  const UINT n = (UINT)m_vLockOn.size();
+  if(n == 0)return 0;
+
+  const Vector2 view = player->GetViewVector();
+  const float facing = atan2f(view.y, view.x); //fan is centered on this
+
+  for(UINT i=0; i<n; i++){ //one laser per target
+    const float a = facing + LASER_FAN*((float)i - 0.5f*(n - 1));
+    m_cLasers.Fire(player->m_vPos, LASER_LAUNCH*Vector2(cosf(a), sinf(a)), m_vLockOn[i], who);
+  } //for
+
+  m_cChain.Spend(who, LASER_COST*(int)n);
+  m_pEventQueue->play(GUN_SOUND);
+
+  return n;
+} //FireLasers
+
+/// Get the part of the world that is on screen. The camera follows
+/// player 1 but stays away from the edges of the world, or is centered
+/// if the world is smaller than the window, the same as in
+/// CGame::FollowCamera, which does it for the interpolated position.
+/// \param lo [out] Bottom left corner.
+/// \param hi [out] Top right corner.
+
+void CObjectManager::GetView(Vector2& lo, Vector2& hi){
+  const Vector2 half(m_nWinWidth/2.0f, m_nWinHeight/2.0f); //half the window
+  Vector2 c = m_pPlayer? m_pPlayer->m_vPos: m_vWorldSize/2; //camera
+
+  if(m_vWorldSize.x > m_nWinWidth)
+    c.x = min(max(c.x, half.x), m_vWorldSize.x - half.x);
+  else c.x = m_vWorldSize.x/2.0f;
+
+  if(m_vWorldSize.y > m_nWinHeight)
+    c.y = min(max(c.y, half.y), m_vWorldSize.y - half.y);
+  else c.y = m_vWorldSize.y/2.0f;
+
+  lo = c - half;
+  hi = c + half;
+} //GetView
+
+/// Set off a bomb, if the player has any left. Every enemy within
+/// BOMB_RADIUS of the ship takes BOMB_DAMAGE hits, and every enemy shot
+/// on screen is cancelled and turned into a pickup worth points.
+/// Enemies are damaged first, while the spatial index is still good.
+/// \param player Pointer to the player's ship.
+/// \return true if a bomb went off.
+
+bool CObjectManager::Bomb(CObject* player){
+  const UINT who = player == m_pPlayer2? 1: 0; //player number
+  if(m_nBombs[who] <= 0)return false;
+  m_nBombs[who]--;
+  m_nShooter = who; //credit for kills
+
+  for(auto const& p: QueryRadius(player->m_vPos, BOMB_RADIUS, ENEMY_TYPES)) //for each enemy in range
+    for(int i=0; i<BOMB_DAMAGE && !p->m_bDead; i++)
+      p->enemyHit();
+
+  Vector2 lo, hi; //corners of the screen
+  GetView(lo, hi);
+
+  for(auto const& pos: CullRegion(lo, hi, SHOT_TYPES)) //for each shot cancelled
+    add(new CObject(PICKUP, pos));
+
+  m_pEventQueue->play(DEATH_SOUND);
+  return true;
+} //Bomb
+
+/// Turn the rule that player shots cancel enemy shots of the other
+/// color on or off. This changes the simulation, so it should only be
+/// done between games.
+/// \param b true to turn it on.
+
+void CObjectManager::SetShotCancel(bool b){
+  m_bShotCancel = b;
+} //SetShotCancel
+
+/// Set the most enemies that get a turn to decide whether to fire each
+/// tick. While there are no more armed enemies than this, each decides
+/// every tick. This changes the simulation, so it should only be done
+/// between games.
+/// \param n Number of decisions per tick.
+
+void CObjectManager::SetAIBudget(UINT n){
+  m_cAI.SetBudget(n);
+} //SetAIBudget
+
+/// Reader function for the number of bombs a player has left.
+/// \param player Player number, 0 or 1.
+/// \return Number of bombs left.
+
+int CObjectManager::GetBombs(UINT player){
+  return m_nBombs[player];
+} //GetBombs
+
+/// Remove every live object of some types whose center is in a
+/// rectangle, all at once. Doing this with kill() would leave the
+/// objects for CullDeadObjects(), which goes through its special cases
+/// for every one of them. Instead only the archetypes that hold those
+/// types are searched, along with objects that have not joined an
+/// archetype yet, and then the object list and the archetypes are
+/// each compacted in a single pass and the objects deleted together.
+/// This is only for objects that nothing else points at, such as
+/// shots, apart from homing laser targets, which are let go.
+/// \param lo Bottom left corner.
+/// \param hi Top right corner.
+/// \param mask Sprite types wanted, made with TypeBit().
+/// \return Where the objects removed were, archetype by archetype.
+
+const vector<Vector2>& CObjectManager::CullRegion(const Vector2& lo, const Vector2& hi, UINT64 mask){
+  m_vCulled.clear();
+  m_vDoomed.clear();
+
+  bitset<NUM_ARCHETYPES> wanted; //archetypes that hold the types wanted
+
+  for(int t=0; t<NUM_SPRITES; t++)
+    if(mask & TypeBit(t))
+      wanted.set(m_stRules[t].m_nArchetype);
+
+  auto doom = [&](CObject* p){
+    const Vector2& pos = p->m_vPos;
+
+    if(!p->m_bDead && (mask & TypeBit(p->m_nSpriteIndex)) &&
+      pos.x >= lo.x && pos.x <= hi.x && pos.y >= lo.y && pos.y <= hi.y)
+    {
+      m_vCulled.push_back(pos);
+      m_vDoomed.push_back(p);
+      p->kill(); //so that nothing holds on to it
+    } //if
+  }; //doom
+
+  for(UINT a=0; a<NUM_ARCHETYPES; a++)
+    if(wanted[a])
+      for(auto const& p: m_vArchetype[a])
+        doom(p);
+
+  for(auto const& p: m_vSpawned) //not in an archetype yet
+    doom(p);
+
+  if(m_vDoomed.empty())return m_vCulled;
+
+  m_cLasers.DropDead(); //before the objects are deleted
+  m_cAttachments.DropDead();
+  DropTimers();
+  m_bIndexed = false; //the index points at deleted objects
+  Ungroup(m_vDoomed); //sorts them by address
+
+  m_stdObjectList.remove_if([&](CObject* p){
+    return binary_search(m_vDoomed.begin(), m_vDoomed.end(), p);
+  });
+
+  for(auto const& p: m_vDoomed)
+    delete p;
+
+  m_vDoomed.clear();
+  return m_vCulled;
+} //CullRegion
+
+/// Move the homing lasers and hit whatever they reach. A target hit
+/// by more than one laser in the same tick is only hit while it is
+/// still alive.
+
+void CObjectManager::MoveLasers(){
+  const float dt = (float)m_pSimTimer->GetElapsedSeconds();
+
+  for(auto const& h: m_cLasers.Update(dt)) //for each target hit
+    if(!h.m_pTarget->m_bDead){
+      m_nShooter = h.m_nPlayer; //credit for the kill
+      h.m_pTarget->enemyHit();
+      m_pEventQueue->play(CLANG_SOUND);
+    } //if
+} //MoveLasers
+
+/// Bring the spatial index up to date, if it is not already. The index
+/// is every object's position at the time it was built, sorted by y
+/// and then by place in the object list. Like the sweep and prune
+/// proxies, each object remembers where it was in the order last time,
+/// so the survivors go back in that order in one pass and an insertion
+/// sort fixes up what moved. The order only depends on the positions
+/// and the object list, never on what happened in earlier ticks, so
+/// query results come out the same after a rollback. Objects created
+/// after the index was built are not found until it is rebuilt, which
+/// happens at the start of each tick, and again before a boss looks
+/// for bullets to dodge.
+
+void CObjectManager::Index(){
+  if(m_bIndexed)return;
+  m_bIndexed = true;
+
+  const UINT last = (UINT)m_vIndex.size(); //number of entries last time
+  m_vSlots.assign(last, UINT_MAX);
+  m_vListOrder.assign(m_stdObjectList.begin(), m_stdObjectList.end());
+  const UINT n = (UINT)m_vListOrder.size();
+
+  for(UINT i=0; i<n; i++){
+    const UINT r = m_vListOrder[i]->m_nIndexRank;
+    if(r < last)m_vSlots[r] = i;
+  } //for
+
+  m_vIndex.clear();
+
+  for(UINT r=0; r<last; r++)
+    if(m_vSlots[r] != UINT_MAX){
+      CObject* p = m_vListOrder[m_vSlots[r]];
+      m_vIndex.push_back({p->m_vPos, m_vSlots[r], p});
+    } //if
+
+  const size_t old = m_vIndex.size(); //number of survivors
+
+  for(UINT i=0; i<n; i++){
+    CObject* p = m_vListOrder[i];
+    if(p->m_nIndexRank >= last)
+      m_vIndex.push_back({p->m_vPos, i, p});
+  } //for
+
+  auto less = [](const IndexEntry& a, const IndexEntry& b){
+    return a.m_vPos.y < b.m_vPos.y || (a.m_vPos.y == b.m_vPos.y && a.m_nOrder < b.m_nOrder);
+  };
+
+  for(size_t k=1; k<old; k++){ //insertion sort of the survivors
+    const IndexEntry x = m_vIndex[k];
+    size_t m = k;
+
+    for(; m > 0 && less(x, m_vIndex[m - 1]); m--)
+      m_vIndex[m] = m_vIndex[m - 1];
+
+    m_vIndex[m] = x;
+  } //for
+
+  sort(m_vIndex.begin() + old, m_vIndex.end(), less);
+  inplace_merge(m_vIndex.begin(), m_vIndex.begin() + old, m_vIndex.end(), less);
+
+  fill(begin(m_nTypeCount), end(m_nTypeCount), 0);
+
+  for(UINT k=0; k<n; k++){ //remember the order for next time
+    CObject* p = m_vIndex[k].m_pObject;
+    p->m_nIndexRank = k;
+    m_nTypeCount[p->m_nSpriteIndex]++;
+  } //for
+} //Index
+
+/// Find the first index entry at or above a height.
+/// \param y The height.
+/// \return Position in m_vIndex of the first entry with y at least this.
+
+UINT CObjectManager::IndexBelow(float y){
+  auto it = lower_bound(m_vIndex.begin(), m_vIndex.end(), y,
+    [](const IndexEntry& e, float y){return e.m_vPos.y < y;});
+
+  return (UINT)(it - m_vIndex.begin());
+} //IndexBelow
+
+/// Find the live objects of some types within a rectangle.
+/// \param lo Bottom left corner.
+/// \param hi Top right corner.
+/// \param mask Sprite types wanted, made with TypeBit().
+/// \return Scratch buffer of the objects found, sorted by y. It is reused by the next query.
+
+const vector<CObject*>& CObjectManager::QueryAABB(const Vector2& lo, const Vector2& hi, UINT64 mask){
+  Index();
+  m_vQuery.clear();
+
+  for(UINT k=IndexBelow(lo.y); k<m_vIndex.size() && m_vIndex[k].m_vPos.y <= hi.y; k++){
+    const IndexEntry& e = m_vIndex[k];
+
+    if(e.m_vPos.x >= lo.x && e.m_vPos.x <= hi.x && !e.m_pObject->m_bDead &&
+      (mask & TypeBit(e.m_pObject->m_nSpriteIndex)))
+        m_vQuery.push_back(e.m_pObject);
+  } //for
+
+  return m_vQuery;
+} //QueryAABB
+
+/// Find the live objects of some types within a circle.
+/// \param pos Center of the circle.
+/// \param r Radius of the circle.
+/// \param mask Sprite types wanted, made with TypeBit().
+/// \return Scratch buffer of the objects found, sorted by y. It is reused by the next query.
+
+const vector<CObject*>& CObjectManager::QueryRadius(const Vector2& pos, float r, UINT64 mask){
+  Index();
+  m_vQuery.clear();
+
+  for(UINT k=IndexBelow(pos.y - r); k<m_vIndex.size() && m_vIndex[k].m_vPos.y <= pos.y + r; k++){
+    const IndexEntry& e = m_vIndex[k];
+
+    if(Vector2::DistanceSquared(e.m_vPos, pos) <= r*r && !e.m_pObject->m_bDead &&
+      (mask & TypeBit(e.m_pObject->m_nSpriteIndex)))
+        m_vQuery.push_back(e.m_pObject);
+  } //for
+
+  return m_vQuery;
+} //QueryRadius
+
+/// Find the k nearest live objects of some types. The search starts at
+/// the point's height in the index and works outwards up and down at
+/// once, stopping in each direction as soon as the difference in height
+/// alone is too far to beat the k-th best so far. Ties in distance go
+/// to the object lower in the index, so the answer does not depend on
+/// anything but the positions.
+/// \param pos The point.
+/// \param k Largest number of objects wanted.
+/// \param mask Sprite types wanted, made with TypeBit().
+/// \param r Only look this far away.
+/// \return Scratch buffer of the objects found, nearest first. It is reused by the next query.
+
+const vector<CObject*>& CObjectManager::QueryNearest(const Vector2& pos, UINT k, UINT64 mask, float r){
+  Index();
+  m_vQuery.clear();
+  m_vNearest.clear();
+  if(k == 0)return m_vQuery;
+
+  auto worse = [](const pair<float, UINT>& a, const pair<float, UINT>& b){return a < b;}; //max-heap on distance, then index
+
+  const UINT n = (UINT)m_vIndex.size();
+  const UINT start = IndexBelow(pos.y);
+  float bound = r*r; //squared distance to beat
+
+  auto visit = [&](UINT i){
+    const IndexEntry& e = m_vIndex[i];
+    if(e.m_pObject->m_bDead || !(mask & TypeBit(e.m_pObject->m_nSpriteIndex)))return;
+
+    const pair<float, UINT> cand(Vector2::DistanceSquared(e.m_vPos, pos), i);
+    if(cand.first > bound)return;
+
+    if(m_vNearest.size() == k){
+      if(!worse(cand, m_vNearest.front()))return;
+      pop_heap(m_vNearest.begin(), m_vNearest.end(), worse);
+      m_vNearest.pop_back();
+    } //if
+
+    m_vNearest.push_back(cand);
+    push_heap(m_vNearest.begin(), m_vNearest.end(), worse);
+
+    if(m_vNearest.size() == k)
+      bound = min(bound, m_vNearest.front().first);
+  };
+
+  UINT up = start; //next entry above
+  UINT down = start; //one past the next entry below
+
+  for(bool more=true; more;){
+    more = false;
+
+    if(up < n){
+      const float dy = m_vIndex[up].m_vPos.y - pos.y;
+
+      if(dy*dy <= bound){
+        visit(up++);
+        more = true;
+      } //if
+      else up = n; //nothing further up can be close enough
+    } //if
+
+    if(down > 0){
+      const float dy = pos.y - m_vIndex[down - 1].m_vPos.y;
+
+      if(dy*dy <= bound){
+        visit(--down);
+        more = true;
+      } //if
+      else down = 0; //nothing further down can be close enough
+    } //if
+  } //for
+
+  sort_heap(m_vNearest.begin(), m_vNearest.end(), worse); //nearest first
+
+  for(auto const& c: m_vNearest)
+    m_vQuery.push_back(m_vIndex[c.second].m_pObject);
+
+  return m_vQuery;
+} //QueryNearest
+
+/// Find the nearest live object of some types.
+/// \param pos The point.
+/// \param mask Sprite types wanted, made with TypeBit().
+/// \param r Only look this far away.
+/// \return Pointer to the nearest object, or nullptr if there is none.
+
+CObject* CObjectManager::QueryNearest(const Vector2& pos, UINT64 mask, float r){
+  const vector<CObject*>& v = QueryNearest(pos, 1, mask, r);
+  return v.empty()? nullptr: v[0];
+} //QueryNearest
+
+/// Reader function for the number of objects of a sprite type, as of
+/// the last time the spatial index was built.
+/// \param t Sprite type.
+/// \return Number of objects of that type, alive or not.
+
+int CObjectManager::CountType(eSpriteType t){
+  Index();
+  return m_nTypeCount[t];
+} //CountType
 
 int CObjectManager::enemyCountFunc() //Count how many enemies that are alive
 {
-    int count = 0;
-    for (auto i = m_stdObjectList.begin(); i != m_stdObjectList.end(); i++)
-    {
-        if ((*i)->m_nSpriteIndex == RED_LIGHT_ENEMY || (*i)->m_nSpriteIndex == BLUE_LIGHT_ENEMY)
-            count++;
+    return CountType(RED_LIGHT_ENEMY) + CountType(BLUE_LIGHT_ENEMY);
+}
+
+// Black Jack and Little Boy dodge player bullets that come within point
+// blank range, as long as they are not moving up or down. Bullets have
+// moved since the spatial index was built, so it is rebuilt first.
+void CObjectManager::BossDodge()
+{
+    if (!currentBoss || currentBoss->GetBoss()->m_bForceFieldOn)
+        return;
+
+    int chance; //Probabilty if the boss will dodge 
+    if (currentBoss->m_nSpriteIndex == BLACK_JACK) //Black jack has 50 chance of dodging the bullet
+        chance = 50;
+    else if (currentBoss->m_nSpriteIndex == LILBOY) //Littleboy has a 25 chance of dodging the bullet
+        chance = 25;
+    else return; //hotshot does not dodge
+
+    m_bIndexed = false; //bullets have moved this tick
+
+    //Only bullets in point blank range can make the boss dodge
+    const Vector2 reach(100.0f, 250.0f);
+    const Vector2 center = currentBoss->GetPos();
+
+    for (CObject* p: QueryAABB(center - reach, center + reach, TypeBit(BULLET_SPRITE))) {
+        bool dodge = m_pGameRandom->rand() % 100 < chance; //Does the boss dodge it?
+
+        //If the boss is not moving up or down, and the dodge probabilty is a success
+        //Then boss will dodge the bullet
+        if ((!currentBoss->m_bStrafeBack && !currentBoss->GetBoss()->m_bStrafeForward) && dodge) {
+            const Vector2 boss = currentBoss->GetPos();
+            const Vector2 bullet = p->GetPos();
+            if (AtWorldEdge(currentBoss)) { //Make sure boss does not leave the screen
+                float width, hieght;
+                m_pRenderer->GetSize(currentBoss->m_nSpriteIndex, width, hieght);
+                if (boss.x - width / 2 < 0 && !currentBoss->m_bStrafeLeft)
+                    currentBoss->StrafeRight();
+                else if (boss.x + width / 2 > m_vWorldSize.x && !currentBoss->m_bStrafeRight)
+                    currentBoss->StrafeLeft();
+            }
+            else {
+                if (bullet.x < boss.x && !currentBoss->m_bStrafeLeft)
+                    currentBoss->StrafeRight();
+                else if (bullet.x > boss.x && !currentBoss->m_bStrafeRight)
+                    currentBoss->StrafeLeft();
+                else {
+                    if (boss.x <= m_vWinCenter.x && !currentBoss->m_bStrafeLeft)
+                        currentBoss->StrafeRight();
+                    else
+                        currentBoss->StrafeLeft();
+                }
+            }
+        }
     }
-    return count;
 }
 
 void CObjectManager::SpawnBoss() //Spawns boss according to the level
@@ -1119,4 +2616,534 @@ void CObjectManager::setBossPresent(bool b)
 void CObjectManager::SetScore(int x) 
 {
     m_nScore = x;
-}
\ No newline at end of file
+}
+
+/// Get the memory held by the pools of optional object state.
+/// \param store The pools.
+/// \return Size in bytes.
+
+static size_t PoolBytes(const CExtraStore& store){
+  return store.m_cShips.GetBytes() + store.m_cBosses.GetBytes() +
+    store.m_cCards.GetBytes() + store.m_cExplosions.GetBytes();
+} //PoolBytes
+
+/// Build a thousand objects of one kind and print how much memory they
+/// take, counting what they draw from the pools of optional state.
+/// They are not put on the object list, and are deleted afterwards.
+/// \param store The pools.
+/// \param name Name of the kind of object.
+/// \param size Size of one object.
+/// \param make Function that builds one object.
+
+static void ReportKind(const CExtraStore& store, const char* name, size_t size, CObject* (*make)()){
+  const UINT count = 1000;
+  vector<CObject*> objects;
+  const size_t before = PoolBytes(store);
+
+  for(UINT i=0; i<count; i++)
+    objects.push_back(make());
+
+  const size_t bytes = count*size + PoolBytes(store) - before;
+  DEBUGPRINTF("%u %s: %u bytes, %.2f cache lines each\n", count, name, (UINT)bytes, bytes/(64.0f*count));
+
+  for(auto const& p: objects)
+    delete p;
+} //ReportKind
+
+/// Print the size of each class of object and of each kind of optional
+/// state, and the memory taken by a thousand objects of a few kinds.
+/// Building cards draws from the random number generator, so its state
+/// is put back afterwards.
+
+void CObjectManager::ReportMemory(){
+  DEBUGPRINTF("sizeof CObject %u, CEnemyObject %u, HotShot %u, LittleBoy %u, BlackJack %u\n",
+    (UINT)sizeof(CObject), (UINT)sizeof(CEnemyObject), (UINT)sizeof(HotShot),
+    (UINT)sizeof(LittleBoy), (UINT)sizeof(BlackJack));
+
+  DEBUGPRINTF("sizeof ShipState %u, BossState %u, CardState %u, ExplosionState %u\n",
+    (UINT)sizeof(ShipState), (UINT)sizeof(BossState), (UINT)sizeof(CardState), (UINT)sizeof(ExplosionState));
+
+  const UINT64 rng = m_pGameRandom->GetState();
+
+  ReportKind(*m_pExtraStore, "bullets", sizeof(CObject), [](){return new CObject(RED_BULLET, Vector2::Zero);});
+  ReportKind(*m_pExtraStore, "explosions", sizeof(CObject), [](){return new CObject(SMALL_EXPLOSION, Vector2::Zero);});
+  ReportKind(*m_pExtraStore, "cards", sizeof(CObject), [](){return new CObject(CARD, Vector2::Zero);});
+  ReportKind(*m_pExtraStore, "light enemies", sizeof(CEnemyObject), [](){return (CObject*)new CEnemyObject(Vector2::Zero, 'r', 0);});
+  ReportKind(*m_pExtraStore, "bosses", sizeof(BlackJack), [](){return (CObject*)new BlackJack(Vector2::Zero);});
+
+  m_pGameRandom->SetState(rng);
+} //ReportMemory
+
+/// Reader function for the tick counter.
+/// \return Number of simulation ticks so far.
+
+UINT CObjectManager::GetTick(){
+  return m_nTick;
+} //GetTick
+
+/// Start counting simulation ticks from zero, for a game that must
+/// start from exactly the same state as another. The timers are set
+/// from the tick counter, so this must be followed by clear().
+
+void CObjectManager::ResetTick(){
+  m_nTick = 0;
+} //ResetTick
+
+/// Hash the whole simulation state: the manager's counters, the
+/// random number generator, and every object in list order. The
+/// object list order is itself part of the state since it decides
+/// the order of updates and collision responses.
+/// \return The state hash.
+
+UINT64 CObjectManager::HashState(){
+  CStateHash hash;
+
+  hash.Add(m_nTick);
+  hash.Add(m_pSimTimer->GetTotalSeconds());
+  hash.Add(m_nScore);
+  hash.Add(level);
+  hash.Add(boss_present);
+  hash.Add(boss_active);
+  hash.Add(enemyCount);
+  hash.Add(bossCount);
+  hash.Add(levelCleared);
+  hash.Add(playerHealth);
+  hash.Add(m_nBombs[0]);
+  hash.Add(m_nBombs[1]);
+  hash.Add(m_bShotCancel);
+  m_cChain.Hash(hash);
+  m_cLasers.Hash(hash);
+  NumberObjects();
+
+  for(UINT i=0; i<m_cLasers.GetSize(); i++) //laser targets by list index
+    hash.Add(IndexOf(m_cLasers.GetTarget(i)));
+
+  m_cAttachments.Hash(hash);
+
+  for(UINT i=0; i<m_cAttachments.GetSize(); i++){ //attached objects by list index
+    hash.Add(IndexOf(m_cAttachments.GetChild(i)));
+    hash.Add(IndexOf(m_cAttachments.GetParent(i)));
+  } //for
+
+  m_cTimers.Hash(hash);
+  m_cTimers.GetObjects(m_vTimed);
+
+  for(auto const& p: m_vTimed) //timer objects by list index
+    hash.Add(IndexOf(p));
+
+  hash.Add(m_cAI.GetBudget());
+  hash.Add(m_cAI.GetSize());
+
+  for(UINT i=0; i<m_cAI.GetSize(); i++) //waiting enemies by list index
+    hash.Add(IndexOf(m_cAI.Get(i)));
+
+  hash.Add(m_pGameRandom->GetState());
+  hash.Add((UINT)m_stdObjectList.size());
+
+  for(auto const& p: m_stdObjectList) //for each object
+    p->Hash(hash);
+
+  return hash.Get();
+} //HashState
+
+/// Hash each object on its own, for finding which object
+/// diverged once HashState() reports a difference.
+/// \param hashes [out] One hash per object, in list order.
+/// \param types [out] Sprite type of each object, in list order.
+
+void CObjectManager::GetObjectHashes(vector<UINT64>& hashes, vector<int>& types){
+  hashes.clear();
+  types.clear();
+
+  for(auto const& p: m_stdObjectList){ //for each object
+    CStateHash hash;
+    p->Hash(hash);
+    hashes.push_back(hash.Get());
+    types.push_back(p->m_nSpriteIndex);
+  } //for
+} //GetObjectHashes
+
+/// Map each object to its index in the object list, in one pass over
+/// the list, so that IndexOf() takes constant time. Saving and hashing
+/// look up an index for every timer, waiting enemy, laser target and
+/// attachment, which would be quadratic with a search of the list.
+/// The map is only good until the list next changes.
+
+void CObjectManager::NumberObjects(){
+  m_mapIndex.clear();
+  int i = 0;
+
+  for(auto const& p: m_stdObjectList) //for each object
+    m_mapIndex[p] = i++;
+} //NumberObjects
+
+/// Find the index of an object in the object list, using the map made
+/// by the last call to NumberObjects().
+/// \param p Pointer to an object, or nullptr.
+/// \return Index in the object list, or -1 if p is null or not listed.
+
+int CObjectManager::IndexOf(CObject* p){
+  if(p == nullptr)return -1;
+
+  auto it = m_mapIndex.find(p);
+  return it == m_mapIndex.end()? -1: it->second;
+} //IndexOf
+
+/// Construct an object of the right class for a sprite type, for
+/// restoring a snapshot. Its state is overwritten by CObject::Load,
+/// so the constructor arguments do not matter.
+/// \param t Sprite type.
+/// \return Pointer to the new object.
+
+CObject* CObjectManager::Rebuild(eSpriteType t){
+  switch(t){
+    case HOTSHOT: return new HotShot(Vector2::Zero);
+    case LILBOY: return new LittleBoy(Vector2::Zero);
+    case BLACK_JACK: return new BlackJack(Vector2::Zero);
+
+    case RED_LIGHT_ENEMY: case BLUE_LIGHT_ENEMY:
+    case RED_HEAVY_ENEMY: case BLUE_HEAVY_ENEMY:
+    case RED_LINE: case BLUE_LINE:
+      return new CEnemyObject(Vector2::Zero, 'r', 0);
+
+    default: return new CObject(t, Vector2::Zero);
+  } //switch
+} //Rebuild
+
+/// Save the whole simulation state to a snapshot: the manager's
+/// counters, the simulation clock, the world size, the random number
+/// generator and every object in list order. Pointers between objects
+/// are saved as list indices.
+/// \param s [out] The snapshot.
+
+void CObjectManager::Snapshot(CSnapshot& s){
+  s.Clear();
+
+  s.Write(SNAPSHOT_TAG);
+  s.Write(m_nTick);
+  s.Write(m_pSimTimer->GetTotalSeconds());
+  s.Write(m_nScore);
+  s.Write(level);
+  s.Write(boss_present);
+  s.Write(previousTime);
+  s.Write(boss_active);
+  s.Write(enemyCount);
+  s.Write(bossCount);
+  s.Write(levelCleared);
+  s.Write(playerHealth);
+  s.Write(m_nBombs[0]);
+  s.Write(m_nBombs[1]);
+  s.Write(m_bShotCancel);
+  m_cChain.Save(s);
+  s.Write(m_vWorldSize);
+  s.Write(m_pGameRandom->GetState());
+  NumberObjects();
+
+  s.Write((UINT)m_stdObjectList.size());
+  s.Write(IndexOf(m_pPlayer));
+  s.Write(IndexOf(m_pPlayer2));
+  s.Write(IndexOf(currentBoss));
+
+  for(auto const& p: m_stdObjectList){ //for each object
+    const BossState* boss = p->GetBoss();
+    s.Write(p->m_nSpriteIndex);
+    p->Save(s);
+    s.Write(IndexOf(boss? boss->m_pForceField: nullptr));
+    s.Write(IndexOf(boss? boss->m_pBlackHole: nullptr));
+  } //for
+
+  m_cLasers.Save(s);
+
+  for(UINT i=0; i<m_cLasers.GetSize(); i++) //laser targets by list index
+    s.Write(IndexOf(m_cLasers.GetTarget(i)));
+
+  m_cAttachments.Save(s);
+
+  for(UINT i=0; i<m_cAttachments.GetSize(); i++){ //attached objects by list index
+    s.Write(IndexOf(m_cAttachments.GetChild(i)));
+    s.Write(IndexOf(m_cAttachments.GetParent(i)));
+  } //for
+
+  m_cTimers.Save(s);
+  m_cTimers.GetObjects(m_vTimed);
+
+  for(auto const& p: m_vTimed) //timer objects by list index
+    s.Write(IndexOf(p));
+
+  s.Write(m_cAI.GetBudget());
+  s.Write(m_cAI.GetSize());
+
+  for(UINT i=0; i<m_cAI.GetSize(); i++) //waiting enemies by list index
+    s.Write(IndexOf(m_cAI.Get(i)));
+} //Snapshot
+
+/// Replace the whole simulation state with one saved by Snapshot()
+/// during this run, such as a rollback frame or a checkpoint, which is
+/// good by construction. This is called every rollback, so nothing is
+/// checked beyond what LoadState() does as it goes.
+/// \param s The snapshot.
+/// \return true if the snapshot was restored, false if it was empty.
+
+bool CObjectManager::Restore(CSnapshot& s){
+  return LoadState(s);
+} //Restore
+
+/// Replace the whole simulation state with a snapshot that may have
+/// come from a file, so a bad one must not be able to break anything.
+/// The snapshot is checked all the way through before the current
+/// state is cleared, so that a failed restore changes nothing.
+/// \param s The snapshot.
+/// \return true if the snapshot was restored, false if it was not valid.
+
+bool CObjectManager::RestoreChecked(CSnapshot& s){
+  return CheckState(s) && LoadState(s);
+} //RestoreChecked
+
+/// Read a snapshot the way LoadState() does and check everything that
+/// LoadState() checks, but into scratch space, so that nothing in the
+/// simulation is changed. Objects are rebuilt to check their state and
+/// deleted again, and since rebuilding a card draws from the random
+/// number generator, its state is put back afterwards.
+/// \param s The snapshot.
+/// \return true if LoadState() would restore the whole snapshot.
+
+bool CObjectManager::CheckState(CSnapshot& s){
+  s.Rewind();
+
+  UINT tag = 0;
+  s.Read(tag);
+  if(tag != SNAPSHOT_TAG)return false;
+
+  auto skip = [&s](auto x){s.Read(x);}; //read into a copy of x
+
+  skip(m_nTick);
+  skip(m_pSimTimer->GetTotalSeconds());
+  skip(m_nScore);
+  skip(level);
+  skip(boss_present);
+  skip(previousTime);
+  skip(boss_active);
+  skip(enemyCount);
+  skip(bossCount);
+  skip(levelCleared);
+  skip(playerHealth);
+  skip(m_nBombs[0]);
+  skip(m_nBombs[1]);
+  skip(m_bShotCancel);
+
+  CChain chain;
+  if(!chain.Load(s))return false;
+  skip(m_vWorldSize);
+  skip(m_pGameRandom->GetState());
+
+  UINT n = 0;
+  int player = -1, player2 = -1, boss = -1;
+
+  s.Read(n);
+  s.Read(player);
+  s.Read(player2);
+  s.Read(boss);
+
+  if(n > MAX_OBJECTS || n > s.GetRemaining())return false; //each object takes some bytes
+  auto valid = [n](int i){return i >= -1 && i < (int)n;}; //list index or -1 for none
+  if(!valid(player) || !valid(player2) || !valid(boss))return false;
+
+  const UINT64 rng = m_pGameRandom->GetState();
+  bool good = true;
+
+  for(UINT i=0; i<n && good; i++){ //rebuild and discard each object
+    int t = 0, ff = -1, bh = -1;
+    s.Read(t);
+    if(t < 0 || t >= NUM_SPRITES){good = false; break;}
+
+    CObject* p = Rebuild((eSpriteType)t);
+    good = p->Load(s);
+    delete p;
+
+    s.Read(ff);
+    s.Read(bh);
+    good = good && valid(ff) && valid(bh);
+  } //for
+
+  m_pGameRandom->SetState(rng);
+  if(!good)return false;
+
+  CHomingLasers lasers;
+  if(!lasers.Load(s))return false;
+
+  for(UINT i=0; i<lasers.GetSize(); i++){ //targets out of range become nullptr
+    int target = -1;
+    s.Read(target);
+  } //for
+
+  CAttachments links;
+  if(!links.Load(s))return false;
+
+  for(UINT i=0; i<links.GetSize(); i++){
+    int child = -1, parent = -1;
+    s.Read(child);
+    s.Read(parent);
+    if(child < 0 || child >= (int)n || parent < 0 || parent >= (int)n)return false;
+  } //for
+
+  CTimerWheel timers;
+  if(!timers.Load(s))return false;
+
+  for(UINT i=0; i<timers.GetSize(); i++){
+    int j = -1;
+    s.Read(j);
+    if(j < 0 || j >= (int)n)return false;
+  } //for
+
+  UINT budget = 0, waiting = 0;
+  s.Read(budget);
+  s.Read(waiting);
+  if(waiting > n)return false; //an enemy only waits once
+
+  for(UINT i=0; i<waiting; i++){
+    int j = -1;
+    s.Read(j);
+    if(j < 0 || j >= (int)n)return false;
+  } //for
+
+  return true;
+} //CheckState
+
+/// Replace the whole simulation state with a snapshot's.
+/// Every object is rebuilt and the simulation clock is put back to the
+/// time of the snapshot, so the objects' timers carry on from where
+/// they were. The random number generator is restored last because
+/// rebuilding a card draws from it. Nothing read is trusted: the number
+/// of objects is capped, sprite types are checked, and every list index
+/// must be -1 for none or the index of an object in the snapshot.
+/// These checks keep a bad snapshot from breaking anything, but one
+/// that fails after clear() leaves the state half restored, so a
+/// snapshot from a file must pass CheckState() first.
+/// \param s The snapshot.
+/// \return false if the snapshot was not valid.
+
+bool CObjectManager::LoadState(CSnapshot& s){
+  s.Rewind();
+
+  UINT tag = 0;
+  s.Read(tag);
+  if(tag != SNAPSHOT_TAG)return false;
+
+  double t = 0.0;
+  UINT64 rng = 0;
+  UINT n = 0;
+  int player = -1, player2 = -1, boss = -1;
+
+  s.Read(m_nTick);
+  s.Read(t);
+  s.Read(m_nScore);
+  s.Read(level);
+  s.Read(boss_present);
+  s.Read(previousTime);
+  s.Read(boss_active);
+  s.Read(enemyCount);
+  s.Read(bossCount);
+  s.Read(levelCleared);
+  s.Read(playerHealth);
+  s.Read(m_nBombs[0]);
+  s.Read(m_nBombs[1]);
+  s.Read(m_bShotCancel);
+  if(!m_cChain.Load(s))return false;
+  s.Read(m_vWorldSize);
+  s.Read(rng);
+
+  s.Read(n);
+  s.Read(player);
+  s.Read(player2);
+  s.Read(boss);
+
+  if(n > MAX_OBJECTS || n > s.GetRemaining())return false; //each object takes some bytes
+  auto valid = [n](int i){return i >= -1 && i < (int)n;}; //list index or -1 for none
+  if(!valid(player) || !valid(player2) || !valid(boss))return false;
+
+  clear(); //delete current objects
+
+  m_pSimTimer->SetTotalSeconds(t);
+  m_vLinks.resize(2*n);
+  m_vRestored.clear();
+
+  for(UINT i=0; i<n; i++){ //rebuild objects in list order
+    int t = 0;
+    s.Read(t);
+    if(t < 0 || t >= NUM_SPRITES)return false;
+
+    CObject* p = Rebuild((eSpriteType)t);
+
+    if(!p->Load(s)){ //state does not fit the sprite type
+      delete p;
+      return false;
+    } //if
+    s.Read(m_vLinks[2*i]);
+    s.Read(m_vLinks[2*i + 1]);
+
+    add(p);
+    m_vRestored.push_back(p);
+    if(!valid(m_vLinks[2*i]) || !valid(m_vLinks[2*i + 1]))return false;
+  } //for
+
+  for(UINT i=0; i<n; i++){ //reconnect pointers between objects
+    BossState* boss = m_vRestored[i]->GetBoss();
+    if(boss == nullptr)continue;
+
+    const int ff = m_vLinks[2*i], bh = m_vLinks[2*i + 1];
+    boss->m_pForceField = ff >= 0? m_vRestored[ff]: nullptr;
+    boss->m_pBlackHole = bh >= 0? m_vRestored[bh]: nullptr;
+  } //for
+
+  m_pPlayer = player >= 0? m_vRestored[player]: nullptr;
+  m_pPlayer2 = player2 >= 0? m_vRestored[player2]: nullptr;
+  currentBoss = boss >= 0? m_vRestored[boss]: nullptr;
+
+  if(!m_cLasers.Load(s))return false;
+
+  for(UINT i=0; i<m_cLasers.GetSize(); i++){ //reconnect laser targets
+    int target = -1;
+    s.Read(target);
+    m_cLasers.SetTarget(i, target >= 0 && target < (int)n? m_vRestored[target]: nullptr);
+  } //for
+
+  if(!m_cAttachments.Load(s))return false;
+
+  for(UINT i=0; i<m_cAttachments.GetSize(); i++){ //reconnect attached objects
+    int child = -1, parent = -1;
+    s.Read(child);
+    s.Read(parent);
+    if(child < 0 || child >= (int)n || parent < 0 || parent >= (int)n)return false;
+    m_cAttachments.SetObjects(i, m_vRestored[child], m_vRestored[parent]);
+  } //for
+
+  if(!m_cTimers.Load(s))return false;
+  m_vTimed.resize(m_cTimers.GetSize());
+
+  for(auto& p: m_vTimed){ //reconnect timer objects
+    int i = -1;
+    s.Read(i);
+    if(i < 0 || i >= (int)n)return false;
+    p = m_vRestored[i];
+  } //for
+
+  m_cTimers.SetObjects(m_vTimed);
+  m_bTimedDeath = true; //in case any of them were killed before the snapshot
+
+  UINT budget = 0, waiting = 0;
+  s.Read(budget);
+  s.Read(waiting);
+  if(waiting > n)return false; //an enemy only waits once
+  m_cAI.SetBudget(budget);
+
+  for(UINT i=0; i<waiting; i++){ //reconnect waiting enemies
+    int j = -1;
+    s.Read(j);
+    if(j < 0 || j >= (int)n)return false;
+    m_cAI.Add(m_vRestored[j]);
+  } //for
+
+  m_pGameRandom->SetState(rng);
+
+  return true;
+} //LoadState
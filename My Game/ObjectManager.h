@@ -4,8 +4,24 @@
 #pragma once
 
 #include <list>
+#include <vector>
+#include <cfloat>
+#include <functional>
+#include <unordered_map>
 
 #include "Object.h"
+#include "RenderSnapshot.h"
+#include "ShotPack.h"
+#include "ShotGrid.h"
+#include "Hitbox.h"
+#include "MaskSet.h"
+#include "Chain.h"
+#include "HomingLasers.h"
+#include "Attachments.h"
+#include "TimerWheel.h"
+#include "AIScheduler.h"
+#include "BulletArray.h"
+#include "SweepPrune.h"
 
 #include "Component.h"
 #include "Common.h"
@@ -17,6 +33,26 @@
 #include "Enemy.h"
 using namespace std;
 
+//#define USE_MEMORY_REPORT ///< Define this to print object sizes and memory use at startup.
+
+/// \brief Archetypes, the groups of sprite types that are moved
+/// together by one system loop in CObjectManager::move.
+
+enum eArchetype{
+  BACKGROUND_ARCHETYPE, PLAYER_ARCHETYPE, LIGHT_ENEMY_ARCHETYPE, HEAVY_ENEMY_ARCHETYPE,
+  BOSS_ARCHETYPE, BULLET_ARCHETYPE, HAZARD_ARCHETYPE, EFFECT_ARCHETYPE,
+  NUM_ARCHETYPES //MUST BE LAST
+}; //eArchetype
+
+/// \brief Something that a system running in parallel leaves for the
+/// main thread to do once it has finished.
+
+enum eCommandType{
+  KILL_COMMAND, ///< Kill an object.
+  RESPAWN_COMMAND, ///< Put an object that has wandered off back on screen.
+  SPAWN_COMMAND ///< Create an object.
+}; //eCommandType
+
 /// \brief The object manager.
 ///
 /// A collection of all of the game objects.
@@ -27,14 +63,102 @@ class CObjectManager:
   public CSettings{
 
   private:
+    /// \brief A contact found by the broad phase.
+
+    struct Contact{
+      UINT m_nFirst; ///< Index of the first object in the broad phase array.
+      UINT m_nSecond; ///< Index of the second object in the broad phase array.
+      float m_fTime; ///< Fraction of the tick at which they first touch.
+      UINT m_nPart = 0; ///< Part of a compound hitbox that was hit, counting from 1, or 0 for none.
+    }; //Contact
+
+    /// \brief A command left by a system running in parallel.
+
+    struct Command{
+      eCommandType m_nType; ///< What to do.
+      CObject* m_pObject = nullptr; ///< Object to kill or put back on screen.
+      eSpriteType m_nSprite = NUM_SPRITES; ///< Sprite type of the object to create.
+      Vector2 m_vPos = Vector2::Zero; ///< Where to create it.
+    }; //Command
+
+    /// \brief The y-interval swept by a line hazard in one tick.
+
+    struct Band{
+      float m_fLo; ///< Bottom of the interval.
+      float m_fHi; ///< Top of the interval.
+      UINT m_nIndex; ///< Index of the line in the broad phase array.
+    }; //Band
+
+    /// \brief An object in the spatial index.
+
+    struct IndexEntry{
+      Vector2 m_vPos; ///< Position when the index was built.
+      UINT m_nOrder; ///< Place in the object list, to break ties.
+      CObject* m_pObject; ///< The object.
+    }; //IndexEntry
+
+    /// \brief What the systems need to know about a sprite type.
+
+    struct TypeRules{
+      eArchetype m_nArchetype = EFFECT_ARCHETYPE; ///< Archetype.
+      eEdgeRule m_nEdge = NO_EDGE; ///< What happens at the edge of the world.
+      float m_fLife = 0.0f; ///< Seconds until it dies, or 0 to live forever.
+      float m_fCooldown = 0.0f; ///< Seconds between shots, or 0 if it does not shoot by itself.
+      bool m_bTimed = false; ///< Has timers set when it first turns up.
+    }; //TypeRules
+
     list<CObject*> m_stdObjectList; ///< Object list.
 
     void BroadPhase(); ///< Broad phase collision detection and response.
+    void SortProxies(UINT n); ///< Update and sort the sweep and prune proxies.
+    SweepProxy MakeProxy(UINT i); ///< Swept y-interval of an object.
+    bool Sweep(CObject* p0, CObject* p1, float& t); ///< Swept circle test.
+    bool Refine(CObject* p0, CObject* p1, float& t, UINT& part); ///< Compound hitbox test.
+    void PartHit(CObject* p0, CObject* p1, UINT part); ///< Response to a shot hitting part of a hitbox.
+    bool PixelHit(CObject* p0, CObject* p1, float& t); ///< Pixel mask test.
+    void QueryShots(UINT n, UINT b); ///< Find contacts between ships and enemy shots.
+    void QueryBands(UINT n, UINT b); ///< Find contacts between ships and line hazards.
+    void ShotHit(CObject* ship, CObject* shot); ///< Response to an enemy shot hitting a ship.
+    void QueryCancels(UINT n, UINT b); ///< Find contacts between player shots and enemy shots.
+    void ShotCancel(CObject* bullet, CObject* shot); ///< Response to a player shot meeting an enemy shot.
+    void SweptBox(CObject* p, Vector2& lo, Vector2& hi); ///< Box around the circle swept by an object.
+    void ScoreChain(); ///< Score absorbed shots and chains.
+    void MoveLasers(); ///< Move homing lasers and hit their targets.
+    const vector<Vector2>& CullRegion(const Vector2& lo, const Vector2& hi, UINT64 mask); ///< Remove objects in a rectangle.
+    void GetView(Vector2& lo, Vector2& hi); ///< Part of the world on screen.
+    void BossDodge(); ///< Boss dodges player bullets.
+
+    void Index(); ///< Bring the spatial index up to date.
+    UINT IndexBelow(float y); ///< First index entry at or above a height.
     void NarrowPhase(CObject* p0, CObject* p1); ///< Narrow phase collision detection and response.
     bool AtWorldEdge(CObject* p); ///< Test whether at the edge of the world.
+
+    void Group(); ///< Put new objects into their archetypes.
+    void Ungroup(vector<CObject*>& doomed); ///< Take objects out of their archetypes.
+    bool Expired(CObject* p); ///< Test whether an object has reached the edge.
+    void RunSystem(eArchetype a, const function<void(UINT, UINT, vector<Command>&)>& body); ///< Run a system in parallel.
+    void MoveBackgrounds(); ///< Background system.
+    void MovePlayers(); ///< Player system.
+    void MoveEnemies(eArchetype a); ///< Light and heavy enemy system.
+    void ThinkEnemies(); ///< Armed enemies take turns deciding whether to fire.
+    void MoveBosses(); ///< Boss system.
+    void MoveBullets(); ///< Bullet system.
+    void MoveHazards(); ///< Hazard system.
+    void MoveEffects(); ///< Effect system.
+    void HotShotAttacks(CObject* p, CObject* target); ///< HotShot's attacks.
+    void LittleBoyAttacks(CObject* p, CObject* target); ///< LittleBoy's attacks.
+    void BlackJackAttacks(CObject* p, CObject* target); ///< BlackJack's attacks.
+
+    void Schedule(CObject* p, eTimerEvent e, float seconds); ///< Set a timer.
+    void StartTimers(CObject* p); ///< Set the timers of a new object.
+    void OnTimer(const CTimerWheel::Timer& t); ///< Timer went off.
+    void Reload(CObject* p); ///< Start a gun cooling down.
+    void CloseBlackHole(); ///< Let the boss open another black hole later.
+    void DropTimers(); ///< Drop the timers of dead objects.
     void CullDeadObjects(); ///< Cull dead objects.
 
     int m_nScore = 0; //keeps track of current score
+    UINT m_nShooter = 0; ///< Player whose shot or weapon is being resolved, who gets the credit for kills.
     int level = 0; //keeps track of what level is taking place
     bool boss_present = false;
     float previousTime = 0;
@@ -46,6 +170,58 @@ class CObjectManager:
     bool levelCleared = false;  // level is completed or not
 
     int playerHealth = 3;   // player health
+    int m_nBombs[2] = {0, 0}; ///< Bombs left for each player, refilled by ResetScore.
+    bool m_bShotCancel = false; ///< Whether player shots cancel enemy shots of the other color.
+
+    UINT m_nTick = 0; ///< Number of simulation ticks so far.
+    vector<CObject*> m_vRestored; ///< Objects in list order while restoring a snapshot.
+    vector<int> m_vLinks; ///< Saved pointer indices while restoring a snapshot.
+    unordered_map<CObject*, int> m_mapIndex; ///< List index of each object while saving or hashing.
+    vector<CObject*> m_vObjects; ///< Objects in list order for the broad phase.
+    CSweepPrune m_cSweep; ///< Circles sorted by the bottom of their y-interval.
+    vector<SweepProxy> m_vProxies; ///< Circles' y-intervals in broad phase order, for sorting.
+    vector<UINT> m_vRanks; ///< Circles' places in the sorted order, for sorting.
+    vector<UINT> m_vSlots; ///< Survivors by their old position while re-indexing.
+
+    vector<IndexEntry> m_vIndex; ///< Spatial index, sorted by y.
+    bool m_bIndexed = false; ///< Whether the spatial index is up to date.
+    vector<CObject*> m_vListOrder; ///< Objects in list order while building the index.
+    vector<CObject*> m_vQuery; ///< Scratch buffer for query results.
+    vector<pair<float, UINT>> m_vNearest; ///< Scratch heap for nearest queries.
+    vector<CObject*> m_vDoomed; ///< Objects removed by CullRegion, waiting to be deleted.
+    vector<Vector2> m_vCulled; ///< Where the objects removed by CullRegion were.
+    int m_nTypeCount[NUM_SPRITES] = {0}; ///< Number of objects of each type in the index.
+    vector<vector<Contact>> m_vPairs; ///< Contacts found by each broad phase chunk.
+    vector<Contact> m_vContacts; ///< All contacts this tick, in time of impact order.
+    vector<vector<Command>> m_vCommands; ///< Commands left by each chunk of a parallel system.
+    CShotPack m_cShots; ///< Enemy shots packed for testing against ships.
+    CShotGrid m_cShotGrid; ///< Enemy shots binned for testing against player shots.
+    vector<UINT> m_vNearShots; ///< Scratch buffer for shot grid queries.
+    CChain m_cChain; ///< Absorption and chain scorer.
+    CHomingLasers m_cLasers; ///< Homing lasers in flight.
+    CAttachments m_cAttachments; ///< Objects attached to other objects.
+    CTimerWheel m_cTimers; ///< Cooldowns and lifetimes.
+    bool m_bTimedDeath = false; ///< Whether an object with timers has died since they were last dropped.
+    vector<CObject*> m_vTimed; ///< Objects of the timers while saving or restoring.
+
+    CAIScheduler m_cAI; ///< Armed enemies waiting for a turn to decide whether to fire.
+    vector<CObject*> m_vTurns; ///< Enemies whose turn it is this tick.
+    vector<CObject*> m_vLockOn; ///< Enemies picked for a volley of homing lasers.
+    vector<Band> m_vBands; ///< Line hazards sorted by the bottom of their interval.
+    vector<CHitbox> m_vHitboxes; ///< Compound hitbox for each sprite type, most of them empty.
+    CMaskSet m_cMasks; ///< Pixel collision masks.
+    TypeRules m_stRules[NUM_SPRITES]; ///< Rules for each sprite type.
+    vector<CObject*> m_vArchetype[NUM_ARCHETYPES]; ///< Objects of each archetype, in list order, kept from tick to tick.
+    vector<CObject*> m_vSpawned; ///< Objects added since the last tick, not yet in an archetype.
+    vector<CObject*> m_vDying; ///< Dead objects taken off the list, waiting to be deleted.
+    vector<UINT> m_vGone; ///< Indices of objects leaving an archetype.
+    CBulletArray m_cBullets; ///< Positions and velocities of the bullet archetype.
+
+    void NumberObjects(); ///< Map each object to its index in the object list.
+    int IndexOf(CObject* p); ///< Index of an object in the object list.
+    CObject* Rebuild(eSpriteType t); ///< Construct an empty object of the right class for a sprite type.
+    bool LoadState(CSnapshot& s); ///< Replace the simulation state with a snapshot's.
+    bool CheckState(CSnapshot& s); ///< Check a snapshot without changing anything.
 
   public:
     CObjectManager(); ///< Constructor.
@@ -59,15 +235,30 @@ class CObjectManager:
 
     void clear(); ///< Reset to initial conditions.
     void move(); ///< Move all objects.
-    void draw(); ///< Draw all objects.
+    void Publish(CRenderSnapshot& s); ///< Copy what the renderer needs.
     void add( CObject * obj ); //Adds a CObject to the CObjectManager
 
     void FireGun(CObject* p, eSpriteType bullet); ///< Fire object's gun.
-    CObject* PlayerShoots(); //The player shot thier gun
+    CObject* PlayerShoots(CObject* player); //The player shot thier gun
+    CObject* NearestPlayer(const Vector2& pos); ///< Player closest to a point.
+    UINT FireLasers(CObject* player); ///< Fire a volley of homing lasers.
+    bool Attach(CObject* child, CObject* parent, const Vector2& offset); ///< Attach an object to another.
+    void TimedDeath(); ///< Note that an object with timers has died.
+    bool Bomb(CObject* player); ///< Set off a screen-clearing bomb.
+    int GetBombs(UINT player); ///< Number of bombs a player has left.
+    void SetShotCancel(bool b); ///< Turn shot cancelling on or off.
+    void SetAIBudget(UINT n); ///< Set the most enemy decisions per tick.
+
+    const vector<CObject*>& QueryAABB(const Vector2& lo, const Vector2& hi, UINT64 mask); ///< Objects in a rectangle.
+    const vector<CObject*>& QueryRadius(const Vector2& pos, float r, UINT64 mask); ///< Objects in a circle.
+    const vector<CObject*>& QueryNearest(const Vector2& pos, UINT k, UINT64 mask, float r=FLT_MAX); ///< The k nearest objects.
+    CObject* QueryNearest(const Vector2& pos, UINT64 mask, float r=FLT_MAX); ///< The nearest object.
+    int CountType(eSpriteType t); ///< Number of objects of a type.
     CObject* GetBoss(); //Returns current boss
     int GetScore(); // get the current score
     int enemyCountFunc(); //Count how many normal enemies are present
-    void EnemyKilledScore();    // adds 100 to score when enemy is killed
+    void EnemyKilledScore(CObject* p);    // adds 100 to score when enemy is killed
+    CChain& GetChain(); ///< Get the chain scorer.
     void ResetScore();      // resets score if gameover
     void SetScore(int x); //Reset score when player started the level they died in
     void updateLevel(int x); //updates the current level number
@@ -86,4 +277,15 @@ class CObjectManager:
     void setEnemyCount(int e);
     void setBossPresent(bool b);
 
+    void ReportMemory(); ///< Print object sizes and memory use.
+
+    UINT GetTick(); ///< Get number of simulation ticks so far.
+    void ResetTick(); ///< Start counting simulation ticks from zero.
+    UINT64 HashState(); ///< Hash the whole simulation state.
+    void GetObjectHashes(vector<UINT64>& hashes, vector<int>& types); ///< Hash each object separately.
+
+    void Snapshot(CSnapshot& s); ///< Save the whole simulation state.
+    bool Restore(CSnapshot& s); ///< Restore the whole simulation state from our own snapshot.
+    bool RestoreChecked(CSnapshot& s); ///< Restore the whole simulation state from a snapshot that may be bad.
+
 }; //CObjectManager
\ No newline at end of file
@@ -0,0 +1,101 @@
+/// \file RenderSnapshot.h
+/// \brief Interface for the render snapshot CRenderSnapshot and the
+/// triple buffer CTripleBuffer that hands snapshots to the renderer.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "Defines.h"
+#include "SpriteDesc.h"
+#include "EventQueue.h"
+
+using namespace std;
+
+/// \brief One sprite in a render snapshot.
+
+struct RenderItem{
+  CSpriteDesc2D m_stDesc; ///< Sprite index, frame, position, roll, and tint.
+  Vector2 m_vOldPos; ///< Position at the end of the previous tick.
+  int m_nLayer = 0; ///< Draw layer, lower layers are drawn first.
+}; //RenderItem
+
+/// \brief What the renderer needs to draw one frame.
+///
+/// A render snapshot is a copy of everything that the renderer
+/// needs from the simulation, taken at the end of a simulation step.
+/// The renderer only ever reads a snapshot, so it can draw one
+/// while the simulation is busy with the next step. It holds both
+/// the previous and the current position of everything, so that the
+/// renderer can draw in between ticks when the display runs faster
+/// than the simulation. It also carries the sounds and vibration
+/// asked for by the ticks since the last snapshot, since only the
+/// main thread may use the audio player and the controller.
+
+struct CRenderSnapshot{
+  vector<RenderItem> m_vItems; ///< Sprites in draw order.
+  vector<GameEvent> m_vEvents; ///< Sounds and vibration since the last snapshot.
+  Vector2 m_vCamera; ///< Point for the camera to follow.
+  Vector2 m_vOldCamera; ///< Camera point at the end of the previous tick.
+  Vector2 m_vWorldSize; ///< World width and height.
+  double m_fTime = 0; ///< Real time in seconds at which the snapshot was published.
+  double m_fStep = 0; ///< Length of the last tick in seconds.
+}; //CRenderSnapshot
+
+/// \brief A lock-free triple buffer.
+///
+/// A triple buffer passes values from one writer thread to one reader
+/// thread without either ever waiting for the other. The writer fills
+/// the back buffer and publishes it by swapping it with the middle one.
+/// The reader takes the middle buffer by swapping it with the front one,
+/// but only if something new has been published since it last looked.
+/// Both swaps are a single atomic exchange, so there are no locks and
+/// the reader always gets the most recent complete value.
+/// \tparam T Type of the value.
+
+template<class T> class CTripleBuffer{
+  private:
+    static const UINT FRESH = 4; ///< Flag in m_nMiddle, set when it holds an unread value.
+
+    T m_pBuffer[3]; ///< The buffers.
+    atomic<UINT> m_nMiddle; ///< Index of the middle buffer, and the FRESH flag.
+    UINT m_nBack = 0; ///< Index of the buffer the writer is filling.
+    UINT m_nFront = 1; ///< Index of the buffer the reader is using.
+
+  public:
+    /// Start with the middle buffer empty.
+
+    CTripleBuffer(): m_nMiddle(2){
+    } //constructor
+
+    /// Get the buffer to write to. Writer only.
+    /// \return Reference to the back buffer.
+
+    T& GetBack(){
+      return m_pBuffer[m_nBack];
+    } //GetBack
+
+    /// Publish the back buffer and start on a new one. Writer only.
+
+    void Publish(){
+      m_nBack = m_nMiddle.exchange(m_nBack | FRESH) & ~FRESH;
+    } //Publish
+
+    /// Take the most recently published buffer, if there is one
+    /// that has not been taken already. Reader only.
+    /// \return true if the front buffer was replaced.
+
+    bool Acquire(){
+      if(!(m_nMiddle.load() & FRESH))return false;
+      m_nFront = m_nMiddle.exchange(m_nFront) & ~FRESH;
+      return true;
+    } //Acquire
+
+    /// Get the buffer to read from. Reader only.
+    /// \return Reference to the front buffer.
+
+    const T& GetFront() const{
+      return m_pBuffer[m_nFront];
+    } //GetFront
+}; //CTripleBuffer
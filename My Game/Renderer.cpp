@@ -66,6 +66,7 @@ void CRenderer::LoadImages(){
   Load(LARGE_RESPAWN, "LARGE_RESPAWN");
   Load(SMALL_RESPAWN, "SMALL_RESPAWN");
   Load(END_SCREEN, "END_SCREEN");
+  Load(PICKUP, "PICKUP");
 
   EndResourceUpload();
 } //LoadImages
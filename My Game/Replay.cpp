@@ -0,0 +1,358 @@
+/// \file Replay.cpp
+/// \brief Code for the replay class CReplay.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Replay.h"
+#include "ObjectManager.h"
+
+static const UINT REPLAY_TAG = 0x50525553; ///< Marks the start and end of a replay file.
+static const UINT REPLAY_VERSION = 16; ///< Replay file format version. Bump it whenever the snapshot layout or the simulation changes, so that old replays are refused rather than played out of sync.
+static const UINT KEYFRAME_INTERVAL = 300; ///< Ticks between keyframes, 5 seconds at 60Hz.
+
+/// \brief Replay file header.
+
+struct ReplayHeader{
+  UINT m_nTag; ///< REPLAY_TAG.
+  UINT m_nVersion; ///< REPLAY_VERSION.
+  UINT m_nLevel; ///< Level the replay starts on.
+  UINT m_nInterval; ///< Ticks between keyframes.
+  UINT64 m_nSeed; ///< Random number seed that the level was built with.
+}; //ReplayHeader
+
+/// \brief Replay file footer.
+
+struct ReplayFooter{
+  UINT64 m_nTableOffset; ///< File offset of the input table.
+  UINT m_nTag; ///< REPLAY_TAG.
+  UINT m_nPad; ///< Padding, zero.
+}; //ReplayFooter
+
+/// Compare two results.
+/// \param r Result to compare with.
+/// \return true if they are the same in every field.
+
+bool ReplayResult::operator==(const ReplayResult& r) const{
+  return m_nScore == r.m_nScore && m_nOutcome == r.m_nOutcome && m_nHash == r.m_nHash;
+} //operator==
+
+/// Compress bytes with PackBits run length encoding. A control
+/// byte c < 128 is followed by c + 1 literal bytes, and c >= 128
+/// by one byte that is repeated 257 - c times. Snapshots are mostly
+/// small numbers and zero padding, so this roughly halves them at
+/// very little cost.
+/// \param src Bytes to be compressed.
+/// \param n Number of bytes.
+/// \param dest [out] Compressed bytes.
+
+static void Pack(const char* src, size_t n, vector<char>& dest){
+  dest.clear();
+  size_t i = 0;
+
+  while(i < n){
+    size_t run = 1; //length of run of equal bytes at i
+    while(i + run < n && run < 128 && src[i + run] == src[i])run++;
+
+    if(run >= 3){ //repeat
+      dest.push_back((char)(257 - run));
+      dest.push_back(src[i]);
+      i += run;
+    } //if
+
+    else{ //literals, up to the next run of 3 or more
+      size_t j = i;
+
+      while(j < n && j - i < 128){
+        if(j + 2 < n && src[j] == src[j + 1] && src[j] == src[j + 2])break;
+        j++;
+      } //while
+
+      dest.push_back((char)(j - i - 1));
+      dest.insert(dest.end(), src + i, src + j);
+      i = j;
+    } //else
+  } //while
+} //Pack
+
+/// Decompress bytes compressed with Pack.
+/// \param src Compressed bytes.
+/// \param n Number of compressed bytes.
+/// \param dest [out] Decompressed bytes.
+/// \param size Number of decompressed bytes expected.
+/// \return true if the data decompressed to the expected size.
+
+static bool Unpack(const char* src, size_t n, vector<char>& dest, size_t size){
+  dest.clear();
+  dest.reserve(size);
+  size_t i = 0;
+
+  while(i < n){
+    const UINT c = (unsigned char)src[i++];
+
+    if(c < 128){ //literals
+      const size_t m = min<size_t>(c + 1, n - i);
+      dest.insert(dest.end(), src + i, src + i + m);
+      i += m;
+    } //if
+
+    else if(i < n) //repeat
+      dest.insert(dest.end(), 257 - c, src[i++]);
+  } //while
+
+  return dest.size() == size;
+} //Unpack
+
+/// Finish any recording in progress.
+
+CReplay::~CReplay(){
+  EndRecording();
+} //destructor
+
+/// Open a file and start recording. The first keyframe is taken
+/// by the first call to RecordTick. The level must have just been
+/// built from scratch with the seed, so that a verifier can build
+/// the same start for itself.
+/// \param filename Name of the replay file.
+/// \param level Current level.
+/// \param seed Random number seed that the level was built with.
+/// \return true if the file could be opened.
+
+bool CReplay::BeginRecording(const char* filename, UINT level, UINT64 seed){
+  EndRecording();
+  EndPlayback();
+
+  m_fsRecord.open(filename, ios::binary);
+  if(!m_fsRecord.is_open())return false;
+
+  m_nLevel = level;
+  m_nSeed = seed;
+  m_vInput.clear();
+  m_vKeyTick.clear();
+  m_vKeyOffset.clear();
+
+  const ReplayHeader header = {REPLAY_TAG, REPLAY_VERSION, level, KEYFRAME_INTERVAL, seed};
+  m_fsRecord.write((const char*)&header, sizeof(header));
+
+  m_bRecording = true;
+  return true;
+} //BeginRecording
+
+/// Snapshot the simulation state, compress it, and write it to the
+/// replay file. A keyframe holds the uncompressed size, the compressed
+/// size, and the compressed bytes.
+
+void CReplay::WriteKeyframe(){
+  m_pObjectManager->Snapshot(m_cSnapshot);
+  Pack(m_cSnapshot.GetData(), m_cSnapshot.GetSize(), m_vPacked);
+
+  const UINT size = (UINT)m_cSnapshot.GetSize();
+  const UINT packed = (UINT)m_vPacked.size();
+
+  m_vKeyTick.push_back((UINT)m_vInput.size());
+  m_vKeyOffset.push_back((UINT64)m_fsRecord.tellp());
+
+  m_fsRecord.write((const char*)&size, sizeof(size));
+  m_fsRecord.write((const char*)&packed, sizeof(packed));
+  m_fsRecord.write(m_vPacked.data(), packed);
+} //WriteKeyframe
+
+/// Record the input for the tick about to be simulated. This must be
+/// called before the tick, so that a keyframe taken here holds the
+/// state that the input is applied to.
+/// \param input Player input bits.
+
+void CReplay::RecordTick(UINT input){
+  if(!m_bRecording)return;
+
+  if(m_vInput.size()%KEYFRAME_INTERVAL == 0)
+    WriteKeyframe();
+
+  m_vInput.push_back((BYTE)input);
+} //RecordTick
+
+/// Write the input table, the keyframe index, and the footer,
+/// and close the file.
+
+void CReplay::EndRecording(){
+  if(!m_bRecording)return;
+  m_bRecording = false;
+
+  const UINT ticks = (UINT)m_vInput.size();
+  const UINT keys = (UINT)m_vKeyTick.size();
+  const ReplayFooter footer = {(UINT64)m_fsRecord.tellp(), REPLAY_TAG, 0};
+  m_stResult = Measure();
+
+  m_fsRecord.write((const char*)&ticks, sizeof(ticks));
+  m_fsRecord.write((const char*)m_vInput.data(), ticks*sizeof(BYTE));
+
+  m_fsRecord.write((const char*)&keys, sizeof(keys));
+  m_fsRecord.write((const char*)m_vKeyTick.data(), keys*sizeof(UINT));
+  m_fsRecord.write((const char*)m_vKeyOffset.data(), keys*sizeof(UINT64));
+
+  m_fsRecord.write((const char*)&m_stResult.m_nScore, sizeof(int));
+  m_fsRecord.write((const char*)&m_stResult.m_nOutcome, sizeof(UINT));
+  m_fsRecord.write((const char*)&m_stResult.m_nHash, sizeof(UINT64));
+
+  m_fsRecord.write((const char*)&footer, sizeof(footer));
+  m_fsRecord.close();
+} //EndRecording
+
+/// Load a replay file into memory for playback. The input table and
+/// keyframe index are read now, keyframes are decompressed on demand.
+/// \param filename Name of the replay file.
+/// \param limit Largest file size accepted in bytes, or 0 for no limit.
+/// \return true if the file was loaded and looks like a replay.
+
+bool CReplay::BeginPlayback(const char* filename, size_t limit){
+  EndPlayback();
+
+  ifstream in(filename, ios::binary | ios::ate);
+  if(!in.is_open())return false;
+
+  const streamoff length = in.tellg();
+  if(length < 0 || (limit > 0 && (size_t)length > limit))return false;
+  in.seekg(0);
+
+  m_vFile.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  if(m_vFile.size() < sizeof(ReplayHeader) + sizeof(ReplayFooter))return false;
+
+  ReplayHeader header;
+  ReplayFooter footer;
+  memcpy(&header, m_vFile.data(), sizeof(header));
+  memcpy(&footer, m_vFile.data() + m_vFile.size() - sizeof(footer), sizeof(footer));
+
+  if(header.m_nTag != REPLAY_TAG || header.m_nVersion != REPLAY_VERSION || footer.m_nTag != REPLAY_TAG)
+    return false;
+
+  CSnapshot table; //input table and keyframe index
+  const size_t end = m_vFile.size() - sizeof(footer);
+  if(footer.m_nTableOffset > end)return false;
+  table.SetData(m_vFile.data() + footer.m_nTableOffset, end - (size_t)footer.m_nTableOffset);
+
+  UINT ticks = 0, keys = 0;
+
+  table.Read(ticks);
+  if(ticks > table.GetSize())return false;
+  m_vInput.resize(ticks);
+  table.Read(m_vInput.data(), ticks*sizeof(BYTE));
+
+  table.Read(keys);
+  if(keys == 0 || keys > table.GetSize())return false;
+  m_vKeyTick.resize(keys);
+  m_vKeyOffset.resize(keys);
+  table.Read(m_vKeyTick.data(), keys*sizeof(UINT));
+  table.Read(m_vKeyOffset.data(), keys*sizeof(UINT64));
+
+  table.Read(m_stResult.m_nScore);
+  table.Read(m_stResult.m_nOutcome);
+  table.Read(m_stResult.m_nHash);
+
+  m_nLevel = header.m_nLevel;
+  m_nSeed = header.m_nSeed;
+  m_bPlaying = true;
+  return true;
+} //BeginPlayback
+
+/// Stop playing back and free the file contents.
+
+void CReplay::EndPlayback(){
+  m_bPlaying = false;
+  m_vFile.clear();
+} //EndPlayback
+
+/// Restore the last keyframe at or before a tick. The caller
+/// then simulates forward from the returned tick to reach the
+/// one it wants.
+/// \param tick Tick to be reached.
+/// \return Tick of the keyframe restored.
+
+UINT CReplay::RestoreKeyframe(UINT tick){
+  if(!m_bPlaying)return tick;
+
+  const size_t k = upper_bound(m_vKeyTick.begin(), m_vKeyTick.end(), tick) - m_vKeyTick.begin();
+  const size_t i = k > 0? k - 1: 0;
+  const UINT64 offset = m_vKeyOffset[i];
+
+  UINT size = 0, packed = 0;
+  if(offset + 2*sizeof(UINT) > m_vFile.size())return tick;
+  memcpy(&size, m_vFile.data() + offset, sizeof(size));
+  memcpy(&packed, m_vFile.data() + offset + sizeof(size), sizeof(packed));
+
+  const size_t start = (size_t)offset + 2*sizeof(UINT);
+  if(start + packed > m_vFile.size())return tick;
+
+  vector<char> bytes;
+  if(!Unpack(m_vFile.data() + start, packed, bytes, size))return tick;
+
+  m_cSnapshot.SetData(bytes.data(), bytes.size());
+  if(!m_pObjectManager->RestoreChecked(m_cSnapshot))return tick;
+
+  return m_vKeyTick[i];
+} //RestoreKeyframe
+
+/// Reader function for the recording flag.
+/// \return true if recording.
+
+bool CReplay::IsRecording() const{
+  return m_bRecording;
+} //IsRecording
+
+/// Reader function for the playback flag.
+/// \return true if playing back.
+
+bool CReplay::IsPlaying() const{
+  return m_bPlaying;
+} //IsPlaying
+
+/// Reader function for the level.
+/// \return Level that the replay starts on.
+
+UINT CReplay::GetLevel() const{
+  return m_nLevel;
+} //GetLevel
+
+/// Reader function for the seed.
+/// \return Random number seed that the level was built with.
+
+UINT64 CReplay::GetSeed() const{
+  return m_nSeed;
+} //GetSeed
+
+/// Reader function for the number of ticks.
+/// \return Number of ticks recorded.
+
+UINT CReplay::GetNumTicks() const{
+  return (UINT)m_vInput.size();
+} //GetNumTicks
+
+/// Reader function for the input of a tick.
+/// \param tick Tick number.
+/// \return Player input bits, zero past the end.
+
+UINT CReplay::GetInput(UINT tick) const{
+  return tick < m_vInput.size()? m_vInput[tick]: 0;
+} //GetInput
+
+/// Reader function for the result stored in the file.
+/// \return Result recorded by the client.
+
+const ReplayResult& CReplay::GetResult() const{
+  return m_stResult;
+} //GetResult
+
+/// Get the result of the simulation as it stands now.
+/// \return Score, outcome, and state hash.
+
+ReplayResult CReplay::Measure() const{
+  ReplayResult r;
+  r.m_nScore = m_pObjectManager->GetScore();
+  r.m_nHash = m_pObjectManager->HashState();
+
+  if(m_pObjectManager->getLevelCleared())
+    r.m_nOutcome = OUTCOME_CLEARED;
+  else if(m_pObjectManager->getPlayerHealth() <= 0)
+    r.m_nOutcome = OUTCOME_DIED;
+
+  return r;
+} //Measure
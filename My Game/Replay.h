@@ -0,0 +1,91 @@
+/// \file Replay.h
+/// \brief Interface for the replay class CReplay.
+
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "Common.h"
+#include "Defines.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+/// \brief How a replay ends.
+
+enum eReplayOutcome{
+  OUTCOME_UNFINISHED, OUTCOME_CLEARED, OUTCOME_DIED
+}; //eReplayOutcome
+
+/// \brief The result of a replay.
+///
+/// What the game looked like when a replay ended. The recording
+/// client stores its result in the file, and a verifier compares
+/// it with the result of simulating the replay itself.
+
+struct ReplayResult{
+  int m_nScore = 0; ///< Score.
+  UINT m_nOutcome = OUTCOME_UNFINISHED; ///< Outcome, see eReplayOutcome.
+  UINT64 m_nHash = 0; ///< Hash of the simulation state.
+
+  bool operator==(const ReplayResult& r) const; ///< Equality test.
+}; //ReplayResult
+
+/// \brief A replay.
+///
+/// A replay is the player input for every tick of one attempt at a
+/// level from its start, plus a keyframe (a compressed
+/// snapshot of the simulation state) every few seconds. The header
+/// holds the level and the random number seed that it was built with,
+/// so a verifier can build the starting state itself rather than
+/// trusting the first keyframe. Since the simulation is
+/// deterministic, playing the input back from a keyframe reproduces
+/// the game exactly, and seeking only has to simulate forward from
+/// the nearest keyframe rather than from the start of the level.
+///
+/// Keyframes are written to the file as they are taken. The input
+/// table and the keyframe index go at the end, followed by a footer
+/// that says where they start, so recording never has to seek.
+
+class CReplay: public CCommon{
+  private:
+    ofstream m_fsRecord; ///< File being recorded.
+    bool m_bRecording = false; ///< Whether recording.
+    bool m_bPlaying = false; ///< Whether playing back.
+    UINT m_nLevel = 0; ///< Level the replay starts on.
+    UINT64 m_nSeed = 0; ///< Random number seed that the level was built with.
+
+    vector<BYTE> m_vInput; ///< Input bits for each tick.
+    vector<UINT> m_vKeyTick; ///< Tick of each keyframe.
+    vector<UINT64> m_vKeyOffset; ///< File offset of each keyframe.
+    ReplayResult m_stResult; ///< Result stored in the file.
+
+    vector<char> m_vFile; ///< Contents of the file being played.
+    CSnapshot m_cSnapshot; ///< Keyframe being written or read.
+    vector<char> m_vPacked; ///< Compressed keyframe.
+
+    void WriteKeyframe(); ///< Snapshot and write a keyframe.
+
+  public:
+    ~CReplay(); ///< Destructor.
+
+    bool BeginRecording(const char* filename, UINT level, UINT64 seed); ///< Start recording.
+    void RecordTick(UINT input); ///< Record one tick.
+    void EndRecording(); ///< Finish the file.
+
+    bool BeginPlayback(const char* filename, size_t limit=0); ///< Load a file for playback.
+    void EndPlayback(); ///< Stop playing back.
+
+    bool IsRecording() const; ///< Whether recording.
+    bool IsPlaying() const; ///< Whether playing back.
+
+    UINT GetLevel() const; ///< Get the level.
+    UINT64 GetSeed() const; ///< Get the seed.
+    UINT GetNumTicks() const; ///< Get the number of ticks.
+    UINT GetInput(UINT tick) const; ///< Get the input for a tick.
+    const ReplayResult& GetResult() const; ///< Get the stored result.
+    ReplayResult Measure() const; ///< Get the result of the current state.
+
+    UINT RestoreKeyframe(UINT tick); ///< Restore the keyframe at or before a tick.
+}; //CReplay
@@ -0,0 +1,154 @@
+/// \file ReplayVerifier.cpp
+/// \brief Code for the replay verifier CReplayVerifier.
+
+#include <fstream>
+
+#include "ReplayVerifier.h"
+#include "DebugPrintf.h"
+
+#include <bcrypt.h> //after Defines.h, which includes windows.h
+
+#pragma comment(lib, "bcrypt.lib")
+
+static const size_t MAX_REPLAY_SIZE = 16*1024*1024; ///< Largest replay file accepted, in bytes.
+
+/// Load the signing key.
+/// \param spool Spool directory.
+/// \param keyfile Name of a file holding the signing key.
+
+CReplayVerifier::CReplayVerifier(const char* spool, const char* keyfile){
+  m_strSpool = spool;
+
+  if(!m_strSpool.empty() && m_strSpool.back() != '\\' && m_strSpool.back() != '/')
+    m_strSpool += '\\';
+
+  ifstream in(keyfile, ios::binary);
+  m_vKey.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+  if(m_vKey.empty())
+    DEBUGPRINTF("Replay verifier has no signing key in %s\n", keyfile);
+} //constructor
+
+/// Reader function for the signing key.
+/// \return true if a signing key was loaded.
+
+bool CReplayVerifier::IsReady() const{
+  return !m_vKey.empty();
+} //IsReady
+
+/// Claim a replay from the spool by renaming it from .rpl to .work.
+/// If another verifier renames it first then the rename fails here
+/// and the next one is tried.
+/// \param name [out] Spool path of the claimed replay, without extension.
+/// \return true if a replay was claimed.
+
+bool CReplayVerifier::Claim(string& name){
+  WIN32_FIND_DATAA data;
+  HANDLE h = FindFirstFileA((m_strSpool + "*.rpl").c_str(), &data);
+  if(h == INVALID_HANDLE_VALUE)return false;
+
+  bool claimed = false;
+
+  do{
+    string file = data.cFileName;
+    name = m_strSpool + file.substr(0, file.size() - 4);
+    claimed = MoveFileA((name + ".rpl").c_str(), (name + ".work").c_str()) != 0;
+  }while(!claimed && FindNextFileA(h, &data));
+
+  FindClose(h);
+  return claimed;
+} //Claim
+
+/// Compute an HMAC-SHA256 with the signing key.
+/// \param text Text to be signed.
+/// \return The signature as 64 hex digits, or an empty string on failure.
+
+string CReplayVerifier::Sign(const string& text){
+  BCRYPT_ALG_HANDLE alg = nullptr;
+  BCRYPT_HASH_HANDLE hash = nullptr;
+  BYTE mac[32];
+  bool ok = false;
+
+  if(BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&alg, BCRYPT_SHA256_ALGORITHM, nullptr, BCRYPT_ALG_HANDLE_HMAC_FLAG))){
+    if(BCRYPT_SUCCESS(BCryptCreateHash(alg, &hash, nullptr, 0, m_vKey.data(), (ULONG)m_vKey.size(), 0))){
+      ok = BCRYPT_SUCCESS(BCryptHashData(hash, (PUCHAR)text.data(), (ULONG)text.size(), 0)) &&
+        BCRYPT_SUCCESS(BCryptFinishHash(hash, mac, sizeof(mac), 0));
+      BCryptDestroyHash(hash);
+    } //if
+
+    BCryptCloseAlgorithmProvider(alg, 0);
+  } //if
+
+  if(!ok)return "";
+
+  static const char hex[] = "0123456789abcdef";
+  string s;
+
+  for(BYTE b: mac){
+    s += hex[b >> 4];
+    s += hex[b & 15];
+  } //for
+
+  return s;
+} //Sign
+
+/// Write the verdict for a replay to a .result file next to it. The
+/// last line is a signature over all of the lines before it.
+/// \param name Spool path of the replay, without extension.
+/// \param verdict "valid", "invalid", or "unreadable".
+/// \param claimed Result claimed by the client.
+/// \param actual Result of the verifier's simulation.
+
+void CReplayVerifier::WriteResult(const string& name, const char* verdict,
+  const ReplayResult& claimed, const ReplayResult& actual)
+{
+  char buffer[512];
+  const size_t slash = name.find_last_of("\\/");
+
+  sprintf_s(buffer, sizeof(buffer),
+    "replay %s\nverdict %s\nlevel %u\nticks %u\n"
+    "claimed %d %u %016llx\nactual %d %u %016llx\n",
+    name.substr(slash == string::npos? 0: slash + 1).c_str(), verdict,
+    m_cReplay.GetLevel(), m_cReplay.GetNumTicks(),
+    claimed.m_nScore, claimed.m_nOutcome, (unsigned long long)claimed.m_nHash,
+    actual.m_nScore, actual.m_nOutcome, (unsigned long long)actual.m_nHash);
+
+  const string text = buffer;
+  ofstream out(name + ".result", ios::binary);
+  out << text << "signature " << Sign(text) << "\n";
+} //WriteResult
+
+/// Claim one replay from the spool and verify it. The simulation is
+/// driven by the caller, which builds the replay's level from scratch
+/// and runs every tick of recorded input. That leaves the result of
+/// the replay in the object manager to be compared with the claim.
+/// \param play Function that simulates a replay from start to end, returning false if it cannot.
+/// \return true if a replay was verified, false if the spool is empty.
+
+bool CReplayVerifier::Poll(const function<bool(CReplay&)>& play){
+  if(!IsReady())return false;
+
+  string name;
+  if(!Claim(name))return false;
+
+  const ReplayResult none;
+
+  if(!m_cReplay.BeginPlayback((name + ".work").c_str(), MAX_REPLAY_SIZE))
+    WriteResult(name, "unreadable", none, none);
+
+  else if(!play(m_cReplay)){
+    WriteResult(name, "invalid", m_cReplay.GetResult(), none);
+    m_cReplay.EndPlayback();
+  } //else if
+
+  else{
+    const ReplayResult& claimed = m_cReplay.GetResult();
+    const ReplayResult actual = m_cReplay.Measure();
+
+    WriteResult(name, claimed == actual? "valid": "invalid", claimed, actual);
+    m_cReplay.EndPlayback();
+  } //else
+
+  MoveFileA((name + ".work").c_str(), (name + ".done").c_str());
+  return true;
+} //Poll
@@ -0,0 +1,48 @@
+/// \file ReplayVerifier.h
+/// \brief Interface for the replay verifier CReplayVerifier.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "Defines.h"
+#include "Replay.h"
+
+//#define USE_REPLAY_VERIFIER ///< Define this to run as a replay verifier instead of a game.
+
+using namespace std;
+
+/// \brief The replay verifier.
+///
+/// The replay verifier checks replays submitted for the high score
+/// table. Replays are dropped into a spool directory. The verifier
+/// claims one by renaming it, simulates it with no rendering from a
+/// start that it builds itself from the level and seed in the replay, and compares the score, outcome, and state hash
+/// with the ones the client claimed. The verdict is written next to
+/// the replay with an HMAC-SHA256 signature keyed from a file that
+/// only the server has, so that the client cannot forge it.
+///
+/// Claiming is an atomic rename, so any number of verifier processes
+/// can share one spool directory. Each holds one replay at a time and
+/// refuses files over a size limit, which bounds its memory.
+
+class CReplayVerifier: public CCommon{
+  private:
+    string m_strSpool; ///< Spool directory, with trailing separator.
+    vector<BYTE> m_vKey; ///< Signing key.
+    CReplay m_cReplay; ///< Replay being verified.
+
+    bool Claim(string& name); ///< Claim a replay from the spool.
+    void WriteResult(const string& name, const char* verdict,
+      const ReplayResult& claimed, const ReplayResult& actual); ///< Write a signed verdict.
+    string Sign(const string& text); ///< HMAC-SHA256 of text as hex.
+
+  public:
+    CReplayVerifier(const char* spool, const char* keyfile); ///< Constructor.
+
+    bool Poll(const function<bool(CReplay&)>& play); ///< Verify one replay from the spool.
+    bool IsReady() const; ///< Whether a signing key was loaded.
+}; //CReplayVerifier
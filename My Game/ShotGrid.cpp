@@ -0,0 +1,134 @@
+/// \file ShotGrid.cpp
+/// \brief Code for the uniform grid CShotGrid.
+
+#include <algorithm>
+#include <cfloat>
+
+#include "ShotGrid.h"
+
+static const float MIN_CELL = 32.0f; ///< Smallest cell size.
+static const UINT MAX_CELLS = 4096; ///< Cells are made bigger rather than have more than this many.
+
+/// Remove all boxes. The arrays keep their capacity, so binning
+/// the same number of boxes again next tick does not allocate.
+
+void CShotGrid::Clear(){
+  m_vLo.clear();
+  m_vHi.clear();
+  m_nWidth = m_nHeight = 0;
+} //Clear
+
+/// Add a box to be binned by the next Build().
+/// \param lo Bottom left corner.
+/// \param hi Top right corner.
+
+void CShotGrid::Add(const Vector2& lo, const Vector2& hi){
+  m_vLo.push_back(lo);
+  m_vHi.push_back(hi);
+} //Add
+
+/// Get the column of the grid that an x coordinate is in,
+/// clamped to the grid.
+/// \param x The x coordinate.
+/// \return Column number.
+
+UINT CShotGrid::Column(float x) const{
+  const float c = (x - m_vOrigin.x)/m_fCell;
+  return c <= 0.0f? 0: min((UINT)c, m_nWidth - 1);
+} //Column
+
+/// Get the row of the grid that a y coordinate is in,
+/// clamped to the grid.
+/// \param y The y coordinate.
+/// \return Row number.
+
+UINT CShotGrid::Row(float y) const{
+  const float r = (y - m_vOrigin.y)/m_fCell;
+  return r <= 0.0f? 0: min((UINT)r, m_nHeight - 1);
+} //Row
+
+/// Bin the boxes into the grid. The grid covers the boxes' centers,
+/// with cells at least as big as the biggest box, and bigger if that
+/// would make too many cells. The boxes are then counting sorted by
+/// cell: count the boxes in each cell, turn the counts into starting
+/// places, and drop each box into place.
+
+void CShotGrid::Build(){
+  const UINT n = (UINT)m_vLo.size();
+  if(n == 0)return;
+
+  Vector2 lo(FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX); //bounds of the centers
+  m_vReach = Vector2::Zero;
+
+  for(UINT i=0; i<n; i++){
+    const Vector2 c = 0.5f*(m_vLo[i] + m_vHi[i]);
+    lo = Vector2::Min(lo, c);
+    hi = Vector2::Max(hi, c);
+    m_vReach = Vector2::Max(m_vReach, 0.5f*(m_vHi[i] - m_vLo[i]));
+  } //for
+
+  const Vector2 size = hi - lo;
+  m_fCell = max(MIN_CELL, 2.0f*max(m_vReach.x, m_vReach.y));
+
+  while((size.x/m_fCell + 1.0f)*(size.y/m_fCell + 1.0f) > (float)MAX_CELLS)
+    m_fCell *= 2.0f;
+
+  m_vOrigin = lo;
+  m_nWidth = (UINT)(size.x/m_fCell) + 1;
+  m_nHeight = (UINT)(size.y/m_fCell) + 1;
+
+  m_vStart.assign(m_nWidth*m_nHeight + 1, 0);
+  m_vCell.resize(n);
+  m_vItems.resize(n);
+
+  for(UINT i=0; i<n; i++){ //count
+    const Vector2 c = 0.5f*(m_vLo[i] + m_vHi[i]);
+    m_vCell[i] = Row(c.y)*m_nWidth + Column(c.x);
+    m_vStart[m_vCell[i] + 1]++;
+  } //for
+
+  for(size_t k=1; k<m_vStart.size(); k++) //counts to starting places
+    m_vStart[k] += m_vStart[k - 1];
+
+  for(UINT i=0; i<n; i++) //drop into place, in order within each cell
+    m_vItems[m_vStart[m_vCell[i]]++] = i;
+
+  for(size_t k=m_vStart.size() - 1; k>0; k--) //starts were moved on by one cell
+    m_vStart[k] = m_vStart[k - 1];
+
+  m_vStart[0] = 0;
+} //Build
+
+/// Find the binned boxes that overlap a box. Only the cells under
+/// the box grown by half the size of the biggest binned box can
+/// hold the center of a box that overlaps it.
+/// \param lo Bottom left corner.
+/// \param hi Top right corner.
+/// \param result [out] Numbers of the boxes found, in the order they were added within each cell.
+
+void CShotGrid::Query(const Vector2& lo, const Vector2& hi, vector<UINT>& result) const{
+  result.clear();
+  if(m_nWidth == 0)return;
+
+  const Vector2 a = lo - m_vReach;
+  const Vector2 b = hi + m_vReach;
+
+  const float right = m_vOrigin.x + m_nWidth*m_fCell;
+  const float top = m_vOrigin.y + m_nHeight*m_fCell;
+  if(b.x < m_vOrigin.x || b.y < m_vOrigin.y || a.x > right || a.y > top)return; //misses the grid
+
+  const UINT c0 = Column(a.x), c1 = Column(b.x);
+  const UINT r0 = Row(a.y), r1 = Row(b.y);
+
+  for(UINT r=r0; r<=r1; r++)
+    for(UINT c=c0; c<=c1; c++){
+      const UINT cell = r*m_nWidth + c;
+
+      for(UINT k=m_vStart[cell]; k<m_vStart[cell + 1]; k++){
+        const UINT i = m_vItems[k];
+
+        if(m_vLo[i].x <= hi.x && lo.x <= m_vHi[i].x && m_vLo[i].y <= hi.y && lo.y <= m_vHi[i].y)
+          result.push_back(i);
+      } //for
+    } //for
+} //Query
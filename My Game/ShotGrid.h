@@ -0,0 +1,46 @@
+/// \file ShotGrid.h
+/// \brief Interface for the uniform grid CShotGrid.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+/// \brief A uniform grid for finding overlaps between two sets of boxes.
+///
+/// One set of axis-aligned boxes is binned into a grid by the cell that
+/// its center is in, and then each box of the other set probes the grid
+/// for boxes that overlap it. The cells are made at least as big as the
+/// biggest binned box, so a probe only has to look at the cells under
+/// it grown by half that size, and each binned box is in exactly one
+/// cell, so nothing is found twice. Binning is a counting sort, so
+/// building the grid is linear in the number of boxes and a probe costs
+/// about as much as the number of boxes near it. The grid keeps its
+/// memory from one build to the next.
+
+class CShotGrid{
+  private:
+    vector<Vector2> m_vLo; ///< Bottom left corner of each box.
+    vector<Vector2> m_vHi; ///< Top right corner of each box.
+    vector<UINT> m_vCell; ///< Cell of each box.
+    vector<UINT> m_vStart; ///< Where each cell's boxes start in m_vItems.
+    vector<UINT> m_vItems; ///< Box numbers, sorted by cell.
+
+    Vector2 m_vOrigin; ///< Bottom left corner of the grid.
+    Vector2 m_vReach; ///< Half the size of the biggest box.
+    float m_fCell = 0.0f; ///< Width and height of a cell.
+    UINT m_nWidth = 0; ///< Number of columns.
+    UINT m_nHeight = 0; ///< Number of rows.
+
+    UINT Column(float x) const; ///< Column that an x coordinate is in.
+    UINT Row(float y) const; ///< Row that a y coordinate is in.
+
+  public:
+    void Clear(); ///< Remove all boxes but keep the memory.
+    void Add(const Vector2& lo, const Vector2& hi); ///< Add a box.
+    void Build(); ///< Bin the boxes into the grid.
+    void Query(const Vector2& lo, const Vector2& hi, vector<UINT>& result) const; ///< Boxes overlapping a box.
+}; //CShotGrid
@@ -0,0 +1,290 @@
+/// \file ShotPack.cpp
+/// \brief Code for the packed enemy shot array CShotPack.
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif //_MSC_VER
+
+#include "ShotPack.h"
+
+#ifdef __GNUC__
+  #define AVX2_TARGET __attribute__((target("avx2"))) ///< Let GCC and Clang use AVX2 in one function.
+#else
+  #define AVX2_TARGET ///< MSVC allows AVX2 intrinsics anywhere.
+#endif //__GNUC__
+
+/// Ask the processor whether it has AVX2, and the operating system
+/// whether it saves the AVX registers on a context switch.
+/// \return true if the AVX2 path can be used.
+
+static bool HasAVX2(){
+#ifdef _MSC_VER
+  int info[4]; //eax, ebx, ecx, edx
+  __cpuid(info, 0);
+  if(info[0] < 7)return false; //no extended features leaf
+
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if(!osxsave || !avx || (_xgetbv(0) & 6) != 6)return false; //no AVX state saved
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0; //AVX2 bit
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif //_MSC_VER
+} //HasAVX2
+
+bool CShotPack::m_bAVX2 = HasAVX2();
+
+/// Choose between the AVX2 and SSE2 paths. Both give exactly the same
+/// results, so this only changes the speed. AVX2 is only used if the
+/// processor has it.
+/// \param avx2 true to use AVX2 if possible, false for SSE2.
+/// \return true if the AVX2 path is now in use.
+
+bool CShotPack::UseAVX2(bool avx2){
+  m_bAVX2 = avx2 && HasAVX2();
+  return m_bAVX2;
+} //UseAVX2
+
+/// Remove all shots. The arrays keep their capacity, so packing
+/// the same number of shots again next tick does not allocate.
+
+void CShotPack::Clear(){
+  m_vX.clear(); m_vY.clear();
+  m_vDX.clear(); m_vDY.clear();
+  m_vR.clear();
+  m_vRed.clear(); m_vBlue.clear(); m_vLive.clear(); m_vGrazed.clear();
+  m_nSize = 0;
+} //Clear
+
+/// Add a shot to the end of the arrays.
+/// \param pos Center at the start of the tick.
+/// \param d Motion over the tick.
+/// \param r Radius.
+/// \param color 'r' for red, 'b' for blue, or 0 for neither.
+/// \param live false if the shot is already dead.
+/// \param grazed true if the shot has already grazed a ship.
+
+void CShotPack::Add(const Vector2& pos, const Vector2& d, float r, char color, bool live, bool grazed){
+  const UINT bit = 1 << (m_nSize%BLOCK);
+
+  if(bit == 1){ //first shot in a new block
+    m_vRed.push_back(0);
+    m_vBlue.push_back(0);
+    m_vLive.push_back(0);
+    m_vGrazed.push_back(0);
+  } //if
+
+  if(color == 'r')m_vRed.back() |= bit;
+  if(color == 'b')m_vBlue.back() |= bit;
+  if(live)m_vLive.back() |= bit;
+  if(grazed)m_vGrazed.back() |= bit;
+
+  m_vX.push_back(pos.x); m_vY.push_back(pos.y);
+  m_vDX.push_back(d.x); m_vDY.push_back(d.y);
+  m_vR.push_back(r);
+  m_nSize++;
+} //Add
+
+/// Pad the arrays out to a whole number of blocks with shots that
+/// are far away, not moving, and of zero size, so they never hit.
+
+void CShotPack::Pad(){
+  while(m_vX.size()%BLOCK != 0){
+    m_vX.push_back(-1e6f); m_vY.push_back(-1e6f);
+    m_vDX.push_back(0.0f); m_vDY.push_back(0.0f);
+    m_vR.push_back(0.0f);
+  } //while
+} //Pad
+
+/// Reader function for the number of shots.
+/// \return Number of shots, not counting padding.
+
+UINT CShotPack::GetSize() const{
+  return m_nSize;
+} //GetSize
+
+/// Reader function for the number of blocks.
+/// \return Number of blocks, including the last partly padded one.
+
+UINT CShotPack::GetNumBlocks() const{
+  return (UINT)m_vX.size()/BLOCK;
+} //GetNumBlocks
+
+/// Reader function for the shots of one color in a block.
+/// \param block Block number.
+/// \param color 'r' for red or 'b' for blue.
+/// \return Bit mask with bit i set if shot i of the block is that color.
+
+UINT CShotPack::GetColorMask(UINT block, char color) const{
+  return color == 'r'? m_vRed[block]: color == 'b'? m_vBlue[block]: 0;
+} //GetColorMask
+
+/// Use up shots in a block, for example when a ship absorbs them.
+/// Shots that are already used up are left out of the result,
+/// so no shot is ever taken twice.
+/// \param block Block number.
+/// \param mask Bit mask of shots to take.
+/// \return Bit mask of the shots that were taken.
+
+UINT CShotPack::Take(UINT block, UINT mask){
+  mask &= m_vLive[block];
+  m_vLive[block] &= ~mask;
+  return mask;
+} //Take
+
+/// Mark live shots in a block as having grazed a ship. Shots that
+/// have grazed before are left out of the result, so each shot
+/// only ever grazes once.
+/// \param block Block number.
+/// \param mask Bit mask of shots that passed close to a ship.
+/// \return Bit mask of the shots grazing for the first time.
+
+UINT CShotPack::Graze(UINT block, UINT mask){
+  mask &= m_vLive[block] & ~m_vGrazed[block];
+  m_vGrazed[block] |= mask;
+  return mask;
+} //Graze
+
+/// Test a ship against four shots, one in each lane of an SSE2 register.
+/// \param x Shot x at the start of the tick.
+/// \param y Shot y at the start of the tick.
+/// \param dx Shot motion in x.
+/// \param dy Shot motion in y.
+/// \param rs Shot radius.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \param t [out] Array of four times of impact.
+/// \param nearby [out] Bit mask with bit i set if shot i comes within the margin.
+/// \return Bit mask with bit i set if shot i hits the ship.
+
+static UINT Test4(const float* x, const float* y, const float* dx, const float* dy, const float* rs,
+  const Vector2& pos, const Vector2& d, float r, float margin, float* t, UINT& nearby)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  const __m128 px = _mm_sub_ps(_mm_loadu_ps(x), _mm_set1_ps(pos.x)); //relative position
+  const __m128 py = _mm_sub_ps(_mm_loadu_ps(y), _mm_set1_ps(pos.y));
+  const __m128 vx = _mm_sub_ps(_mm_loadu_ps(dx), _mm_set1_ps(d.x)); //relative motion
+  const __m128 vy = _mm_sub_ps(_mm_loadu_ps(dy), _mm_set1_ps(d.y));
+  const __m128 rr = _mm_add_ps(_mm_loadu_ps(rs), _mm_set1_ps(r)); //sum of radii
+
+  const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(rr, rr));
+  const __m128 a = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+  const __m128 b = _mm_add_ps(_mm_mul_ps(px, vx), _mm_mul_ps(py, vy));
+  const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+  const __m128 root = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+  __m128 toi = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), root), a);
+
+  const __m128 touching = _mm_cmple_ps(c, zero); //touching at the start
+  const __m128 closing = _mm_and_ps(_mm_cmpgt_ps(a, zero), _mm_cmplt_ps(b, zero));
+  const __m128 reaches = _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmple_ps(toi, one));
+  const __m128 hit = _mm_or_ps(touching, _mm_and_ps(closing, reaches));
+
+  const __m128 rg = _mm_add_ps(rr, _mm_set1_ps(margin)); //grown sum of radii
+  const __m128 cg = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(rg, rg));
+  const __m128 discg = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, cg));
+  const __m128 toig = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(discg, zero))), a);
+  const __m128 reachesg = _mm_and_ps(_mm_cmpge_ps(discg, zero), _mm_cmple_ps(toig, one));
+  const __m128 grazes = _mm_or_ps(_mm_cmple_ps(cg, zero), _mm_and_ps(closing, reachesg));
+
+  toi = _mm_andnot_ps(touching, toi); //zero where touching at the start
+  _mm_storeu_ps(t, toi);
+
+  nearby = (UINT)_mm_movemask_ps(grazes);
+
+  return (UINT)_mm_movemask_ps(hit);
+} //Test4
+
+/// Test a ship against one block of eight shots using AVX2. The eight
+/// lanes of each register hold the eight shots, and the ship is
+/// broadcast to all of them. The near miss test is the same test again
+/// with the ship's radius grown by a margin, sharing everything but the
+/// last few steps. The operations are the same ones in the same order
+/// as Test4, so the results are too.
+/// \param x Shot x at the start of the tick.
+/// \param y Shot y at the start of the tick.
+/// \param dx Shot motion in x.
+/// \param dy Shot motion in y.
+/// \param rs Shot radius.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \param t [out] Array of eight times of impact.
+/// \param nearby [out] Bit mask with bit i set if shot i comes within the margin.
+/// \return Bit mask with bit i set if shot i hits the ship.
+
+AVX2_TARGET static UINT Test8(const float* x, const float* y, const float* dx, const float* dy, const float* rs,
+  const Vector2& pos, const Vector2& d, float r, float margin, float* t, UINT& nearby)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  const __m256 px = _mm256_sub_ps(_mm256_loadu_ps(x), _mm256_set1_ps(pos.x)); //relative position
+  const __m256 py = _mm256_sub_ps(_mm256_loadu_ps(y), _mm256_set1_ps(pos.y));
+  const __m256 vx = _mm256_sub_ps(_mm256_loadu_ps(dx), _mm256_set1_ps(d.x)); //relative motion
+  const __m256 vy = _mm256_sub_ps(_mm256_loadu_ps(dy), _mm256_set1_ps(d.y));
+  const __m256 rr = _mm256_add_ps(_mm256_loadu_ps(rs), _mm256_set1_ps(r)); //sum of radii
+
+  const __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(rr, rr));
+  const __m256 a = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+  const __m256 b = _mm256_add_ps(_mm256_mul_ps(px, vx), _mm256_mul_ps(py, vy));
+  const __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+
+  const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(disc, zero));
+  __m256 toi = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), root), a);
+
+  const __m256 touching = _mm256_cmp_ps(c, zero, _CMP_LE_OQ); //touching at the start
+  const __m256 closing = _mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_GT_OQ), _mm256_cmp_ps(b, zero, _CMP_LT_OQ));
+  const __m256 reaches = _mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ), _mm256_cmp_ps(toi, one, _CMP_LE_OQ));
+  const __m256 hit = _mm256_or_ps(touching, _mm256_and_ps(closing, reaches));
+
+  const __m256 rg = _mm256_add_ps(rr, _mm256_set1_ps(margin)); //grown sum of radii
+  const __m256 cg = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(rg, rg));
+  const __m256 discg = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, cg));
+  const __m256 toig = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(_mm256_max_ps(discg, zero))), a);
+  const __m256 reachesg = _mm256_and_ps(_mm256_cmp_ps(discg, zero, _CMP_GE_OQ), _mm256_cmp_ps(toig, one, _CMP_LE_OQ));
+  const __m256 grazes = _mm256_or_ps(_mm256_cmp_ps(cg, zero, _CMP_LE_OQ), _mm256_and_ps(closing, reachesg));
+
+  toi = _mm256_blendv_ps(toi, zero, touching);
+  _mm256_storeu_ps(t, toi);
+
+  nearby = (UINT)_mm256_movemask_ps(grazes);
+
+  return (UINT)_mm256_movemask_ps(hit);
+} //Test8
+
+/// Test a ship against one block of shots, eight at a time with AVX2
+/// or four at a time with SSE2.
+/// \param block Block number.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \param t [out] Array of BLOCK times of impact, valid for the lanes that hit.
+/// \param nearby [out] Bit mask with bit i set if shot i comes within the margin.
+/// \return Bit mask with bit i set if shot i of the block hits the ship.
+
+UINT CShotPack::Test(UINT block, const Vector2& pos, const Vector2& d, float r, float margin, float* t, UINT& nearby) const{
+  const size_t k = (size_t)block*BLOCK;
+
+  if(m_bAVX2)
+    return Test8(&m_vX[k], &m_vY[k], &m_vDX[k], &m_vDY[k], &m_vR[k], pos, d, r, margin, t, nearby);
+
+  UINT nearlo = 0, nearhi = 0;
+
+  const UINT lo = Test4(&m_vX[k], &m_vY[k], &m_vDX[k], &m_vDY[k], &m_vR[k], pos, d, r, margin, t, nearlo);
+  const UINT hi = Test4(&m_vX[k + 4], &m_vY[k + 4], &m_vDX[k + 4], &m_vDY[k + 4], &m_vR[k + 4], pos, d, r, margin, t + 4, nearhi);
+
+  nearby = nearlo | nearhi << 4;
+  return lo | hi << 4;
+} //Test
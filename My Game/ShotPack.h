@@ -0,0 +1,61 @@
+/// \file ShotPack.h
+/// \brief Interface for the packed enemy shot array CShotPack.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+/// \brief Enemy shots packed for testing against a ship.
+///
+/// Enemy shots are by far the most common thing to hit a ship, and
+/// there are a lot of them. CShotPack keeps their swept circles in
+/// separate arrays of floats, padded to a whole number of blocks, so
+/// that one ship can be tested against a block of shots at a time
+/// with SIMD instructions. The test is the same swept circle test as
+/// CObjectManager::Sweep, done in every lane at once. If the processor
+/// has AVX2 a block is eight shots in one register, otherwise it is
+/// eight shots in two SSE2 registers. Which one is used is decided when
+/// the game starts, and both give exactly the same results, so players
+/// on different processors stay in sync. The same pass also finds near misses, shots
+/// that come within a margin of the ship, for grazing. Each block also
+/// has bit masks saying which shots are red, which are blue, which have
+/// not been used up yet, and which have already grazed a ship, so that
+/// results can be sorted out a whole block at a time.
+
+class CShotPack{
+  public:
+    static const UINT BLOCK = 8; ///< Number of shots tested at a time.
+
+  private:
+    vector<float> m_vX; ///< Center x at the start of the tick.
+    vector<float> m_vY; ///< Center y at the start of the tick.
+    vector<float> m_vDX; ///< Motion in x over the tick.
+    vector<float> m_vDY; ///< Motion in y over the tick.
+    vector<float> m_vR; ///< Radius.
+    vector<UINT> m_vRed; ///< For each block, which shots are red.
+    vector<UINT> m_vBlue; ///< For each block, which shots are blue.
+    vector<UINT> m_vLive; ///< For each block, which shots have not been used up.
+    vector<UINT> m_vGrazed; ///< For each block, which shots have grazed a ship.
+    UINT m_nSize = 0; ///< Number of shots, not counting padding.
+    static bool m_bAVX2; ///< Whether to use the AVX2 path.
+
+  public:
+    void Clear(); ///< Remove all shots but keep the memory.
+    void Add(const Vector2& pos, const Vector2& d, float r, char color, bool live, bool grazed); ///< Add a shot.
+    void Pad(); ///< Pad to a whole number of blocks.
+
+    UINT GetSize() const; ///< Number of shots.
+    UINT GetNumBlocks() const; ///< Number of blocks.
+
+    UINT GetColorMask(UINT block, char color) const; ///< Shots of one color in a block.
+    UINT Take(UINT block, UINT mask); ///< Use up live shots in a block.
+    UINT Graze(UINT block, UINT mask); ///< Mark live shots in a block as grazed.
+
+    UINT Test(UINT block, const Vector2& pos, const Vector2& d, float r, float margin, float* t, UINT& nearby) const; ///< Test a ship against a block.
+
+    static bool UseAVX2(bool avx2); ///< Choose the AVX2 or SSE2 path.
+}; //CShotPack
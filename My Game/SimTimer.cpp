@@ -0,0 +1,35 @@
+/// \file SimTimer.cpp
+/// \brief Code for the simulation clock CSimTimer.
+
+#include "SimTimer.h"
+
+/// Advance the clock by one simulation tick.
+/// \param dt Length of the tick in seconds.
+
+void CSimTimer::Tick(float dt){
+  m_fElapsed = dt;
+  m_fTotal += dt;
+} //Tick
+
+/// Reader function for the length of the current tick.
+/// \return Seconds in the current tick.
+
+float CSimTimer::GetElapsedSeconds() const{
+  return m_fElapsed;
+} //GetElapsedSeconds
+
+/// Reader function for the simulated time.
+/// \return Simulated seconds since the start.
+
+double CSimTimer::GetTotalSeconds() const{
+  return m_fTotal;
+} //GetTotalSeconds
+
+/// Writer function for the simulated time, used when
+/// restoring a snapshot.
+/// \param t Simulated seconds since the start.
+
+void CSimTimer::SetTotalSeconds(double t){
+  m_fTotal = t;
+  m_fElapsed = 0.0f;
+} //SetTotalSeconds
@@ -0,0 +1,27 @@
+/// \file SimTimer.h
+/// \brief Interface for the simulation clock CSimTimer.
+
+#pragma once
+
+#include "Defines.h"
+
+/// \brief The simulation clock.
+///
+/// CSimTimer is the clock that game objects read their frame time
+/// and timer values from. It only moves when the simulation ticks,
+/// so a tick can be re-run from a snapshot or a replay faster than
+/// real time and still see exactly the same times as the first run.
+/// Its reader functions have the same names as the step timer's.
+
+class CSimTimer{
+  private:
+    double m_fTotal = 0.0; ///< Simulated seconds since the start.
+    float m_fElapsed = 0.0f; ///< Seconds in the current tick.
+
+  public:
+    void Tick(float dt); ///< Advance by one tick.
+
+    float GetElapsedSeconds() const; ///< Get seconds in the current tick.
+    double GetTotalSeconds() const; ///< Get simulated seconds so far.
+    void SetTotalSeconds(double t); ///< Set simulated seconds so far.
+}; //CSimTimer
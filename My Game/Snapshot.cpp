@@ -0,0 +1,88 @@
+/// \file Snapshot.cpp
+/// \brief Code for the state snapshot class CSnapshot.
+
+#include <cstring>
+
+#include "Snapshot.h"
+
+/// Discard the contents. The vector keeps its capacity, so
+/// writing a snapshot of the same size again does not allocate.
+
+void CSnapshot::Clear(){
+  m_vBuffer.clear();
+  m_nReadPos = 0;
+} //Clear
+
+/// Move the read cursor back to the start of the buffer.
+
+void CSnapshot::Rewind(){
+  m_nReadPos = 0;
+} //Rewind
+
+/// Append bytes to the end of the buffer.
+/// \param p Pointer to the bytes.
+/// \param n Number of bytes.
+
+void CSnapshot::Write(const void* p, size_t n){
+  const size_t size = m_vBuffer.size();
+  m_vBuffer.resize(size + n);
+  memcpy(m_vBuffer.data() + size, p, n);
+} //Write
+
+/// Read bytes at the read cursor and advance it. Reading past
+/// the end gives zeros rather than garbage.
+/// \param p [out] Pointer to where the bytes go.
+/// \param n Number of bytes.
+
+void CSnapshot::Read(void* p, size_t n){
+  const size_t avail = m_nReadPos < m_vBuffer.size()? m_vBuffer.size() - m_nReadPos: 0;
+  const size_t m = min(n, avail);
+
+  if(m > 0)
+    memcpy(p, m_vBuffer.data() + m_nReadPos, m);
+
+  if(m < n)
+    memset((char*)p + m, 0, n - m);
+
+  m_nReadPos += n;
+} //Read
+
+/// Check whether the snapshot is empty.
+/// \return true if nothing has been written.
+
+bool CSnapshot::IsEmpty() const{
+  return m_vBuffer.empty();
+} //IsEmpty
+
+/// Reader function for the size.
+/// \return Number of bytes written.
+
+size_t CSnapshot::GetSize() const{
+  return m_vBuffer.size();
+} //GetSize
+
+/// Reader function for the number of bytes after the read cursor.
+/// A count read from a snapshot can be checked against this before
+/// anything is allocated for it.
+/// \return Number of bytes left to read.
+
+size_t CSnapshot::GetRemaining() const{
+  return m_nReadPos < m_vBuffer.size()? m_vBuffer.size() - m_nReadPos: 0;
+} //GetRemaining
+
+/// Reader function for the raw bytes, for saving to a file.
+/// \return Pointer to the bytes.
+
+const char* CSnapshot::GetData() const{
+  return m_vBuffer.data();
+} //GetData
+
+/// Replace the contents with bytes from elsewhere, for example
+/// a snapshot loaded from a file.
+/// \param p Pointer to the bytes.
+/// \param n Number of bytes.
+
+void CSnapshot::SetData(const char* p, size_t n){
+  m_vBuffer.assign(p, p + n);
+  m_nReadPos = 0;
+} //SetData
@@ -0,0 +1,51 @@
+/// \file Snapshot.h
+/// \brief Interface for the state snapshot class CSnapshot.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+/// \brief A saved copy of the simulation state.
+///
+/// CSnapshot is a flat byte buffer that the object manager writes
+/// the simulation state into and reads it back from. Values are
+/// copied in and out with memcpy in a fixed order, so there is no
+/// per-field formatting cost. Clearing keeps the memory, so taking
+/// a snapshot every frame does not allocate once the buffer has grown.
+
+class CSnapshot{
+  private:
+    vector<char> m_vBuffer; ///< Saved bytes.
+    size_t m_nReadPos = 0; ///< Read cursor.
+
+  public:
+    void Clear(); ///< Discard contents but keep memory.
+    void Rewind(); ///< Move read cursor back to the start.
+
+    void Write(const void* p, size_t n); ///< Append bytes.
+    void Read(void* p, size_t n); ///< Read bytes at the cursor.
+
+    /// Append one value of plain old data.
+    /// \param x Value to be written.
+
+    template<class T> void Write(const T& x){
+      Write(&x, sizeof(T));
+    } //Write
+
+    /// Read one value of plain old data.
+    /// \param x [out] Value read.
+
+    template<class T> void Read(T& x){
+      Read(&x, sizeof(T));
+    } //Read
+
+    bool IsEmpty() const; ///< Whether anything has been written.
+    size_t GetSize() const; ///< Number of bytes written.
+    size_t GetRemaining() const; ///< Number of bytes left to read.
+    const char* GetData() const; ///< Pointer to the bytes.
+    void SetData(const char* p, size_t n); ///< Replace contents.
+}; //CSnapshot
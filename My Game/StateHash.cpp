@@ -0,0 +1,78 @@
+/// \file StateHash.cpp
+/// \brief Code for the state hash class CStateHash.
+
+#include <cstring>
+
+#include "StateHash.h"
+
+static const UINT64 PRIME1 = 0x9E3779B185EBCA87ULL; ///< xxHash64 prime 1.
+static const UINT64 PRIME2 = 0xC2B2AE3D27D4EB4FULL; ///< xxHash64 prime 2.
+static const UINT64 PRIME3 = 0x165667B19E3779F9ULL; ///< xxHash64 prime 3.
+static const UINT64 PRIME4 = 0x85EBCA77C2B2AE63ULL; ///< xxHash64 prime 4.
+static const UINT64 PRIME5 = 0x27D4EB2F165667C5ULL; ///< xxHash64 prime 5.
+
+/// Rotate left.
+/// \param x Value to be rotated.
+/// \param r Number of bits.
+/// \return x rotated left by r bits.
+
+static inline UINT64 rotl(UINT64 x, int r){
+  return (x << r) | (x >> (64 - r));
+} //rotl
+
+/// Construct a hash with an optional seed.
+/// \param seed Seed value.
+
+CStateHash::CStateHash(UINT64 seed){
+  m_nAcc = seed + PRIME5;
+} //constructor
+
+/// Mix one 8-byte lane into the accumulator.
+/// \param lane The lane.
+
+void CStateHash::Mix(UINT64 lane){
+  lane *= PRIME2;
+  lane = rotl(lane, 31);
+  lane *= PRIME1;
+  m_nAcc ^= lane;
+  m_nAcc = rotl(m_nAcc, 27)*PRIME1 + PRIME4;
+} //Mix
+
+/// Hash a block of bytes. Whole 8-byte lanes are mixed in directly,
+/// and a short tail is zero-padded into one more lane with its length
+/// folded in so that "ab" and "ab\0" hash differently.
+/// \param p Pointer to the bytes.
+/// \param n Number of bytes.
+
+void CStateHash::Add(const void* p, size_t n){
+  const unsigned char* b = (const unsigned char*)p;
+  m_nLength += n;
+
+  for(; n >= 8; n -= 8, b += 8){ //whole lanes
+    UINT64 lane;
+    memcpy(&lane, b, 8);
+    Mix(lane);
+  } //for
+
+  if(n > 0){ //tail
+    UINT64 lane = 0;
+    memcpy(&lane, b, n);
+    Mix(lane ^ (n*PRIME3));
+  } //if
+} //Add
+
+/// Finish the hash with the xxHash64 avalanche. This does not change
+/// the accumulator, so more values can be added afterwards.
+/// \return The hash value.
+
+UINT64 CStateHash::Get() const{
+  UINT64 h = m_nAcc + m_nLength;
+
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+
+  return h;
+} //Get
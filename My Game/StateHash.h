@@ -0,0 +1,35 @@
+/// \file StateHash.h
+/// \brief Interface for the state hash class CStateHash.
+
+#pragma once
+
+#include "Defines.h"
+
+/// \brief A streaming 64-bit hash of simulation state.
+///
+/// CStateHash is an xxHash64-style hash. Values are fed in one at a
+/// time in a fixed canonical order and the final value is read with
+/// Get(). Floats are hashed by their bit patterns, so two states hash
+/// the same only if they are bit-for-bit identical.
+
+class CStateHash{
+  private:
+    UINT64 m_nAcc = 0; ///< Accumulator.
+    UINT64 m_nLength = 0; ///< Number of bytes hashed.
+
+    void Mix(UINT64 lane); ///< Mix one 8-byte lane into the accumulator.
+
+  public:
+    CStateHash(UINT64 seed=0); ///< Constructor.
+
+    void Add(const void* p, size_t n); ///< Hash a block of bytes.
+
+    /// Hash one value of plain old data.
+    /// \param x Value to be hashed.
+
+    template<class T> void Add(const T& x){
+      Add(&x, sizeof(T));
+    } //Add
+
+    UINT64 Get() const; ///< Get the hash of everything added so far.
+}; //CStateHash
@@ -0,0 +1,75 @@
+/// \file StatePool.h
+/// \brief Interface and code for the component pool CStatePool.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+/// \brief A pool of one kind of optional object state.
+///
+/// State that only a few kinds of object need is kept out of CObject
+/// and handed out from a pool instead, one pool for each kind. The pool
+/// grows a chunk at a time and never moves anything, so the pointers
+/// that it hands out stay good, and the states of one kind sit next to
+/// each other in memory rather than being scattered across the heap.
+/// Released states go on a free list to be handed out again.
+
+template<class T> class CStatePool{
+  private:
+    static const size_t CHUNK = 64; ///< Number of states in a chunk.
+
+    vector<unique_ptr<T[]>> m_vChunks; ///< Storage.
+    vector<T*> m_vFree; ///< States not in use, lowest address last.
+    size_t m_nLive = 0; ///< Number of states in use.
+
+  public:
+    /// Get a state in its initial condition, growing the pool by
+    /// a chunk if there are none free.
+    /// \return Pointer to the state.
+
+    T* Acquire(){
+      if(m_vFree.empty()){
+        m_vChunks.emplace_back(new T[CHUNK]);
+        T* chunk = m_vChunks.back().get();
+
+        for(size_t i=CHUNK; i>0; i--)
+          m_vFree.push_back(chunk + i - 1);
+      } //if
+
+      T* p = m_vFree.back();
+      m_vFree.pop_back();
+      *p = T();
+      m_nLive++;
+
+      return p;
+    } //Acquire
+
+    /// Give a state back to the pool.
+    /// \param p Pointer to the state, or nullptr for none.
+
+    void Release(T* p){
+      if(p == nullptr)return;
+      m_vFree.push_back(p);
+      m_nLive--;
+    } //Release
+
+    /// Reader function for the number of states in use.
+    /// \return Number of states in use.
+
+    size_t GetLive() const{
+      return m_nLive;
+    } //GetLive
+
+    /// Reader function for the memory used by the states, whether
+    /// they are in use or not.
+    /// \return Size in bytes.
+
+    size_t GetBytes() const{
+      return m_vChunks.size()*CHUNK*sizeof(T);
+    } //GetBytes
+}; //CStatePool
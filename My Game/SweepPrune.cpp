@@ -0,0 +1,62 @@
+/// \file SweepPrune.cpp
+/// \brief Code for the sweep and prune sorter CSweepPrune.
+
+#include <algorithm>
+#include <climits>
+
+#include "SweepPrune.h"
+
+/// Bring the sorted order up to date for this tick. An object whose
+/// rank is not less than the number of intervals last tick is taken
+/// to be new. The ranks are then set to each object's place in the
+/// new order, ready for next tick.
+/// \param proxies This tick's intervals, one per object, with m_nIndex
+/// set to the object's index.
+/// \param rank [in, out] Each object's place in the sorted order.
+
+void CSweepPrune::Sort(const vector<SweepProxy>& proxies, vector<UINT>& rank){
+  const UINT n = (UINT)proxies.size();
+  const UINT last = (UINT)m_vProxies.size(); //number of intervals last tick
+  m_vSlots.assign(last, UINT_MAX);
+
+  for(UINT i=0; i<n; i++){ //survivors go back in their old places
+    const UINT r = rank[i];
+    if(r < last)m_vSlots[r] = i;
+  } //for
+
+  m_vProxies.clear();
+
+  for(UINT r=0; r<last; r++)
+    if(m_vSlots[r] != UINT_MAX)
+      m_vProxies.push_back(proxies[m_vSlots[r]]);
+
+  const size_t old = m_vProxies.size(); //number of survivors
+
+  for(UINT i=0; i<n; i++) //new objects on the end
+    if(rank[i] >= last)
+      m_vProxies.push_back(proxies[i]);
+
+  for(size_t k=1; k<old; k++){ //insertion sort of the survivors
+    const SweepProxy x = m_vProxies[k];
+    size_t m = k;
+
+    for(; m > 0 && m_vProxies[m - 1].m_fLo > x.m_fLo; m--)
+      m_vProxies[m] = m_vProxies[m - 1];
+
+    m_vProxies[m] = x;
+  } //for
+
+  auto less = [](const SweepProxy& a, const SweepProxy& b){return a.m_fLo < b.m_fLo;};
+  sort(m_vProxies.begin() + old, m_vProxies.end(), less);
+  inplace_merge(m_vProxies.begin(), m_vProxies.begin() + old, m_vProxies.end(), less);
+
+  for(UINT k=0; k<n; k++) //remember the order for next tick
+    rank[m_vProxies[k].m_nIndex] = k;
+} //Sort
+
+/// Reader function for the intervals.
+/// \return The intervals sorted by their bottom.
+
+const vector<SweepProxy>& CSweepPrune::GetProxies() const{
+  return m_vProxies;
+} //GetProxies
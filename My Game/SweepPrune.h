@@ -0,0 +1,45 @@
+/// \file SweepPrune.h
+/// \brief Interface for the sweep and prune sorter CSweepPrune.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+/// \brief A y-interval in the sweep and prune broad phase.
+
+struct SweepProxy{
+  float m_fLo; ///< Bottom of the y-interval swept this tick.
+  float m_fHi; ///< Top of the y-interval swept this tick.
+  UINT m_nIndex; ///< Index of the object in the broad phase array.
+}; //SweepProxy
+
+/// \brief Sweep and prune on y.
+///
+/// Almost everything in this game moves up or down, so the broad phase
+/// keeps the objects' swept y-intervals sorted by their bottom, and
+/// each interval only needs to be tested against those after it that
+/// start below its top. Each object remembers its place in the sorted
+/// order from last tick, its rank, so the survivors can be put back
+/// in that order in a single pass. Objects only move a few pixels per
+/// tick, so that order is very nearly sorted by the new intervals and
+/// an insertion sort finishes it in close to linear time. Objects that
+/// are new this tick are sorted on their own and merged in.
+///
+/// CSweepPrune does not know about objects, so that it can be timed
+/// on its own by Tools/sweep/bench.cpp. The caller makes the intervals
+/// and keeps the ranks.
+
+class CSweepPrune{
+  private:
+    vector<SweepProxy> m_vProxies; ///< Intervals sorted by their bottom.
+    vector<UINT> m_vSlots; ///< Survivors by their old rank while re-sorting.
+
+  public:
+    void Sort(const vector<SweepProxy>& proxies, vector<UINT>& rank); ///< Sort this tick's intervals.
+
+    const vector<SweepProxy>& GetProxies() const; ///< Intervals in sorted order.
+}; //CSweepPrune
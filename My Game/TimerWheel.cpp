@@ -0,0 +1,206 @@
+/// \file TimerWheel.cpp
+/// \brief Code for the hierarchical timer wheel CTimerWheel.
+
+#include <algorithm>
+
+#include "TimerWheel.h"
+#include "Object.h"
+
+/// Put a timer into the lowest wheel that reaches its tick. A timer
+/// that is overdue goes off on the next tick, and one that is further
+/// off than the top wheel reaches goes into the top wheel and is put
+/// back each time that its slot comes round, until it is close enough.
+/// \param t The timer.
+
+void CTimerWheel::Insert(const Timer& t){
+  const UINT due = max(t.m_nDue, m_nNow);
+  const UINT delta = due - m_nNow;
+
+  UINT level = 0;
+
+  while(level < LEVELS - 1 && delta >= 1U << (SLOT_BITS*(level + 1)))
+    level++;
+
+  const UINT slot = (due >> (SLOT_BITS*level)) & (SLOTS - 1);
+  m_vSlot[level][slot].push_back({due, t.m_pObject, t.m_nEvent, t.m_nOrder});
+} //Insert
+
+/// Empty the slot of a wheel that has just come due into the wheels
+/// below it.
+/// \param level Wheel number, more than 0.
+
+void CTimerWheel::Cascade(UINT level){
+  if(level < LEVELS - 1 && ((m_nNow >> (SLOT_BITS*level)) & (SLOTS - 1)) == 0)
+    Cascade(level + 1); //wheel above comes round first
+
+  vector<Timer>& slot = m_vSlot[level][(m_nNow >> (SLOT_BITS*level)) & (SLOTS - 1)];
+  m_vCascade.swap(slot);
+
+  for(auto const& t: m_vCascade)
+    Insert(t);
+
+  m_vCascade.clear();
+} //Cascade
+
+/// Remove all timers and set the clock.
+/// \param now The next tick to be done.
+
+void CTimerWheel::Reset(UINT now){
+  for(auto& wheel: m_vSlot)
+    for(auto& slot: wheel)
+      slot.clear();
+
+  m_vFired.clear();
+  m_nNow = now;
+  m_nCount = 0;
+} //Reset
+
+/// Set a timer.
+/// \param p Object that it belongs to.
+/// \param e What happens when it goes off.
+/// \param due Tick that it goes off on. If that has already been done, it goes off on the next one.
+
+void CTimerWheel::Schedule(CObject* p, eTimerEvent e, UINT due){
+  Insert({due, p, e, m_nCount++});
+} //Schedule
+
+/// Do each tick up to and including a given one, and collect the
+/// timers that go off. Timers set while handling them go off later.
+/// A timer that came down from a higher wheel can end up in a slot
+/// behind one that was set after it, so each tick's timers are sorted
+/// back into the order they were set.
+/// \param now Last tick to be done.
+/// \return Timers that went off, in order.
+
+const vector<CTimerWheel::Timer>& CTimerWheel::Advance(UINT now){
+  m_vFired.clear();
+
+  for(; m_nNow<=now; m_nNow++){
+    if((m_nNow & (SLOTS - 1)) == 0) //bottom wheel has come round
+      Cascade(1);
+
+    vector<Timer>& slot = m_vSlot[0][m_nNow & (SLOTS - 1)];
+    sort(slot.begin(), slot.end(), [](const Timer& a, const Timer& b){return a.m_nOrder < b.m_nOrder;});
+    m_vFired.insert(m_vFired.end(), slot.begin(), slot.end());
+    slot.clear();
+  } //for
+
+  return m_vFired;
+} //Advance
+
+/// Remove the timers of objects that have died.
+
+void CTimerWheel::DropDead(){
+  for(auto& wheel: m_vSlot)
+    for(auto& slot: wheel)
+      slot.erase(remove_if(slot.begin(), slot.end(),
+        [](const Timer& t){return t.m_pObject->IsDead();}), slot.end());
+} //DropDead
+
+/// Reader function for the number of timers.
+/// \return Number of timers set.
+
+UINT CTimerWheel::GetSize() const{
+  UINT n = 0;
+
+  for(auto const& wheel: m_vSlot)
+    for(auto const& slot: wheel)
+      n += (UINT)slot.size();
+
+  return n;
+} //GetSize
+
+/// Get the objects that the timers belong to, wheel by wheel and
+/// slot by slot, the same order that they are saved in.
+/// \param objects [out] Objects.
+
+void CTimerWheel::GetObjects(vector<CObject*>& objects) const{
+  objects.clear();
+
+  for(auto const& wheel: m_vSlot)
+    for(auto const& slot: wheel)
+      for(auto const& t: slot)
+        objects.push_back(t.m_pObject);
+} //GetObjects
+
+/// Set the objects that the timers belong to, for reconnecting timers
+/// after a load.
+/// \param objects Objects, in the order given by GetObjects().
+
+void CTimerWheel::SetObjects(const vector<CObject*>& objects){
+  UINT i = 0;
+
+  for(auto& wheel: m_vSlot)
+    for(auto& slot: wheel)
+      for(auto& t: slot)
+        t.m_pObject = objects[i++];
+} //SetObjects
+
+/// Hash the timers. Their objects are left to the object manager,
+/// since they are pointers.
+/// \param hash The hash.
+
+void CTimerWheel::Hash(CStateHash& hash) const{
+  hash.Add(m_nNow);
+  hash.Add(m_nCount);
+
+  for(auto const& wheel: m_vSlot)
+    for(auto const& slot: wheel){
+      hash.Add((UINT)slot.size());
+
+      for(auto const& t: slot){
+        hash.Add(t.m_nDue);
+        hash.Add(t.m_nEvent);
+        hash.Add(t.m_nOrder);
+      } //for
+    } //for
+} //Hash
+
+/// Save the timers slot by slot, so that loading them puts
+/// each one back exactly where it was. Their objects are left
+/// to the object manager, since they are pointers.
+/// \param s The snapshot.
+
+void CTimerWheel::Save(CSnapshot& s) const{
+  s.Write(m_nNow);
+  s.Write(m_nCount);
+
+  for(auto const& wheel: m_vSlot)
+    for(auto const& slot: wheel){
+      s.Write((UINT)slot.size());
+
+      for(auto const& t: slot){
+        s.Write(t.m_nDue);
+        s.Write(t.m_nEvent);
+        s.Write(t.m_nOrder);
+      } //for
+    } //for
+} //Save
+
+/// Load the timers. Their objects are all nullptr until the
+/// object manager sets them.
+/// \param s The snapshot.
+/// \return false if a slot holds more timers than the snapshot has data for, or an unknown event.
+
+bool CTimerWheel::Load(CSnapshot& s){
+  s.Read(m_nNow);
+  s.Read(m_nCount);
+  m_vFired.clear();
+
+  for(auto& wheel: m_vSlot)
+    for(auto& slot: wheel){
+      UINT n = 0;
+      s.Read(n);
+      if(n > s.GetRemaining()/(2*sizeof(UINT) + sizeof(eTimerEvent)))return false; //more timers than there is data for
+      slot.assign(n, {0, nullptr, GUN_TIMER, 0});
+
+      for(auto& t: slot){
+        s.Read(t.m_nDue);
+        s.Read(t.m_nEvent);
+        s.Read(t.m_nOrder);
+        if(t.m_nEvent < GUN_TIMER || t.m_nEvent > CHANGE_COLOR_TIMER)return false;
+      } //for
+    } //for
+
+  return true;
+} //Load
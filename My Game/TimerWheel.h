@@ -0,0 +1,84 @@
+/// \file TimerWheel.h
+/// \brief Interface for the hierarchical timer wheel CTimerWheel.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "StateHash.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+class CObject;
+
+/// \brief What happens when a timer goes off.
+
+enum eTimerEvent{
+  GUN_TIMER, ///< Gun has cooled down and can fire again.
+  LIFE_TIMER, ///< Object's time is up and it dies.
+  CARD_TIMER, ///< Boss can deal cards again.
+  FORCE_FIELD_TIMER, ///< Boss can put its force field up again.
+  BLACK_HOLE_TIMER, ///< Boss can open a black hole again.
+  CHANGE_COLOR_TIMER ///< Boss changes the players' colors.
+}; //eTimerEvent
+
+/// \brief A hierarchical timer wheel.
+///
+/// Cooldowns and lifetimes are timers that go off on a given simulation
+/// tick, so that nothing has to compare the clock against a timer every
+/// tick for every object. The lowest wheel has a slot for each of the
+/// next SLOTS ticks. Each wheel above it has a slot for each SLOTS
+/// slots of the wheel below, so three wheels of 64 slots cover over an
+/// hour. A timer goes into the lowest wheel that reaches its tick.
+/// Each time a wheel comes round, the slot of the wheel above that has
+/// just come due is emptied into the wheels below. Setting a timer
+/// and advancing the clock cost the same however many timers there
+/// are, and each tick only touches the timers that go off.
+///
+/// Timers that go off on the same tick go off in the order they were
+/// set, whichever wheels they came down through, so the simulation
+/// stays deterministic. The object manager
+/// must call DropDead() before it deletes an object that has timers,
+/// and Reset() when it deletes all of them.
+
+class CTimerWheel{
+  public:
+    static const UINT LEVELS = 3; ///< Number of wheels.
+    static const UINT SLOT_BITS = 6; ///< Log base 2 of the number of slots in a wheel.
+    static const UINT SLOTS = 1 << SLOT_BITS; ///< Number of slots in a wheel.
+
+    /// \brief A timer.
+
+    struct Timer{
+      UINT m_nDue; ///< Tick that it goes off on.
+      CObject* m_pObject; ///< Object that it belongs to.
+      eTimerEvent m_nEvent; ///< What happens when it goes off.
+      UINT m_nOrder; ///< Number of timers set before it.
+    }; //Timer
+
+  private:
+    vector<Timer> m_vSlot[LEVELS][SLOTS]; ///< Timers in each slot of each wheel.
+    vector<Timer> m_vFired; ///< Timers that went off on the last Advance().
+    vector<Timer> m_vCascade; ///< Timers being moved down from a slot.
+    UINT m_nNow = 0; ///< Next tick to be done.
+    UINT m_nCount = 0; ///< Number of timers set so far.
+
+    void Insert(const Timer& t); ///< Put a timer into the right slot.
+    void Cascade(UINT level); ///< Move the current slot of a wheel down.
+
+  public:
+    void Reset(UINT now); ///< Remove all timers and set the clock.
+    void Schedule(CObject* p, eTimerEvent e, UINT due); ///< Set a timer.
+    const vector<Timer>& Advance(UINT now); ///< Advance the clock.
+    void DropDead(); ///< Remove timers of dead objects.
+
+    UINT GetSize() const; ///< Number of timers.
+    void GetObjects(vector<CObject*>& objects) const; ///< Objects of the timers.
+    void SetObjects(const vector<CObject*>& objects); ///< Set the objects of the timers.
+
+    void Hash(CStateHash& hash) const; ///< Hash timer state.
+    void Save(CSnapshot& s) const; ///< Save timer state, not including objects.
+    bool Load(CSnapshot& s); ///< Load timer state, not including objects.
+}; //CTimerWheel
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Build the pixel collision masks from the sprite art.
+
+Reads the sprite list in Media/XML/gamesettings.xml, decodes the alpha
+channel of every frame of the collidable sprites, and writes packed
+1-bit masks at reduced resolution to Media/Masks/masks.bin, which
+CMaskSet loads at startup. Run it from the top of the repository
+whenever the art for one of those sprites changes:
+
+    python3 Tools/make_masks.py
+
+File layout, all little endian:
+
+    char[4] "UMSK"
+    u32     version
+    u32     scale       pixels per mask bit, across and down
+    u32     sprites
+    per sprite:
+      u8    name length, then the name
+      u32   frames
+      per frame:
+        u16 width, height        in pixels
+        u16 columns, rows        in mask bits
+        u32 offset               first word of the mask in the arena
+    u32     words
+    u64     arena[words]
+
+Each mask row starts on a fresh 64-bit word, with the leftmost column
+in the low bit of the first word, and rows go from the top of the
+image down.
+"""
+
+import os
+import struct
+import sys
+import xml.etree.ElementTree as ET
+import zlib
+
+VERSION = 1
+SCALE = 2  # pixels per mask bit, across and down
+THRESHOLD = 128  # alpha at or above this is solid
+
+# Sprites that collide, by their name in gamesettings.xml.
+SPRITES = [
+    "BLUE_SHIP", "RED_SHIP",
+    "RED_LIGHT_ENEMY", "BLUE_LIGHT_ENEMY",
+    "RED_HEAVY_ENEMY", "BLUE_HEAVY_ENEMY",
+    "HOTSHOT", "LILBOY", "BLACK_JACK",
+    "bullet2", "BLUE_BULLET", "FIREBALL",
+]
+
+SETTINGS = os.path.join("Media", "XML", "gamesettings.xml")
+OUTPUT = os.path.join("Media", "Masks", "masks.bin")
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_alpha(path):
+    """Decode a non-interlaced PNG and return (width, height, rows of alpha)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(path + ": not a PNG")
+
+    pos, idat, trns = 8, [], None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat.append(body)
+        elif kind == b"IEND":
+            break
+
+    if interlace:
+        raise ValueError(path + ": interlaced PNGs are not supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    bpp = max(1, channels*depth//8)  # bytes per pixel for unfiltering
+    stride = (width*channels*depth + 7)//8
+    raw = zlib.decompress(b"".join(idat))
+
+    rows, prev = [], bytearray(stride)
+    for y in range(height):
+        start = y*(stride + 1)
+        kind, line = raw[start], bytearray(raw[start + 1:start + 1 + stride])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 255
+            elif kind == 2:
+                line[i] = (line[i] + prev[i]) & 255
+            elif kind == 3:
+                line[i] = (line[i] + ((a + prev[i]) >> 1)) & 255
+            elif kind == 4:
+                c = prev[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + paeth(a, prev[i], c)) & 255
+        rows.append(line)
+        prev = line
+
+    alpha = []
+    for line in rows:
+        if depth < 8:  # palette or gray packed several to a byte
+            per, mask = 8//depth, (1 << depth) - 1
+            samples = [(line[x//per] >> (8 - depth*(x % per + 1))) & mask for x in range(width)]
+        elif depth == 16:
+            samples = [line[2*i] for i in range(width*channels)]  # high bytes are enough
+        else:
+            samples = line
+
+        if ctype == 6:
+            alpha.append([samples[4*x + 3] for x in range(width)])
+        elif ctype == 4:
+            alpha.append([samples[2*x + 1] for x in range(width)])
+        elif ctype == 3:
+            alpha.append([trns[i] if trns and i < len(trns) else 255 for i in samples[:width]])
+        elif ctype == 2:
+            key = struct.unpack(">HHH", trns) if trns else None
+            alpha.append([0 if key and tuple(samples[3*x:3*x + 3]) == key else 255 for x in range(width)])
+        else:
+            key = struct.unpack(">H", trns)[0] if trns else None
+            alpha.append([0 if samples[x] == key else 255 for x in range(width)])
+
+    return width, height, alpha
+
+
+def make_mask(width, height, alpha):
+    """Pack the alpha into mask rows. A bit is set if any pixel under it is solid."""
+    cols, rows = (width + SCALE - 1)//SCALE, (height + SCALE - 1)//SCALE
+    words = (cols + 63)//64
+    out = []
+    for r in range(rows):
+        row = [0]*words
+        for y in range(r*SCALE, min(height, (r + 1)*SCALE)):
+            for x in range(width):
+                if alpha[y][x] >= THRESHOLD:
+                    c = x//SCALE
+                    row[c >> 6] |= 1 << (c & 63)
+        out.extend(row)
+    return cols, rows, out
+
+
+def frame_files(sprite, path):
+    """List a sprite's frame files. Windows file names ignore case, and
+    the settings file counts on that, so match them the same way."""
+    actual = {f.lower(): f for f in os.listdir(path)}
+    name = sprite.get("file")
+    frames = sprite.get("frames")
+    if frames is None:
+        names = [name]
+    else:
+        ext = sprite.get("ext").strip()
+        names = ["%s%d.%s" % (name, i, ext) for i in range(int(frames))]
+    return [os.path.join(path, actual.get(n.lower(), n)) for n in names]
+
+
+def main():
+    root = ET.parse(SETTINGS).getroot()
+    sprites = root.find("sprites")
+    path = sprites.get("path").replace("\\", os.sep)
+    table = {s.get("name"): s for s in sprites.findall("sprite")}
+
+    header, arena = bytearray(), []
+    header += b"UMSK" + struct.pack("<III", VERSION, SCALE, len(SPRITES))
+
+    for name in SPRITES:
+        files = frame_files(table[name], path)
+        header += struct.pack("<B", len(name)) + name.encode("ascii")
+        header += struct.pack("<I", len(files))
+        for f in files:
+            width, height, alpha = read_alpha(f)
+            cols, rows, words = make_mask(width, height, alpha)
+            header += struct.pack("<HHHHI", width, height, cols, rows, len(arena))
+            arena.extend(words)
+
+    os.makedirs(os.path.dirname(OUTPUT), exist_ok=True)
+    with open(OUTPUT, "wb") as f:
+        f.write(header)
+        f.write(struct.pack("<I", len(arena)))
+        f.write(struct.pack("<%dQ" % len(arena), *arena))
+
+    print("%s: %d sprites, %d words" % (OUTPUT, len(SPRITES), len(arena)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
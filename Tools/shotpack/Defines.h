@@ -0,0 +1,21 @@
+/// \file Defines.h
+/// \brief Stand-in for the engine's Defines.h, so that CShotPack can be
+/// built on its own by the test and the benchmark in this folder, and
+/// CSweepPrune by the benchmark in Tools/sweep.
+
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t UINT; ///< Unsigned int, as in the engine.
+typedef uint64_t UINT64; ///< Unsigned 64-bit int, as in the engine.
+
+/// \brief The parts of SimpleMath's Vector2 that CShotPack uses.
+
+struct Vector2{
+  float x = 0.0f; ///< x coordinate.
+  float y = 0.0f; ///< y coordinate.
+
+  Vector2() = default; ///< Constructor.
+  Vector2(float a, float b): x(a), y(b){} ///< Constructor.
+}; //Vector2
@@ -0,0 +1,147 @@
+/// \file bench.cpp
+/// \brief Time CShotPack's SSE2 and AVX2 paths against a scalar swept circle test.
+///
+/// Packs a screenful of enemy shots and tests two ships against all of
+/// them, as QueryShots does each tick, many times over. The scalar loop
+/// is the test that CObjectManager::Sweep does for one pair, run over
+/// the same arrays. Build and run it from the top of the repository with
+///
+///     g++ -std=c++17 -O2 -ffp-contract=off -I Tools/shotpack -I "My Game" "My Game/ShotPack.cpp" Tools/shotpack/bench.cpp -o shotpack_bench
+///     ./shotpack_bench
+///
+/// It prints the time per shot tested for each path.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "ShotPack.h"
+
+static const UINT SHOTS = 4096; ///< Shots on screen.
+static const int TICKS = 2000; ///< Ticks to time.
+
+/// \brief Shots in plain arrays, for the scalar loop.
+
+struct Shots{
+  std::vector<float> m_vX, m_vY, m_vDX, m_vDY, m_vR; ///< Start position, motion and radius.
+}; //Shots
+
+/// Test a ship against every shot one at a time.
+/// \param s Shots.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \return Number of hits plus near misses, so that the work is not optimized away.
+
+static UINT Scalar(const Shots& s, const Vector2& pos, const Vector2& d, float r, float margin){
+  UINT n = 0;
+
+  for(size_t i=0; i<s.m_vX.size(); i++){
+    const float px = s.m_vX[i] - pos.x, py = s.m_vY[i] - pos.y;
+    const float vx = s.m_vDX[i] - d.x, vy = s.m_vDY[i] - d.y;
+    const float rr = s.m_vR[i] + r;
+    const float c = px*px + py*py - rr*rr;
+    const float a = vx*vx + vy*vy;
+    const float b = px*vx + py*vy;
+
+    const float rg = rr + margin;
+    const float cg = px*px + py*py - rg*rg;
+    const bool closing = a > 0.0f && b < 0.0f;
+
+    bool hit = c <= 0.0f; //touching at the start
+    bool nearby = cg <= 0.0f;
+
+    if(closing && !hit){
+      const float disc = b*b - a*c;
+      hit = disc >= 0.0f && (-b - sqrtf(disc))/a <= 1.0f;
+    } //if
+
+    if(closing && !nearby){
+      const float discg = b*b - a*cg;
+      nearby = discg >= 0.0f && (-b - sqrtf(discg))/a <= 1.0f;
+    } //if
+
+    n += hit + nearby;
+  } //for
+
+  return n;
+} //Scalar
+
+/// Test a ship against every block of a pack.
+/// \param pack Packed shots.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \return Number of hits plus near misses, so that the work is not optimized away.
+
+static UINT Packed(const CShotPack& pack, const Vector2& pos, const Vector2& d, float r, float margin){
+  UINT n = 0;
+  float t[CShotPack::BLOCK];
+
+  for(UINT block=0; block<pack.GetNumBlocks(); block++){
+    UINT nearby = 0;
+    const UINT hit = pack.Test(block, pos, d, r, margin, t, nearby);
+    n += __builtin_popcount(hit) + __builtin_popcount(nearby);
+  } //for
+
+  return n;
+} //Packed
+
+/// Time a test over all of the ticks.
+/// \param name Name to print.
+/// \param test The test, for one ship.
+/// \return Number of hits plus near misses over all ticks.
+
+template<class F> static UINT Time(const char* name, F test){
+  const Vector2 ship1(400.0f, 300.0f), ship2(620.0f, 320.0f);
+  const Vector2 d1(2.0f, 1.0f), d2(-1.5f, 0.5f);
+  UINT n = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for(int tick=0; tick<TICKS; tick++){
+    n += test(ship1, d1);
+    n += test(ship2, d2);
+  } //for
+
+  const std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+  printf("%-7s %6.3f ns per shot tested (%u hits and near misses)\n", name, ns.count()/(2.0*TICKS*SHOTS), n);
+  return n;
+} //Time
+
+int main(){
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> x(0.0f, 1024.0f), y(0.0f, 768.0f), move(-8.0f, 8.0f), size(3.0f, 16.0f);
+
+  Shots shots;
+  CShotPack pack;
+
+  for(UINT i=0; i<SHOTS; i++){
+    const Vector2 pos(x(rng), y(rng)), d(move(rng), move(rng));
+    const float r = size(rng);
+
+    shots.m_vX.push_back(pos.x); shots.m_vY.push_back(pos.y);
+    shots.m_vDX.push_back(d.x); shots.m_vDY.push_back(d.y);
+    shots.m_vR.push_back(r);
+    pack.Add(pos, d, r, 'r', true, false);
+  } //for
+
+  pack.Pad();
+
+  const float r = 20.0f, margin = 24.0f;
+
+  Time("scalar", [&](const Vector2& pos, const Vector2& d){return Scalar(shots, pos, d, r, margin);});
+
+  CShotPack::UseAVX2(false);
+  Time("SSE2", [&](const Vector2& pos, const Vector2& d){return Packed(pack, pos, d, r, margin);});
+
+  if(CShotPack::UseAVX2(true))
+    Time("AVX2", [&](const Vector2& pos, const Vector2& d){return Packed(pack, pos, d, r, margin);});
+  else printf("AVX2    not available\n");
+
+  return 0;
+} //main
@@ -0,0 +1,168 @@
+/// \file test.cpp
+/// \brief Check that CShotPack's SIMD paths agree with a scalar swept circle test.
+///
+/// The SSE2 and AVX2 paths of CShotPack::Test must give exactly the same
+/// hits, near misses and times of impact as each other, since players on
+/// different processors have to stay in sync, and as the plain scalar
+/// test that they stand for. This packs random shots around random ships,
+/// along with the awkward cases (shots that do not move relative to the
+/// ship, shots just touching it, padding), and compares all three.
+/// Build and run it from the top of the repository with
+///
+///     g++ -std=c++17 -O2 -ffp-contract=off -I Tools/shotpack -I "My Game" "My Game/ShotPack.cpp" Tools/shotpack/test.cpp -o shotpack_test
+///     ./shotpack_test
+///
+/// It prints the number of mismatches and exits with 1 if there are any.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ShotPack.h"
+
+/// \brief A shot, as it goes into the pack.
+
+struct Shot{
+  Vector2 m_vPos; ///< Center at the start of the tick.
+  Vector2 m_vMove; ///< Motion over the tick.
+  float m_fRadius; ///< Radius.
+}; //Shot
+
+/// The swept circle test for one shot, written out one operation at a
+/// time in the same order as the SIMD lanes do it.
+/// \param s The shot.
+/// \param pos Ship's center at the start of the tick.
+/// \param d Ship's motion over the tick.
+/// \param r Ship's radius.
+/// \param margin How close a shot must pass to be a near miss.
+/// \param t [out] Time of impact, if it hits.
+/// \param nearby [out] true if the shot comes within the margin.
+/// \return true if the shot hits the ship.
+
+static bool Scalar(const Shot& s, const Vector2& pos, const Vector2& d, float r, float margin, float& t, bool& nearby){
+  const float px = s.m_vPos.x - pos.x, py = s.m_vPos.y - pos.y; //relative position
+  const float vx = s.m_vMove.x - d.x, vy = s.m_vMove.y - d.y; //relative motion
+  const float rr = s.m_fRadius + r; //sum of radii
+
+  const float c = (px*px + py*py) - rr*rr;
+  const float a = vx*vx + vy*vy;
+  const float b = px*vx + py*vy;
+  const float disc = b*b - a*c;
+  const float toi = ((0.0f - b) - sqrtf(disc > 0.0f? disc: 0.0f))/a;
+
+  const bool touching = c <= 0.0f;
+  const bool closing = a > 0.0f && b < 0.0f;
+  const bool hit = touching || (closing && disc >= 0.0f && toi <= 1.0f);
+
+  const float rg = rr + margin; //grown sum of radii
+  const float cg = (px*px + py*py) - rg*rg;
+  const float discg = b*b - a*cg;
+  const float toig = ((0.0f - b) - sqrtf(discg > 0.0f? discg: 0.0f))/a;
+  nearby = cg <= 0.0f || (closing && discg >= 0.0f && toig <= 1.0f);
+
+  t = touching? 0.0f: toi;
+  return hit;
+} //Scalar
+
+int main(){
+  const float margin = 24.0f; //as GRAZE_MARGIN
+  const int ships = 2000; //ships tested, each against its own shots
+  const UINT count = 61; //shots per ship, not a whole number of blocks
+
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> near(-120.0f, 120.0f), move(-30.0f, 30.0f), size(3.0f, 16.0f);
+
+  const bool avx2 = CShotPack::UseAVX2(true);
+  printf("AVX2 %s\n", avx2? "available, comparing both paths": "not available, SSE2 only");
+
+  int mismatches = 0, hits = 0, grazes = 0;
+  std::vector<Shot> shots(count);
+  CShotPack pack;
+
+  for(int n=0; n<ships; n++){
+    const Vector2 pos(near(rng) + 512.0f, near(rng) + 384.0f);
+    const Vector2 d(move(rng), move(rng));
+    const float r = 20.0f;
+
+    for(UINT i=0; i<count; i++){
+      Shot& s = shots[i];
+      s.m_vPos = Vector2(pos.x + near(rng), pos.y + near(rng));
+      s.m_vMove = Vector2(move(rng), move(rng));
+      s.m_fRadius = size(rng);
+    } //for
+
+    shots[0].m_vMove = d; //not moving relative to the ship
+    shots[1].m_vPos = Vector2(pos.x + 30.0f, pos.y); //touching at the start
+    shots[1].m_fRadius = 10.0f;
+    shots[2].m_vPos = Vector2(pos.x + 64.0f, pos.y); //just inside the margin, not moving
+    shots[2].m_vMove = d;
+    shots[2].m_fRadius = 20.0f;
+
+    pack.Clear();
+
+    for(auto const& s: shots)
+      pack.Add(s.m_vPos, s.m_vMove, s.m_fRadius, 'r', true, false);
+
+    pack.Pad();
+
+    for(UINT block=0; block<pack.GetNumBlocks(); block++){
+      float t4[CShotPack::BLOCK], t8[CShotPack::BLOCK];
+      UINT near4 = 0, near8 = 0;
+
+      CShotPack::UseAVX2(false);
+      const UINT hit4 = pack.Test(block, pos, d, r, margin, t4, near4);
+
+      UINT hit8 = hit4;
+      near8 = near4;
+      memcpy(t8, t4, sizeof(t4));
+
+      if(avx2){
+        CShotPack::UseAVX2(true);
+        hit8 = pack.Test(block, pos, d, r, margin, t8, near8);
+      } //if
+
+      if(hit4 != hit8 || near4 != near8){
+        printf("ship %d block %u: SSE2 hits %02x near %02x, AVX2 hits %02x near %02x\n",
+          n, block, hit4, near4, hit8, near8);
+        mismatches++;
+      } //if
+
+      for(UINT lane=0; lane<CShotPack::BLOCK; lane++){
+        const UINT i = block*CShotPack::BLOCK + lane;
+        const UINT bit = 1 << lane;
+
+        if(i >= count){ //padding never hits
+          if((hit4 | near4) & bit){
+            printf("ship %d: padding lane %u hit\n", n, lane);
+            mismatches++;
+          } //if
+
+          continue;
+        } //if
+
+        float t = 0.0f;
+        bool nearby = false;
+        const bool hit = Scalar(shots[i], pos, d, r, margin, t, nearby);
+
+        if(hit != ((hit4 & bit) != 0) || nearby != ((near4 & bit) != 0)){
+          printf("ship %d shot %u: scalar hit %d near %d, SIMD hit %d near %d\n",
+            n, i, hit, nearby, (hit4 & bit) != 0, (near4 & bit) != 0);
+          mismatches++;
+        } //if
+
+        else if(hit && (memcmp(&t, &t4[lane], sizeof(float)) || memcmp(&t, &t8[lane], sizeof(float)))){
+          printf("ship %d shot %u: scalar time %.9g, SSE2 %.9g, AVX2 %.9g\n", n, i, t, t4[lane], t8[lane]);
+          mismatches++;
+        } //else if
+
+        hits += hit;
+        grazes += nearby;
+      } //for
+    } //for
+  } //for
+
+  printf("%d shots, %d hits, %d near misses, %d mismatches\n", ships*(int)count, hits, grazes, mismatches);
+  return mismatches > 0? 1: 0;
+} //main
@@ -0,0 +1,241 @@
+/// \file bench.cpp
+/// \brief Time CSweepPrune against the all-pairs search that it replaced.
+///
+/// Moves a crowd of circles up and down the screen for a number of
+/// ticks, killing a few and adding new ones each tick as the game does,
+/// and finds the pairs whose swept boxes overlap three ways: testing
+/// all pairs, as the broad phase did before sweep and prune, sorting
+/// from scratch each tick, and sorting with CSweepPrune, which starts
+/// from last tick's order. All three must find the same number of
+/// pairs. Build and run it from the top of the repository with
+///
+///     g++ -std=c++17 -O2 -I Tools/shotpack -I "My Game" "My Game/SweepPrune.cpp" Tools/sweep/bench.cpp -o sweep_bench
+///     ./sweep_bench
+///
+/// It prints the time per tick for each way and each crowd size.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "SweepPrune.h"
+
+static const int TICKS = 600; ///< Ticks to time, 10 seconds at 60Hz.
+static const float WIDTH = 1024.0f; ///< Width of the screen.
+static const float HEIGHT = 768.0f; ///< Height of the screen.
+static const float TURNOVER = 0.02f; ///< Fraction of the circles replaced each tick.
+
+/// \brief A moving circle.
+
+struct Circle{
+  float m_fX; ///< Center x.
+  float m_fY; ///< Center y now.
+  float m_fOldY; ///< Center y at the start of the tick.
+  float m_fSpeed; ///< Motion in y per tick.
+  float m_fR; ///< Radius.
+  UINT m_nRank; ///< Place in CSweepPrune's order last tick.
+}; //Circle
+
+/// \brief A crowd of circles, moved the same way for each method.
+
+class Crowd{
+  private:
+    std::mt19937 m_cRng; ///< Random numbers.
+    std::uniform_real_distribution<float> m_cX, m_cY, m_cSpeed, m_cR, m_cOne; ///< Distributions.
+
+    /// Make a new circle somewhere on the screen.
+    /// \return The circle.
+
+    Circle Make(){
+      const float y = m_cY(m_cRng);
+      return {m_cX(m_cRng), y, y, m_cSpeed(m_cRng), m_cR(m_cRng), UINT_MAX};
+    } //Make
+
+  public:
+    std::vector<Circle> m_vCircles; ///< The circles, in object list order.
+
+    /// Constructor.
+    /// \param n Number of circles.
+
+    Crowd(UINT n): m_cRng(1), m_cX(0.0f, WIDTH), m_cY(0.0f, HEIGHT),
+      m_cSpeed(-8.0f, 8.0f), m_cR(4.0f, 24.0f), m_cOne(0.0f, 1.0f)
+    {
+      for(UINT i=0; i<n; i++)
+        m_vCircles.push_back(Make());
+    } //constructor
+
+    /// Move everything one tick. Circles die when they leave the top
+    /// or bottom of the screen, a few others die anyway, and all of them
+    /// are replaced by new ones on the end of the list.
+
+    void Move(){
+      std::vector<Circle> next;
+
+      for(auto c: m_vCircles){
+        if(m_cOne(m_cRng) < TURNOVER)continue; //dead
+
+        c.m_fOldY = c.m_fY;
+        c.m_fY += c.m_fSpeed;
+
+        if(c.m_fY < 0.0f || c.m_fY > HEIGHT)continue; //off the screen
+        next.push_back(c);
+      } //for
+
+      while(next.size() < m_vCircles.size())
+        next.push_back(Make());
+
+      m_vCircles.swap(next);
+    } //Move
+
+    /// Swept y-interval of a circle.
+    /// \param i Index of the circle.
+    /// \return The interval.
+
+    SweepProxy Proxy(UINT i) const{
+      const Circle& c = m_vCircles[i];
+      return {std::min(c.m_fOldY, c.m_fY) - c.m_fR, std::max(c.m_fOldY, c.m_fY) + c.m_fR, i};
+    } //Proxy
+
+    /// Whether two circles' swept boxes overlap in x, which is all that
+    /// is left to check once their y-intervals overlap.
+    /// \param i Index of a circle.
+    /// \param j Index of another circle.
+    /// \return true if they overlap.
+
+    bool OverlapX(UINT i, UINT j) const{
+      const Circle& a = m_vCircles[i];
+      const Circle& b = m_vCircles[j];
+      const float dx = a.m_fX - b.m_fX, r = a.m_fR + b.m_fR;
+      return -r <= dx && dx <= r;
+    } //OverlapX
+}; //Crowd
+
+/// Count overlapping pairs in intervals sorted by their bottom.
+/// \param crowd The circles.
+/// \param n Number of circles.
+/// \param sorted Their intervals, sorted.
+/// \return Number of overlapping pairs.
+
+static UINT Sweep(const Crowd& crowd, UINT n, const std::vector<SweepProxy>& sorted){
+  UINT pairs = 0;
+
+  for(UINT k=0; k<n; k++){
+    const SweepProxy& a = sorted[k];
+
+    for(UINT m=k + 1; m<n && sorted[m].m_fLo <= a.m_fHi; m++)
+      pairs += crowd.OverlapX(a.m_nIndex, sorted[m].m_nIndex);
+  } //for
+
+  return pairs;
+} //Sweep
+
+/// Test every pair.
+/// \param crowd The circles.
+/// \return Number of overlapping pairs.
+
+static UINT AllPairs(Crowd& crowd){
+  const UINT n = (UINT)crowd.m_vCircles.size();
+  UINT pairs = 0;
+
+  for(UINT i=0; i<n; i++){
+    const SweepProxy a = crowd.Proxy(i);
+
+    for(UINT j=i + 1; j<n; j++){
+      const SweepProxy b = crowd.Proxy(j);
+      pairs += a.m_fLo <= b.m_fHi && b.m_fLo <= a.m_fHi && crowd.OverlapX(i, j);
+    } //for
+  } //for
+
+  return pairs;
+} //AllPairs
+
+/// Sort from scratch, then sweep.
+/// \param crowd The circles.
+/// \param proxies Scratch space for the intervals.
+/// \return Number of overlapping pairs.
+
+static UINT FullSort(Crowd& crowd, std::vector<SweepProxy>& proxies){
+  const UINT n = (UINT)crowd.m_vCircles.size();
+  proxies.clear();
+
+  for(UINT i=0; i<n; i++)
+    proxies.push_back(crowd.Proxy(i));
+
+  std::sort(proxies.begin(), proxies.end(),
+    [](const SweepProxy& a, const SweepProxy& b){return a.m_fLo < b.m_fLo;});
+
+  return Sweep(crowd, n, proxies);
+} //FullSort
+
+/// Sort with CSweepPrune, starting from last tick's order, then sweep.
+/// \param crowd The circles.
+/// \param sweep The sorter, which keeps last tick's order.
+/// \param proxies Scratch space for the intervals.
+/// \param rank Scratch space for the ranks.
+/// \return Number of overlapping pairs.
+
+static UINT Incremental(Crowd& crowd, CSweepPrune& sweep, std::vector<SweepProxy>& proxies, std::vector<UINT>& rank){
+  const UINT n = (UINT)crowd.m_vCircles.size();
+  proxies.clear();
+  rank.clear();
+
+  for(UINT i=0; i<n; i++){
+    proxies.push_back(crowd.Proxy(i));
+    rank.push_back(crowd.m_vCircles[i].m_nRank);
+  } //for
+
+  sweep.Sort(proxies, rank);
+
+  for(UINT i=0; i<n; i++)
+    crowd.m_vCircles[i].m_nRank = rank[i];
+
+  return Sweep(crowd, n, sweep.GetProxies());
+} //Incremental
+
+/// Time one way of finding pairs over all of the ticks. Moving the
+/// circles is timed separately and taken off.
+/// \param name Name to print.
+/// \param n Number of circles.
+/// \param find Finds the pairs in a crowd.
+/// \return Number of pairs over all ticks.
+
+template<class F> static UINT64 Time(const char* name, UINT n, F find){
+  Crowd crowd(n);
+  UINT64 pairs = 0;
+  std::chrono::duration<double, std::micro> us(0);
+
+  for(int tick=0; tick<TICKS; tick++){
+    crowd.Move();
+
+    const auto start = std::chrono::steady_clock::now();
+    pairs += find(crowd);
+    us += std::chrono::steady_clock::now() - start;
+  } //for
+
+  printf("%5u circles  %-11s %9.2f us per tick (%llu pairs)\n", n, name, us.count()/TICKS, (unsigned long long)pairs);
+  return pairs;
+} //Time
+
+int main(){
+  int fail = 0;
+
+  for(UINT n: {250U, 1000U, 4000U}){
+    std::vector<SweepProxy> proxies;
+    std::vector<UINT> rank;
+    CSweepPrune sweep;
+
+    const UINT64 all = Time("all pairs", n, [&](Crowd& c){return AllPairs(c);});
+    const UINT64 full = Time("full sort", n, [&](Crowd& c){return FullSort(c, proxies);});
+    const UINT64 inc = Time("incremental", n, [&](Crowd& c){return Incremental(c, sweep, proxies, rank);});
+
+    if(full != all || inc != all){
+      printf("%5u circles  pair counts differ\n", n);
+      fail = 1;
+    } //if
+  } //for
+
+  return fail;
+} //main